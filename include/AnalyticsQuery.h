@@ -27,6 +27,11 @@ struct ParseResult {
 
 ParseResult parse_and_compile(const std::string &request_json);
 
+// SQL predicate on time_expr for all_time, last_7d, last_30d, this_month or
+// last_month; empty for anything else.
+std::string time_filter_sql(const std::string &time_range,
+                            const std::string &time_expr);
+
 } // namespace analytics_query
 
 #endif // ANALYTICSQUERY_H
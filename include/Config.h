@@ -21,13 +21,34 @@ public:
   std::string diff_system_prompt;
   std::string image_description_system_prompt;
   std::string text_model;
+  // Optional small model that picks tools; empty means text_model does it.
+  std::string router_model;
+  // Optional embedding model for the message history index; empty disables it.
+  std::string embedding_model;
+  std::string embedding_index_path;
   std::string comparison_model;
   std::string vision_model;
   std::string image_description_model;
   std::string ollama_server_url;
   std::string db_connection_string;
   std::string video_summary_script_path;
+  // Drive folder holding the tracked spreadsheets. The folder listing and
+  // the changes feed only accept files from it.
+  static constexpr const char *sheet_folder_id =
+      "1HOwktdiZmm40atGPwymzrxErMi1ZrKPP";
+  // Drive v3 API root; point it at a stand-in server to test locally.
+  std::string drive_api_url;
   std::string directory_url;
+  // Column that identifies a sheet row in keyed diffs; empty means the first.
+  std::string sheet_key_column;
+  // Compressed copy of the sheet tabs, loaded at startup; empty disables it.
+  std::string sheet_snapshot_path;
+  // Append-only log of every sheet version; empty disables it.
+  std::string sheet_history_path;
+  // Public https address that forwards to drive_watch_port on loopback. Both
+  // set enables Drive push notifications; otherwise the feed is only polled.
+  std::string drive_watch_address;
+  int drive_watch_port = 0;
   std::string youtube_url;
   std::string youtube_summary_bot_id;
   std::string youtube_summary_channel_id;
@@ -52,7 +73,14 @@ public:
           std::string youtube_summary_channel_id = {},
           std::string owner_id = {},
           std::vector<std::string> allowed_channels = {"botspam"},
-          std::vector<std::string> youtube_skip_channel_names = {});
+          std::vector<std::string> youtube_skip_channel_names = {},
+          std::string router_model = {}, std::string embedding_model = {},
+          std::string embedding_index_path = "message_index.bin",
+          std::string sheet_key_column = {},
+          std::string sheet_snapshot_path = "sheet_snapshot.bin",
+          std::string drive_api_url = "https://www.googleapis.com/drive/v3",
+          std::string drive_watch_address = {}, int drive_watch_port = 0,
+          std::string sheet_history_path = "sheet_history.log");
 };
 
 #endif // BOT_CONFIG_H
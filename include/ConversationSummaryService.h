@@ -0,0 +1,37 @@
+#ifndef CONVERSATIONSUMMARYSERVICE_H
+#define CONVERSATIONSUMMARYSERVICE_H
+
+#include <Config.h>
+#include <LlmService.h>
+#include <dpp/dpp.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// Keeps a rolling summary per active channel of the messages that have left
+// the max_history window, so the prompt can carry long-range context cheaply.
+class ConversationSummaryService {
+public:
+  ConversationSummaryService(const Config &config, dpp::cluster &bot,
+                             const LlmService &llm_service);
+
+  dpp::task<void> process();
+
+private:
+  // True when the channel's backlog was folded in completely, or the
+  // attempt failed; either way it is not retried until new messages arrive.
+  dpp::task<bool> update_channel(int channel_id, std::string channel_name,
+                                 std::string summary,
+                                 std::uint64_t last_message_id);
+
+  const Config &config;
+  dpp::cluster &bot;
+  const LlmService &llm_service;
+  std::atomic<bool> running{false};
+  // Newest message of each channel when it was last summarized; channels
+  // with nothing posted since are skipped. Only touched while running.
+  std::unordered_map<int, std::uint64_t> summarized_up_to;
+};
+
+#endif // CONVERSATIONSUMMARYSERVICE_H
@@ -0,0 +1,40 @@
+#ifndef CSVPARSER_H
+#define CSVPARSER_H
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// RFC 4180 CSV parsed into one buffer. Quoted cells may hold commas, quotes
+// ("") and line breaks; records end at LF, CRLF or CR. Cells are string_views
+// into the table's own buffer, so the table is neither copyable nor movable;
+// keep it in place or behind a shared_ptr. Blank lines are skipped.
+class CsvTable {
+public:
+  explicit CsvTable(std::string text);
+  CsvTable(const CsvTable &) = delete;
+  CsvTable &operator=(const CsvTable &) = delete;
+
+  std::size_t row_count() const { return row_starts.size() - 1; }
+  std::span<const std::string_view> row(std::size_t index) const;
+  // Widest record; rows are not padded.
+  std::size_t max_columns() const { return widest; }
+
+private:
+  std::string buffer;
+  std::vector<std::string_view> cells;
+  // Index of each record's first cell, plus one past the end.
+  std::vector<std::size_t> row_starts{0};
+  std::size_t widest = 0;
+};
+
+// Cell as it must appear in a CSV record: quoted when it holds a comma,
+// quote or line break.
+std::string csv_escape(std::string_view cell);
+
+// Cells joined into one CSV record, without a line break.
+std::string csv_join(std::span<const std::string_view> cells);
+
+#endif // CSVPARSER_H
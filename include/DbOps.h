@@ -3,13 +3,19 @@
 
 #include <Domain.h>
 #include <AnalyticsQuery.h>
+#include <MessageSearch.h>
 #include <optional>
+#include <vector>
 #include <pqxx/pqxx>
 
 namespace dbops {
 
 pqxx::result fetch_channel_history(dpp::snowflake channel_id, int max_history);
 pqxx::result fetch_reactions_for_message(std::uint64_t message_id);
+pqxx::result fetch_reply_chain(dpp::snowflake message_id, int max_depth);
+std::vector<std::uint64_t> fetch_recent_message_ids(dpp::snowflake channel_id,
+                                                    int max_history);
+pqxx::result fetch_messages_by_ids(const std::vector<std::int64_t> &message_ids);
 std::optional<std::uint64_t> find_message_id(dpp::snowflake message_snowflake);
 void update_message_content(std::uint64_t message_id, const std::string &content);
 
@@ -24,6 +30,20 @@ StoredMessageIds store_message(const Message &message, dpp::guild *server,
                                dpp::channel *channel,
                                const std::string &user_name);
 
+struct ChannelSummary {
+  int channel_id;
+  std::string summary;
+  std::uint64_t last_message_id;
+};
+
+std::optional<ChannelSummary> fetch_channel_summary(dpp::snowflake channel_id);
+pqxx::result fetch_channels_needing_summary(int max_history, int min_pending);
+pqxx::result fetch_messages_for_summary(int channel_id,
+                                        std::uint64_t after_message_id,
+                                        int max_history, int limit);
+void upsert_channel_summary(int channel_id, const std::string &summary,
+                            std::uint64_t last_message_id);
+
 pqxx::result fetch_chanstats(dpp::snowflake channel_id, dpp::snowflake bot_id);
 
 std::optional<std::uint64_t>
@@ -45,6 +65,10 @@ std::string run_compiled_channel_analytics_query(
     dpp::snowflake channel_id, dpp::snowflake server_id,
     const analytics_query::CompiledQuery &compiled);
 
+std::string run_message_search(dpp::snowflake channel_id,
+                               dpp::snowflake server_id,
+                               const message_search::CompiledSearch &compiled);
+
 } // namespace dbops
 
 #endif // DBOPS_H
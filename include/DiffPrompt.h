@@ -0,0 +1,27 @@
+#ifndef DIFFPROMPT_H
+#define DIFFPROMPT_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct SheetDiff {
+  std::string sheet_name;
+  std::string header;
+  std::string diff;
+};
+
+// Summarization prompts for the changed tabs of one file: as many tabs per
+// prompt as fit in max_bytes, in order, so a bulk edit is summarized in one
+// request. A tab whose diff alone exceeds the budget gets its own prompt
+// with the diff cut short.
+std::vector<std::string> build_diff_prompts(const std::string &filename,
+                                            const std::vector<SheetDiff> &diffs,
+                                            std::size_t max_bytes);
+
+// Text cut into Discord-sized messages, at line breaks where possible and
+// never inside a UTF-8 sequence.
+std::vector<std::string> split_message(const std::string &text,
+                                       std::size_t max_bytes = 2000);
+
+#endif // DIFFPROMPT_H
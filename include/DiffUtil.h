@@ -1,11 +1,34 @@
 #ifndef DIFFUTIL_H
 #define DIFFUTIL_H
 
+#include <cstddef>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
+// Columns become rows. Records are padded to the widest one and quoted cells
+// stay intact.
 std::string transpose_csv(const std::string &raw);
 
+// Unified diff of two CSV exports with the data rows sorted, so reordering
+// alone is not a change. Empty when the sheets match.
 std::string diff_csv(const std::string &olddata, const std::string &newdata,
-                     int sheet_id, bool transpose = false);
+                     bool transpose = false);
+
+// Cell-level diff that matches data rows by key_column (the first column
+// when empty or missing) and lists "row key / column / old → new" changes,
+// then added and removed rows. Empty when nothing changed; nullopt when the
+// keys are not unique, so the caller can fall back to diff_csv.
+std::optional<std::string> keyed_diff_csv(const std::string &olddata,
+                                          const std::string &newdata,
+                                          const std::string &key_column = {},
+                                          bool transpose = false);
+
+// Line diff in diff -u format (--- old / +++ new headers, @@ hunks with the
+// given lines of context). Empty when the inputs are equal.
+std::string unified_diff(const std::vector<std::string_view> &old_lines,
+                         const std::vector<std::string_view> &new_lines,
+                         std::size_t context = 3);
 
 #endif // DIFFUTIL_H
@@ -3,11 +3,16 @@
 
 #include <Config.h>
 #include <Domain.h>
+#include <IntentMatcher.h>
 #include <LlmService.h>
+#include <ToolRegistry.h>
 #include <dpp/dpp.h>
+#include <atomic>
 #include <chrono>
 #include <deque>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -17,6 +22,9 @@ class WebPageService;
 class YoutubeService;
 class VideoSummaryService;
 class CalculationService;
+class ToolResultCache;
+class SnowflakeAliases;
+class MessageIndexService;
 
 class DiscordEventService {
 public:
@@ -26,7 +34,9 @@ public:
                       const WebPageService &web_page_service,
                       const YoutubeService &youtube_service,
                       const VideoSummaryService &video_summary_service,
-                      const CalculationService &calculation_service);
+                      const CalculationService &calculation_service,
+                      ToolResultCache &tool_result_cache,
+                      MessageIndexService &message_index);
 
   dpp::task<void> handle_message(const dpp::message_create_t &event);
   dpp::task<void> handle_message_update(const dpp::message_update_t &event);
@@ -35,12 +45,57 @@ public:
   dpp::task<void> remove_reaction(const dpp::message_reaction_remove_t &event);
 
 private:
-  std::string format_message_history(dpp::snowflake channel_id) const;
-  std::string format_replyto_message(const Message &msg) const;
+  std::string format_message_history(dpp::snowflake channel_id,
+                                     SnowflakeAliases &aliases) const;
+  std::string format_replyto_message(const Message &msg,
+                                     SnowflakeAliases &aliases) const;
+  std::string format_reply_thread(const Message &msg,
+                                  SnowflakeAliases &aliases) const;
   void store_message(const Message &message, dpp::guild *server,
                      dpp::channel *channel, const std::string &user_name) const;
   dpp::task<void> handle_carlbot_video(const dpp::message_create_t &event);
   dpp::task<void> run_summary_queue(dpp::snowflake channel_id);
+  void invalidate_analytics_cache(dpp::snowflake server_id) const;
+
+  void register_tools();
+  dpp::task<std::optional<std::string>>
+  try_intent_fast_path(const ToolRequestContext &request_context,
+                       const std::string &content,
+                       const std::string &prompt) const;
+  void start_tool_prefetch(ToolRequestContext &context,
+                           const std::string &content) const;
+  dpp::task<std::string> run_prefetch(std::string tool_name,
+                                      std::string arguments_json,
+                                      dpp::snowflake channel_id,
+                                      dpp::snowflake server_id,
+                                      std::shared_ptr<std::atomic<int>>
+                                          heavy_tools_running) const;
+  dpp::task<std::string> execute_chat_tool(ToolRequestContext &context,
+                                           const std::string &tool_name,
+                                           const std::string &raw_arguments_json) const;
+  dpp::task<std::string> run_webpage_tool(ToolRequestContext &context,
+                                          const std::string &arguments_json) const;
+  dpp::task<std::string> run_video_tool(ToolRequestContext &context,
+                                        const std::string &arguments_json,
+                                        bool exclusive) const;
+  dpp::task<std::string>
+  run_calculation_tool(const std::string &arguments_json) const;
+  dpp::task<std::string> run_analytics_tool(ToolRequestContext &context,
+                                            const std::string &arguments_json) const;
+  dpp::task<std::string> run_stream_status_tool() const;
+  dpp::task<std::string>
+  run_message_search_tool(ToolRequestContext &context,
+                          const std::string &arguments_json) const;
+  dpp::task<std::string>
+  run_history_search_tool(ToolRequestContext &context,
+                          const std::string &arguments_json) const;
+  dpp::task<std::string> run_sheet_query_tool(const std::string &arguments_json) const;
+  dpp::task<std::string>
+  run_vehicle_lookup_tool(const std::string &arguments_json) const;
+  dpp::task<std::string>
+  run_sheet_history_tool(const std::string &arguments_json) const;
+  dpp::task<std::string> run_sheet_tool(const std::string &tab_name,
+                                        bool transpose) const;
 
   const Config &config;
   dpp::cluster &bot;
@@ -50,9 +105,14 @@ private:
   const YoutubeService &youtube_service;
   const VideoSummaryService &video_summary_service;
   const CalculationService &calculation_service;
+  ToolResultCache &tool_result_cache;
+  MessageIndexService &message_index;
+  ToolRegistry chat_tools;
+  ToolRegistry summary_tools;
+  IntentMatcher intent_matcher = IntentMatcher::with_default_rules();
   bool is_rate_limited(dpp::snowflake user_id) const;
 
-  mutable std::mutex heavy_tool_mutex;
+  mutable std::atomic<bool> heavy_tool_running{false};
   mutable std::mutex rate_limit_mutex;
   std::mutex summary_queue_mutex;
   std::deque<std::string> summary_queue;
@@ -22,9 +22,4 @@ struct Diffdata {
   std::string sheet_name;
 };
 
-struct SheetTabMetadata {
-  std::string sheet_name;
-  std::string header;
-};
-
 #endif // DOMAIN_H
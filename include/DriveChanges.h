@@ -0,0 +1,118 @@
+#ifndef DRIVECHANGES_H
+#define DRIVECHANGES_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Requests and responses of the Drive v3 changes feed. api_url is the API
+// root, e.g. "https://www.googleapis.com/drive/v3", so tests and local runs
+// can point it at a stand-in server.
+namespace drive_changes {
+
+struct DriveFile {
+  std::string id;
+  std::string name;
+  // RFC 3339, as Drive reports it.
+  std::string modified_time;
+  std::string web_view_link;
+  // Ids of the folders holding the file.
+  std::vector<std::string> parents;
+};
+
+struct ChangesPage {
+  // Files that changed and still exist, in feed order.
+  std::vector<DriveFile> files;
+  // Set while more pages follow.
+  std::string next_page_token;
+  // Set on the last page: the token to poll with next time.
+  std::string new_start_page_token;
+};
+
+std::string start_page_token_url(const std::string &api_url,
+                                 const std::string &api_key);
+std::string changes_url(const std::string &api_url,
+                        const std::string &page_token,
+                        const std::string &api_key);
+std::string watch_url(const std::string &api_url, const std::string &page_token,
+                      const std::string &api_key);
+
+// Body of a changes.watch request for a web_hook channel. Drive echoes token
+// in the X-Goog-Channel-Token header of every notification.
+std::string watch_request_body(const std::string &channel_id,
+                               const std::string &address,
+                               const std::string &token,
+                               std::int64_t expiration_ms);
+
+// nullopt when the body is not the expected JSON.
+std::optional<std::string> parse_start_page_token(const std::string &body);
+std::optional<ChangesPage> parse_changes_page(const std::string &body);
+std::optional<std::vector<DriveFile>> parse_file_list(const std::string &body);
+// Channel expiry in ms since the epoch.
+std::optional<std::int64_t> parse_watch_expiration(const std::string &body);
+
+// A file edited several times between polls appears once per edit; keeps
+// only its last entry, in feed order.
+std::vector<DriveFile> latest_per_file(std::vector<DriveFile> files);
+
+std::string url_encode(const std::string &value);
+
+// Drive refused the credentials; retrying with the same key cannot succeed.
+bool is_auth_failure(int status);
+
+// One poll of the changes feed, paging from a token until the feed ends. It
+// names the next request and is fed the responses, so the refresh (with
+// async requests) and the tests run the same loop.
+class ChangesPoll {
+public:
+  enum class Step { Next, Done, Failed };
+
+  // The feed covers everything the key can see in Drive; only files directly
+  // in folder_id are kept.
+  ChangesPoll(std::string api_url, std::string page_token, std::string api_key,
+              std::string folder_id, int max_pages = 50);
+
+  // The request to make while step() is Next.
+  std::string url() const;
+  Step feed(int status, const std::string &body);
+  Step step() const { return current; }
+
+  // Once Done: changed files of the folder, the latest entry of each.
+  const std::vector<DriveFile> &files() const { return changed; }
+  // Token to poll with next time; empty after a failure, so the caller lists
+  // the folder and starts over.
+  const std::string &next_page_token() const { return next_token; }
+  // Failed on 401/403: the key may not use the feed at all.
+  bool denied() const { return denied_; }
+  int last_status() const { return status; }
+
+private:
+  std::string api_url;
+  std::string api_key;
+  std::string folder_id;
+  int max_pages;
+  int pages = 0;
+  int status = 0;
+  bool denied_ = false;
+  Step current = Step::Next;
+  std::string request_token;
+  std::string next_token;
+  std::vector<DriveFile> changed;
+};
+
+// Runs poll to the end with fetch(url) -> std::pair<int, std::string> of
+// status and body.
+template <typename Fetch>
+ChangesPoll::Step run_poll(ChangesPoll &poll, Fetch fetch) {
+  while (poll.step() == ChangesPoll::Step::Next) {
+    const auto [status, body] = fetch(poll.url());
+    poll.feed(status, body);
+  }
+  return poll.step();
+}
+
+} // namespace drive_changes
+
+#endif // DRIVECHANGES_H
@@ -0,0 +1,42 @@
+#ifndef DRIVEWEBHOOKSERVER_H
+#define DRIVEWEBHOOKSERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+// Minimal HTTP listener for Drive push notifications (changes.watch). It
+// binds to loopback; a TLS reverse proxy forwards the public https address
+// Drive requires. Every POST carrying the channel token is acknowledged and
+// reported with its X-Goog-Resource-State ("sync" when the channel opens,
+// "change" afterwards); anything else is rejected.
+class DriveWebhookServer {
+public:
+  using Callback = std::function<void(const std::string &resource_state)>;
+
+  DriveWebhookServer(std::string channel_token, Callback on_notification);
+  ~DriveWebhookServer();
+  DriveWebhookServer(const DriveWebhookServer &) = delete;
+  DriveWebhookServer &operator=(const DriveWebhookServer &) = delete;
+
+  // Port 0 picks a free port; see port(). False if the socket cannot bind.
+  bool start(std::uint16_t port);
+  void stop();
+  std::uint16_t port() const { return bound_port; }
+
+private:
+  void serve();
+  // Answers one complete request (or max_request_bytes of one).
+  void handle(int client, const std::string &request);
+
+  std::string channel_token;
+  Callback on_notification;
+  int listen_fd = -1;
+  std::uint16_t bound_port = 0;
+  std::atomic<bool> stopping{false};
+  std::thread thread;
+};
+
+#endif // DRIVEWEBHOOKSERVER_H
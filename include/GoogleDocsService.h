@@ -3,37 +3,110 @@
 
 #include <Config.h>
 #include <Domain.h>
+#include <DriveChanges.h>
 #include <LlmService.h>
+#include <SheetHistory.h>
+#include <SheetStore.h>
+#include <VehicleIndex.h>
+#include <atomic>
 #include <chrono>
 #include <dpp/dpp.h>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <vector>
+
+class DriveWebhookServer;
+class ToolResultCache;
 
 class GoogleDocsService {
 public:
   GoogleDocsService(const Config &config, dpp::cluster &bot,
-                    const LlmService &llm_service);
+                    const LlmService &llm_service,
+                    ToolResultCache &tool_result_cache);
+  ~GoogleDocsService();
 
-  std::optional<std::string>
+  // Shared CSV payload of a tab; null when the tab is not loaded.
+  std::shared_ptr<const std::string>
   get_sheet_csv_by_tab_name(const std::string &sheet_name,
                             bool transpose = false) const;
+  // Parsed tab for in-process queries; null when not loaded.
+  std::shared_ptr<const SheetTab> find_sheet(const std::string &sheet_name) const;
+  // Rows for a vehicle from every tab, as one compact record.
+  std::string lookup_vehicle(const std::string &query) const;
+  // Past versions of a tab from the history log: the version list without
+  // dates, the tab as of the end of day `to`, or the changes from the start
+  // of day `from` to the end of day `to` (or now). Reads the log, so call it
+  // off the event loop. Empty when the tab has no recorded history.
+  std::string sheet_history(const std::string &sheet_name,
+                            std::optional<SheetHistory::TimePoint> from,
+                            std::optional<SheetHistory::TimePoint> to) const;
   dpp::task<void> process_google_docs();
+  // True when Drive push notifications are being received.
+  bool watch_enabled() const { return webhook_server != nullptr; }
+  // Refreshes if a push notification arrived since the last call.
+  dpp::task<void> process_notifications();
 
 private:
-  dpp::task<void> process_sheets(const std::string filename,
-                                 const std::string file_id,
-                                 std::string weblink);
+  struct FetchedTab {
+    int sheet_id;
+    std::string sheet_name;
+    std::string csv;
+  };
+
+  // False when the tab listing or any tab export failed.
+  dpp::task<bool>
+  process_sheets(const std::string filename, const std::string file_id,
+                 std::string weblink,
+                 std::chrono::sys_time<std::chrono::milliseconds> modified);
+  // CSV export of one tab, following redirects; nullopt on failure.
+  dpp::task<std::optional<std::string>> fetch_tab_csv(std::string file_id,
+                                                      int sheet_id);
   dpp::task<void> process_diffs();
+  // Files changed since the last poll according to the changes feed;
+  // nullopt when the feed failed and the folder has to be listed instead.
+  dpp::task<std::optional<std::vector<drive_changes::DriveFile>>>
+  fetch_changed_files();
+  // Every file in the folder; also starts the changes feed.
+  dpp::task<std::optional<std::vector<drive_changes::DriveFile>>>
+  fetch_directory();
+  // Opens a new push channel when the current one is about to expire.
+  dpp::task<void> renew_watch();
+  // Restores tabs and timestamps saved by an earlier run, if any.
+  void load_snapshot();
+  dpp::task<void> save_snapshot();
+  // Appends the stored tabs to the history log, off the event loop.
+  dpp::task<void>
+  record_history(std::vector<std::shared_ptr<const SheetTab>> previous,
+                 std::vector<std::shared_ptr<const SheetTab>> stored,
+                 SheetHistory::TimePoint modified);
+  void index_vehicles(const std::shared_ptr<const SheetTab> &tab);
 
   const Config &config;
   dpp::cluster &bot;
   const LlmService &llm_service;
+  ToolResultCache &tool_result_cache;
+  std::atomic<bool> running{false};
 
+  SheetStore sheet_store;
+  VehicleIndex vehicle_index;
+  // Null when sheet_history_path is empty or the log cannot be read.
+  std::unique_ptr<SheetHistory> history;
+  // Guards sheet_diffs; files are processed concurrently.
+  std::mutex sheet_mutex;
   std::map<std::string, std::chrono::sys_time<std::chrono::milliseconds>>
       timestamps;
-  std::map<std::string, std::map<int, std::string>> sheet_data;
-  std::map<std::string, std::map<int, SheetTabMetadata>> sheet_metadata;
   std::map<std::string, std::map<int, Diffdata>> sheet_diffs;
+  // Changes feed position; only used while running is held.
+  std::string page_token;
+  // Set when Drive refused the changes feed; only the folder is polled.
+  bool changes_feed_denied = false;
+
+  std::unique_ptr<DriveWebhookServer> webhook_server;
+  std::string watch_token;
+  std::atomic<bool> change_notified{false};
+  std::chrono::system_clock::time_point next_watch_renewal{};
 };
 
 #endif // GOOGLEDOCSSERVICE_H
@@ -0,0 +1,50 @@
+#ifndef INTENTMATCHER_H
+#define INTENTMATCHER_H
+
+#include <functional>
+#include <optional>
+#include <regex>
+#include <string>
+#include <vector>
+
+// Maps high-confidence chat messages straight to a tool call, so the LLM is
+// only needed to phrase the result. Anything that does not fully match a
+// rule returns nullopt and goes through the normal tool loop.
+class IntentMatcher {
+public:
+  struct Match {
+    std::string rule;
+    std::string tool_name;
+    std::string arguments_json;
+  };
+
+  // Builds the tool arguments from the regex captures, or nullopt to reject
+  // the match after all.
+  using ArgumentBuilder =
+      std::function<std::optional<std::string>(const std::smatch &)>;
+
+  void add_rule(std::string name, const std::string &pattern,
+                std::string tool_name, ArgumentBuilder build_arguments);
+
+  std::optional<Match> match(const std::string &message) const;
+
+  std::size_t size() const { return rules.size(); }
+
+  // Stream status, reaction/poster leaderboards and plain arithmetic.
+  static IntentMatcher with_default_rules();
+
+  // Strips mentions, lowercases ASCII and collapses whitespace.
+  static std::string normalize(const std::string &message);
+
+private:
+  struct Rule {
+    std::string name;
+    std::regex pattern;
+    std::string tool_name;
+    ArgumentBuilder build_arguments;
+  };
+
+  std::vector<Rule> rules;
+};
+
+#endif // INTENTMATCHER_H
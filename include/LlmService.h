@@ -8,9 +8,16 @@
 #include <string>
 #include <vector>
 
+class ToolRegistry;
+
 class LlmService {
 public:
-  enum class GenerationType { TextReply, Diff, ImageDescription };
+  enum class GenerationType {
+    TextReply,
+    Diff,
+    ImageDescription,
+    ConversationSummary
+  };
 
   struct ToolDefinition {
     std::string name;
@@ -27,11 +34,21 @@ public:
   dpp::task<std::string>
   generate_text_with_tools(const std::string &prompt,
                            const ollama::images &imagelist,
-                           const std::vector<ToolDefinition> &available_tools,
+                           const ToolRegistry &available_tools,
                            const std::function<dpp::task<std::string>(
                                const std::string &, const std::string &)>
                                &tool_executor) const;
 
+  // One call, no tools: phrase an answer from a tool result that was
+  // obtained without asking the model. Empty on failure.
+  std::string generate_text_from_tool_result(const std::string &prompt,
+                                             const std::string &tool_name,
+                                             const std::string &arguments_json,
+                                             const std::string &tool_output) const;
+
+  // Blocking; empty when no embedding model is configured or the call fails.
+  std::vector<float> generate_embedding(const std::string &text) const;
+
   dpp::task<ollama::images>
   generate_images(std::vector<dpp::attachment> attachments) const;
 
@@ -0,0 +1,59 @@
+#ifndef MESSAGEINDEXSERVICE_H
+#define MESSAGEINDEXSERVICE_H
+
+#include <Config.h>
+#include <LlmService.h>
+#include <VectorIndex.h>
+#include <dpp/dpp.h>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Embeds stored messages in the background and answers similarity queries
+// over them. Disabled when no embedding model is configured.
+class MessageIndexService {
+public:
+  MessageIndexService(const Config &config, dpp::cluster &bot,
+                      const LlmService &llm_service);
+  // Writes vectors added since the last periodic save.
+  ~MessageIndexService();
+
+  bool enabled() const { return !config.embedding_model.empty(); }
+
+  void enqueue(std::uint64_t message_id, dpp::snowflake server_id,
+               dpp::snowflake channel_id, std::string text);
+
+  // Timer entry point: embeds a batch of queued messages; the index is
+  // written every few minutes while it has unsaved vectors.
+  dpp::task<void> process();
+
+  dpp::task<std::vector<VectorIndex::Hit>>
+  search(std::string query, dpp::snowflake server_id,
+         std::vector<std::uint64_t> exclude_ids, std::size_t limit) const;
+
+private:
+  struct PendingMessage {
+    std::uint64_t message_id;
+    std::uint64_t server_id;
+    std::uint64_t channel_id;
+    std::string text;
+  };
+
+  const Config &config;
+  dpp::cluster &bot;
+  const LlmService &llm_service;
+  VectorIndex index;
+  std::mutex queue_mutex;
+  std::deque<PendingMessage> queue;
+  std::atomic<bool> running{false};
+  // Only touched while running is held, and by the destructor.
+  std::size_t unsaved = 0;
+  std::chrono::steady_clock::time_point last_save;
+};
+
+#endif // MESSAGEINDEXSERVICE_H
@@ -0,0 +1,36 @@
+#ifndef MESSAGESEARCH_H
+#define MESSAGESEARCH_H
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace message_search {
+
+// Bind parameter $1 is the channel or server snowflake, the rest follow
+// bind_params in order.
+struct CompiledSearch {
+  std::string sql;
+  std::vector<std::string> bind_params;
+  int limit{8};
+  std::string scope;
+  std::string query;
+  std::string sort;
+  std::string time_range;
+};
+
+struct ParseResult {
+  std::optional<CompiledSearch> search;
+  std::string error;
+
+  [[nodiscard]] bool ok() const { return search.has_value(); }
+};
+
+ParseResult parse_and_compile(const std::string &request_json);
+
+// Escapes %, _ and \ so text can be embedded in an ILIKE pattern.
+std::string escape_like(const std::string &text);
+
+} // namespace message_search
+
+#endif // MESSAGESEARCH_H
@@ -16,6 +16,9 @@ class YoutubeService;
 class WebPageService;
 class VideoSummaryService;
 class CalculationService;
+class ToolResultCache;
+class ConversationSummaryService;
+class MessageIndexService;
 
 class Nissefar {
 private:
@@ -30,6 +33,9 @@ private:
   std::unique_ptr<WebPageService> web_page_service;
   std::unique_ptr<VideoSummaryService> video_summary_service;
   std::unique_ptr<CalculationService> calculation_service;
+  std::unique_ptr<ToolResultCache> tool_result_cache;
+  std::unique_ptr<ConversationSummaryService> conversation_summary_service;
+  std::unique_ptr<MessageIndexService> message_index_service;
 
   // Methods
 
@@ -2,6 +2,8 @@
 #define OLLAMA_TOOL_CALLING_H
 
 #include <ollama.hpp>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <utility>
 #include <vector>
@@ -47,32 +49,117 @@ inline ollama::response chat(Ollama &client, const std::string &model,
   return client.chat(request);
 }
 
-inline bool has_tool_calls(const ollama::response &response) {
-  const auto &payload = response.as_json();
-  return payload.contains("message") && payload["message"].is_object() &&
-         payload["message"].contains("tool_calls") &&
-         payload["message"]["tool_calls"].is_array() &&
-         !payload["message"]["tool_calls"].empty();
-}
+// Read-only view over one chat/generate response. Content, tool calls and
+// eval counters are read in place from the response's parsed JSON, which is
+// never copied; the response must outlive the view.
+class ResponseView {
+public:
+  explicit ResponseView(const ollama::response &response)
+      : payload(&response.as_json()) {}
+  explicit ResponseView(const ollama::json &payload) : payload(&payload) {}
+  ResponseView(ollama::response &&) = delete;
+  ResponseView(ollama::json &&) = delete;
 
-inline ollama::json tool_calls(const ollama::response &response) {
-  if (!has_tool_calls(response))
-    return ollama::json::array();
-  return response.as_json()["message"]["tool_calls"];
-}
+  const ollama::json &json() const { return *payload; }
 
-inline ollama::message assistant_message(const ollama::response &response) {
-  ollama::message message;
-  const auto &payload = response.as_json();
-  if (!payload.contains("message") || !payload["message"].is_object())
-    return message;
+  const ollama::json *message() const {
+    const auto it = payload->find("message");
+    if (it == payload->end() || !it->is_object())
+      return nullptr;
+    return &*it;
+  }
 
-  const auto &server_message = payload["message"];
-  for (auto it = server_message.begin(); it != server_message.end(); ++it)
-    message[it.key()] = it.value();
+  const ollama::json &tool_calls() const {
+    static const ollama::json empty = ollama::json::array();
+    const ollama::json *server_message = message();
+    if (server_message == nullptr)
+      return empty;
+    const auto it = server_message->find("tool_calls");
+    if (it == server_message->end() || !it->is_array())
+      return empty;
+    return *it;
+  }
 
-  return message;
-}
+  bool has_tool_calls() const { return !tool_calls().empty(); }
+
+  // message.content, or nullptr when the message or its content is missing.
+  const ollama::json *content() const {
+    const ollama::json *server_message = message();
+    if (server_message == nullptr)
+      return nullptr;
+    const auto it = server_message->find("content");
+    if (it == server_message->end())
+      return nullptr;
+    return &*it;
+  }
+
+  std::size_t content_length() const {
+    const ollama::json *value = content();
+    if (value == nullptr || value->is_null())
+      return 0;
+    if (value->is_string())
+      return value->get_ref<const std::string &>().size();
+    return value->dump().size();
+  }
+
+  // Assistant text for chat responses, the generate endpoint's "response"
+  // field otherwise, and the raw payload as a last resort.
+  std::string text() const {
+    if (const ollama::json *value = content(); value != nullptr) {
+      if (value->is_string())
+        return value->get<std::string>();
+      if (!value->is_null())
+        return value->dump();
+    }
+
+    const auto it = payload->find("response");
+    if (it != payload->end() && it->is_string())
+      return it->get<std::string>();
+
+    return payload->dump();
+  }
+
+  std::string shape() const {
+    const ollama::json *server_message = message();
+    if (server_message == nullptr)
+      return "missing message object";
+    const ollama::json *value = content();
+    if (value == nullptr)
+      return "message without content";
+    return std::string("message.content type=") + value->type_name();
+  }
+
+  std::int64_t prompt_eval_count() const { return integer_field("prompt_eval_count"); }
+  std::int64_t eval_count() const { return integer_field("eval_count"); }
+
+  // JSON text of a top-level field, or "n/a" when absent.
+  std::string field_dump(const char *key) const {
+    const auto it = payload->find(key);
+    if (it == payload->end())
+      return "n/a";
+    return it->dump();
+  }
+
+  ollama::message assistant_message() const {
+    ollama::message result;
+    const ollama::json *server_message = message();
+    if (server_message == nullptr)
+      return result;
+    for (auto it = server_message->begin(); it != server_message->end(); ++it)
+      result[it.key()] = it.value();
+    return result;
+  }
+
+private:
+  std::int64_t integer_field(const char *key) const {
+    const auto it = payload->find(key);
+    if (it == payload->end() || !it->is_number_integer())
+      return 0;
+    return it->get<std::int64_t>();
+  }
+
+  const ollama::json *payload;
+};
 
 inline ollama::message tool_result_message(const std::string &tool_name,
                                            const std::string &content) {
@@ -0,0 +1,15 @@
+#ifndef ROWHASH_H
+#define ROWHASH_H
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+// XXH64 of data; matches the reference xxHash implementation.
+std::uint64_t xxhash64(std::string_view data, std::uint64_t seed = 0);
+
+// Hash of a CSV record. Each cell is hashed with the previous cell's hash as
+// seed, so moving text between neighbouring cells changes the hash.
+std::uint64_t hash_row(std::span<const std::string_view> cells);
+
+#endif // ROWHASH_H
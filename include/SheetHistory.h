@@ -0,0 +1,101 @@
+#ifndef SHEETHISTORY_H
+#define SHEETHISTORY_H
+
+#include <SheetStore.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Append-only log of every stored version of every sheet tab. A version is
+// kept as the rows that changed since the previous one, with a full
+// checkpoint every checkpoint_interval versions of a tab, so rebuilding any
+// version reads one checkpoint and at most checkpoint_interval - 1 deltas.
+// Versions whose unchanged rows moved are checkpoints too. Record headers are
+// uncompressed; opening the log reads only those, and a rebuilt version is
+// checked against the hash in its header.
+class SheetHistory {
+public:
+  using TimePoint = std::chrono::sys_time<std::chrono::milliseconds>;
+
+  struct Version {
+    TimePoint time;
+    // Header and rows padded to the header width, one record per line.
+    std::string csv;
+  };
+
+  struct VersionInfo {
+    TimePoint time;
+    bool checkpoint;
+  };
+
+  struct Stats {
+    std::size_t tabs = 0;
+    std::size_t checkpoints = 0;
+    std::size_t deltas = 0;
+    std::uint64_t file_bytes = 0;
+    // What keeping every version as a full export would take.
+    std::uint64_t full_copy_bytes = 0;
+  };
+
+  explicit SheetHistory(std::string path, std::size_t checkpoint_interval = 16);
+
+  // Indexes an existing log; a record cut off by a crash is dropped.
+  // False when the file exists but cannot be read.
+  bool open();
+
+  // Appends current as the next version of its tab. previous is the tab it
+  // replaces; without it, or when it is not the last recorded version, a
+  // checkpoint is written. A tab equal to its last recorded version is not
+  // appended again. Times going backwards are clamped.
+  bool record(const SheetTab *previous, const SheetTab &current,
+              TimePoint time);
+
+  // The tab as it was at time; nullopt before its first version or when the
+  // log cannot reproduce it.
+  std::optional<Version> version_at(std::string_view sheet_name,
+                                    TimePoint time) const;
+  std::optional<Version> first_version(std::string_view sheet_name) const;
+  std::vector<VersionInfo> versions(std::string_view sheet_name) const;
+
+  Stats stats() const;
+
+private:
+  struct Entry {
+    TimePoint time;
+    std::uint64_t offset;
+    bool checkpoint;
+  };
+
+  struct TabLog {
+    std::string sheet_name;
+    std::vector<Entry> entries;
+    std::size_t since_checkpoint = 0;
+    // xxhash64 of the last version as rebuilt (Version::csv).
+    std::uint64_t last_csv_hash = 0;
+  };
+
+  using TabKey = std::pair<std::string, int>;
+
+  const TabLog *find_log(std::string_view sheet_name) const;
+  std::optional<Version> rebuild(const TabLog &log, std::size_t index) const;
+
+  std::string path;
+  std::size_t checkpoint_interval;
+  mutable std::mutex mutex;
+  std::map<TabKey, TabLog> logs;
+  std::uint64_t file_bytes = 0;
+  std::uint64_t full_copy_bytes = 0;
+};
+
+// "2026-03-01" as midnight UTC; nullopt for anything else.
+std::optional<SheetHistory::TimePoint> parse_history_date(std::string_view text);
+
+#endif // SHEETHISTORY_H
@@ -0,0 +1,56 @@
+#ifndef SHEETQUERY_H
+#define SHEETQUERY_H
+
+#include <SheetStore.h>
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace sheet_query {
+
+// op is one of eq, ne, contains, lt, le, gt, ge. Text comparisons ignore
+// case; lt/le/gt/ge and eq/ne on two numbers compare numerically.
+struct Filter {
+  std::string column;
+  std::string op;
+  std::string value;
+};
+
+struct Query {
+  std::string sheet;
+  // Projection; empty means every column. The key (first) column is always
+  // kept so rows stay identifiable.
+  std::vector<std::string> columns;
+  // All filters must match.
+  std::vector<Filter> filters;
+  std::string sort_by;
+  bool descending{false};
+  int limit{10};
+};
+
+struct ParseResult {
+  std::optional<Query> query;
+  std::string error;
+
+  [[nodiscard]] bool ok() const { return query.has_value(); }
+};
+
+ParseResult parse(const std::string &request_json);
+
+struct QueryResult {
+  std::string output;
+  // Set instead of output when a column does not exist.
+  std::string error;
+  std::size_t matched_rows{0};
+  std::size_t returned_rows{0};
+};
+
+// Matching rows as CSV with a one-line summary, cut off at max_output_bytes.
+QueryResult run(const SheetTab &tab, const Query &query,
+                std::size_t max_output_bytes = 4000);
+
+} // namespace sheet_query
+
+#endif // SHEETQUERY_H
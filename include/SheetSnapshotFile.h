@@ -0,0 +1,37 @@
+#ifndef SHEETSNAPSHOTFILE_H
+#define SHEETSNAPSHOTFILE_H
+
+#include <SheetStore.h>
+
+#include <chrono>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Sheet state saved after a refresh: the raw export of every tab and the
+// modification time of every file, so a restart can serve the tabs at once
+// and diff changes made while the bot was down against them. The changes
+// feed token is kept too, so the feed resumes where it stopped.
+struct PersistedSheets {
+  std::map<std::string, std::chrono::sys_time<std::chrono::milliseconds>>
+      timestamps;
+  std::vector<SheetStore::TabUpdate> tabs;
+  // Drive changes feed position; empty when the feed was not in use.
+  std::string page_token;
+};
+
+// zlib-compressed and checksummed, written to a temporary file and renamed
+// into place so a crash never leaves a truncated snapshot behind.
+bool save_sheet_snapshot(const std::string &path,
+                         const SheetStore::Snapshot &snapshot,
+                         const std::map<std::string,
+                                        std::chrono::sys_time<
+                                            std::chrono::milliseconds>>
+                             &timestamps,
+                         const std::string &page_token = {});
+
+// nullopt when the file is missing, truncated or fails its checksum.
+std::optional<PersistedSheets> load_sheet_snapshot(const std::string &path);
+
+#endif // SHEETSNAPSHOTFILE_H
@@ -0,0 +1,144 @@
+#ifndef SHEETSTORE_H
+#define SHEETSTORE_H
+
+#include <CsvParser.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Cell text as a number: surrounding spaces are ignored and a decimal comma
+// is accepted ("12,5"). nullopt for anything else, including empty cells.
+std::optional<double> parse_sheet_number(std::string_view text);
+
+// One sheet tab, parsed once when it is stored. The CSV views are shared so
+// tool calls hand out the same buffer instead of copying or re-transposing.
+struct SheetTab {
+  enum class ColumnType { Text, Number };
+
+  std::string file_name;
+  int sheet_id = 0;
+  std::string name;
+  // Owns the cell text that header and rows point into.
+  std::shared_ptr<const CsvTable> table;
+  std::vector<std::string_view> header;
+  // Data rows, each padded to the header width.
+  std::vector<std::vector<std::string_view>> rows;
+  // Number when every non-empty cell in the column parses as a number.
+  std::vector<ColumnType> column_types;
+  std::shared_ptr<const std::string> csv;
+  std::shared_ptr<const std::string> transposed_csv;
+  // hash_row of the header and of each data row (as padded), so a refresh
+  // can find the rows that changed without comparing text.
+  std::uint64_t header_hash = 0;
+  std::vector<std::uint64_t> row_hashes;
+
+  // Index of the named column, or -1.
+  int column_index(std::string_view column) const;
+};
+
+// Rows of two versions of a tab that have no equal row in the other, matched
+// one for one by hash so duplicated rows are counted. Both lists are empty
+// when the rows were only reordered. Linear in the number of rows.
+struct RowChanges {
+  bool header_changed = false;
+  // Indices into old_tab.rows and new_tab.rows, ascending.
+  std::vector<std::size_t> removed;
+  std::vector<std::size_t> added;
+
+  bool empty() const {
+    return !header_changed && removed.empty() && added.empty();
+  }
+};
+
+RowChanges changed_rows(const SheetTab &old_tab, const SheetTab &new_tab);
+
+// Header and the given rows of tab as CSV.
+std::string rows_csv(const SheetTab &tab, const std::vector<std::size_t> &rows);
+
+// Latest export of every tab, indexed by tab name and by (file, sheet id).
+// State is published as immutable snapshots through an atomic shared
+// pointer: readers load the current snapshot and never wait for a refresh,
+// and a refresh swaps in a whole new snapshot at once.
+class SheetStore {
+public:
+  struct TabUpdate {
+    std::string file_name;
+    int sheet_id = 0;
+    std::string sheet_name;
+    std::string csv;
+  };
+
+  struct Snapshot {
+    std::map<std::pair<std::string, int>, std::shared_ptr<const SheetTab>> tabs;
+    std::unordered_map<std::string, std::shared_ptr<const SheetTab>> by_name;
+    // Bumped on every publish.
+    std::uint64_t version = 0;
+
+    // When two files have a tab of the same name, the file that sorts first
+    // wins, as the old linear scan did.
+    std::shared_ptr<const SheetTab> find(std::string_view sheet_name) const;
+    std::shared_ptr<const SheetTab> find(const std::string &file_name,
+                                         int sheet_id) const;
+  };
+
+  struct FileUpdate {
+    // In the order of the updates.
+    std::vector<std::shared_ptr<const SheetTab>> stored;
+    std::vector<std::shared_ptr<const SheetTab>> removed;
+  };
+
+  SheetStore();
+
+  // Parses every update and publishes them together as one snapshot; returns
+  // the stored tabs in the same order.
+  std::vector<std::shared_ptr<const SheetTab>>
+  update(std::vector<TabUpdate> updates);
+  std::shared_ptr<const SheetTab> update(const std::string &file_name,
+                                         int sheet_id,
+                                         const std::string &sheet_name,
+                                         std::string csv);
+  // As update for the tabs of one file, and drops its stored tabs whose sheet
+  // id is not in sheet_ids (tabs deleted since the last fetch), in the same
+  // snapshot.
+  FileUpdate update_file(const std::string &file_name,
+                         const std::vector<int> &sheet_ids,
+                         std::vector<TabUpdate> updates);
+
+  // Current snapshot; hold on to it to see a consistent view across lookups.
+  std::shared_ptr<const Snapshot> snapshot() const;
+
+  std::shared_ptr<const SheetTab> find(std::string_view sheet_name) const;
+  std::shared_ptr<const SheetTab> find(const std::string &file_name,
+                                       int sheet_id) const;
+
+  // Shared CSV payload for a tab; null when missing or empty.
+  std::shared_ptr<const std::string> csv(std::string_view sheet_name,
+                                         bool transpose = false) const;
+
+  std::size_t size() const;
+
+  static SheetTab parse(std::string file_name, int sheet_id,
+                        std::string sheet_name, std::string csv);
+
+private:
+  std::vector<std::shared_ptr<const SheetTab>>
+  publish(std::vector<TabUpdate> updates, const std::string *file_name,
+          const std::vector<int> *sheet_ids,
+          std::vector<std::shared_ptr<const SheetTab>> *removed);
+
+  std::atomic<std::shared_ptr<const Snapshot>> current;
+  // Serializes writers only; readers never take it.
+  std::mutex write_mutex;
+};
+
+#endif // SHEETSTORE_H
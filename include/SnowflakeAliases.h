@@ -0,0 +1,56 @@
+#ifndef SNOWFLAKEALIASES_H
+#define SNOWFLAKEALIASES_H
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Per-request table that replaces 17-20 digit Discord snowflakes in a prompt
+// with short handles (m1 for messages, u1 for users) and maps the model's
+// output and tool arguments back to the real ids.
+class SnowflakeAliases {
+public:
+  enum class Kind { Message, User };
+
+  // Handle for a snowflake, allocated on first use. "0" and empty ids (no
+  // reply, unknown author) are returned unchanged.
+  std::string alias(Kind kind, const std::string &snowflake);
+
+  // Replaces user mentions (<@123>, <@!123>) in message text with <@uN>.
+  std::string alias_mentions(const std::string &text);
+
+  // Tool output built from stored messages: mentions as above, and bare
+  // snowflakes become user handles when already known as a user, else message
+  // handles.
+  std::string alias_tool_output(const std::string &text);
+
+  std::optional<std::string> resolve(std::string_view handle) const;
+
+  // Whether the snowflake already has a handle, i.e. is in the prompt.
+  bool contains(Kind kind, const std::string &snowflake) const;
+
+  // Model output: <@uN> becomes a real mention. Bare uN is left alone, it
+  // may be part of ordinary text, and so are message handles.
+  std::string restore_text(const std::string &text) const;
+
+  // Tool arguments: user_id, author_id and message_id values that are a
+  // handle become the raw id; other strings are left untouched. Invalid JSON
+  // is returned as is.
+  std::string restore_arguments(const std::string &arguments_json) const;
+
+  std::size_t size() const { return to_snowflake.size(); }
+
+  // Prompt bytes avoided so far, counting every aliased occurrence.
+  std::size_t saved_bytes() const { return bytes_saved; }
+
+private:
+  std::unordered_map<std::string, std::string> to_alias;
+  std::unordered_map<std::string, std::string> to_snowflake;
+  int next_message = 1;
+  int next_user = 1;
+  std::size_t bytes_saved = 0;
+};
+
+#endif // SNOWFLAKEALIASES_H
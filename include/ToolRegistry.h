@@ -0,0 +1,72 @@
+#ifndef TOOLREGISTRY_H
+#define TOOLREGISTRY_H
+
+#include <LlmService.h>
+#include <OllamaToolCalling.h>
+#include <dpp/dpp.h>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class SnowflakeAliases;
+
+// A tool call started speculatively before the model asked for it.
+struct ToolPrefetch {
+  std::string tool_name;
+  std::string canonical_arguments;
+  dpp::task<std::string> task;
+  bool consumed = false;
+};
+
+// Per-request state shared by the tool handlers of one answered message.
+struct ToolRequestContext {
+  dpp::snowflake channel_id{};
+  dpp::snowflake server_id{};
+  int webpage_calls = 0;
+  int video_calls = 0;
+  int analytics_calls = 0;
+  // Webpage/video calls of this request holding the shared heavy-tool slot.
+  // They run concurrently and may finish on different threads. Shared with
+  // the request's prefetch, which may outlive the context.
+  std::shared_ptr<std::atomic<int>> heavy_tools_running =
+      std::make_shared<std::atomic<int>>(0);
+  std::optional<ToolPrefetch> prefetch{};
+  // Set when the prompt used short id handles; tool arguments are mapped back
+  // and ids in tool output get handles. Guarded by aliases_mutex, since tool
+  // handlers resume on different threads.
+  SnowflakeAliases *aliases = nullptr;
+  std::mutex aliases_mutex{};
+};
+
+// Tool schemas and handlers, built once at startup. The JSON tool array is
+// kept ready to attach to chat requests, and dispatch is a hash lookup.
+class ToolRegistry {
+public:
+  using Handler = std::function<dpp::task<std::string>(ToolRequestContext &,
+                                                       const std::string &)>;
+
+  void add(const LlmService::ToolDefinition &definition, Handler handler);
+
+  const ollama_tools::tools &json_tools() const { return tools; }
+  std::size_t serialized_bytes() const { return tools_bytes; }
+  std::size_t size() const { return handlers.size(); }
+  bool contains(const std::string &tool_name) const;
+
+  dpp::task<std::string> dispatch(ToolRequestContext &context,
+                                  const std::string &tool_name,
+                                  const std::string &arguments_json) const;
+
+private:
+  std::vector<Handler> handlers;
+  std::unordered_map<std::string, std::size_t> index_by_name;
+  ollama_tools::tools tools;
+  std::size_t tools_bytes = 0;
+};
+
+#endif // TOOLREGISTRY_H
@@ -0,0 +1,72 @@
+#ifndef TOOLRESULTCACHE_H
+#define TOOLRESULTCACHE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+// Process-wide cache of tool outputs shared by all requests. Entries belong to
+// an invalidation group (e.g. "sheets" or "analytics:<server id>") so data
+// sources can drop everything derived from them when they change.
+class ToolResultCache {
+public:
+  struct Stats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::size_t entries = 0;
+    std::size_t bytes = 0;
+
+    [[nodiscard]] double hit_rate() const {
+      const std::uint64_t lookups = hits + misses;
+      return lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups;
+    }
+  };
+
+  explicit ToolResultCache(std::size_t max_entries = 256,
+                           std::size_t max_bytes = 8 * 1024 * 1024);
+
+  static std::string make_key(const std::string &tool_name,
+                              const std::string &canonical_arguments,
+                              const std::string &scope = {});
+
+  std::optional<std::string> get(const std::string &key);
+  // Bumped by every invalidation of the group.
+  std::uint64_t generation(const std::string &group) const;
+  // With a generation taken before the value was computed, the put is
+  // dropped when the group was invalidated in between.
+  void put(const std::string &key, const std::string &group, std::string value,
+           std::chrono::seconds ttl,
+           std::optional<std::uint64_t> generation = std::nullopt);
+  std::size_t invalidate_group(const std::string &group);
+  Stats stats() const;
+
+private:
+  using clock = std::chrono::steady_clock;
+
+  struct Entry {
+    std::string value;
+    std::string group;
+    clock::time_point expires_at;
+    std::uint64_t sequence;
+  };
+
+  void erase_locked(std::unordered_map<std::string, Entry>::iterator it);
+  void evict_locked(clock::time_point now);
+
+  const std::size_t max_entries;
+  const std::size_t max_bytes;
+
+  mutable std::mutex mutex;
+  std::unordered_map<std::string, Entry> entries;
+  std::unordered_map<std::string, std::uint64_t> generations;
+  std::size_t total_bytes = 0;
+  std::uint64_t next_sequence = 0;
+  std::uint64_t hits = 0;
+  std::uint64_t misses = 0;
+};
+
+#endif // TOOLRESULTCACHE_H
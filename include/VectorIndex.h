@@ -0,0 +1,73 @@
+#ifndef VECTORINDEX_H
+#define VECTORINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// In-process cosine similarity index over message embeddings. Vectors are
+// normalized on insert and stored contiguously, so a search is one linear
+// pass of dot products. Capacity is fixed; when full, the oldest entry is
+// overwritten.
+class VectorIndex {
+public:
+  struct Hit {
+    std::uint64_t id;
+    std::uint64_t server_id;
+    std::uint64_t channel_id;
+    float score;
+  };
+
+  struct SearchOptions {
+    std::size_t limit = 5;
+    // 0 means any server.
+    std::uint64_t server_id = 0;
+    float min_score = 0.0F;
+    // Ids to leave out, e.g. messages already in the prompt.
+    std::vector<std::uint64_t> exclude_ids;
+  };
+
+  explicit VectorIndex(std::size_t max_entries = 20000);
+
+  // The first vector fixes the dimension; later vectors of another size or
+  // with zero norm are rejected. Re-adding an id replaces its vector.
+  bool add(std::uint64_t id, std::uint64_t server_id, std::uint64_t channel_id,
+           std::span<const float> embedding);
+
+  std::vector<Hit> search(std::span<const float> query,
+                          const SearchOptions &options) const;
+
+  // Binary snapshot, written to a temporary file and renamed into place.
+  bool save(const std::string &path) const;
+  // Replaces the contents; false leaves the index unchanged.
+  bool load(const std::string &path);
+
+  std::size_t size() const;
+  std::size_t dimensions() const;
+  std::size_t capacity() const { return max_entries; }
+  std::size_t memory_bytes() const;
+
+  static float dot(const float *a, const float *b, std::size_t n);
+
+private:
+  struct Meta {
+    std::uint64_t id;
+    std::uint64_t server_id;
+    std::uint64_t channel_id;
+  };
+
+  const std::size_t max_entries;
+  mutable std::shared_mutex mutex;
+  std::size_t dims = 0;
+  std::vector<float> vectors;
+  std::vector<Meta> meta;
+  std::unordered_map<std::uint64_t, std::size_t> slot_by_id;
+  // Next slot to overwrite once the index is full.
+  std::size_t next_slot = 0;
+};
+
+#endif // VECTORINDEX_H
@@ -0,0 +1,72 @@
+#ifndef VEHICLEINDEX_H
+#define VEHICLEINDEX_H
+
+#include <SheetStore.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Inverted index from vehicle names to their rows in every sheet tab. Names
+// are normalized to lowercase letters and digits, so "ID.4" finds "Id 4",
+// and trigram postings give fuzzy candidates for typos ("ionic 5"). Tabs are
+// indexed one at a time, so a refresh only rebuilds the tabs that changed.
+class VehicleIndex {
+public:
+  struct Match {
+    std::shared_ptr<const SheetTab> tab;
+    std::size_t row;
+    std::size_t key_column;
+    float score;
+  };
+
+  // Replaces the entries of the tab with the same (file, sheet id). The key
+  // column holds the vehicle name.
+  void update_tab(std::shared_ptr<const SheetTab> tab,
+                  std::size_t key_column = 0);
+
+  // Drops the entries of a tab that no longer exists.
+  void remove_tab(const std::string &file_name, int sheet_id);
+
+  // Best matches, strongest first. Exact and substring matches rank above
+  // fuzzy ones, and fuzzy ones are only returned when nothing better exists.
+  std::vector<Match> lookup(std::string_view query,
+                            std::size_t limit = 30) const;
+
+  // Rows of the matches grouped per sheet, one "[sheet] name: col=value; ..."
+  // line per row, cut off at max_bytes.
+  std::string format_lookup(std::string_view query,
+                            std::size_t max_bytes = 4000) const;
+
+  std::size_t size() const;
+
+  // Lowercase letters and digits only: "Kia EV9 GT-Line" -> "kiaev9gtline".
+  static std::string compact_name(std::string_view name);
+
+private:
+  struct Entry {
+    std::shared_ptr<const SheetTab> tab;
+    std::size_t row;
+    std::size_t key_column;
+    std::string key;
+    std::vector<std::string> tokens;
+    std::vector<std::uint32_t> trigrams;
+  };
+
+  void remove_entry(std::uint32_t id);
+
+  mutable std::shared_mutex mutex;
+  std::unordered_map<std::uint32_t, Entry> entries;
+  std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> postings;
+  std::map<std::pair<std::string, int>, std::vector<std::uint32_t>> by_tab;
+  std::uint32_t next_id = 0;
+};
+
+#endif // VEHICLEINDEX_H
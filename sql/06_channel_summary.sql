@@ -0,0 +1,11 @@
+drop table if exists channel_summary cascade;
+
+-- Rolling summary of the history that has left the prompt's hot window.
+-- last_message_id is the newest message folded into the summary.
+create table channel_summary
+(
+    channel_id       int primary key references channel(channel_id)
+  , summary          text not null default ''
+  , last_message_id  int not null default 0
+  , updated_at       timestamptz not null default now()
+);
@@ -0,0 +1,18 @@
+-- Full-text and substring search over message content for the
+-- search_messages tool. Nothing here rewrites or locks the message table:
+-- the full-text index is on an expression rather than a stored column, and
+-- the indexes are built concurrently, so messages keep being stored while
+-- they build. Run it outside a transaction (psql -f does), since create
+-- index concurrently cannot run inside one. A build that fails leaves an
+-- invalid index; drop it and run the file again.
+create extension if not exists pg_trgm;
+
+-- Queries must use the same expression to hit this index.
+create index concurrently if not exists message_content_tsv_idx
+  on message using gin (to_tsvector('simple', coalesce(content, '')));
+
+create index concurrently if not exists message_content_trgm_idx
+  on message using gin (content gin_trgm_ops);
+
+create index concurrently if not exists message_channel_message_idx
+  on message (channel_id, message_id);
@@ -0,0 +1,8 @@
+-- Indexes for walking reply chains (fetch_reply_chain): each step looks up
+-- the parent by its snowflake, and replies to a message by reply_to.
+create index if not exists message_snowflake_idx
+  on message (message_snowflake_id);
+
+create index if not exists message_reply_to_idx
+  on message (reply_to_snowflake_id)
+  where reply_to_snowflake_id <> 0;
@@ -110,29 +110,6 @@ std::optional<EmojiFilter> normalize_emoji_filter(const std::string &raw) {
   return EmojiFilter{EmojiFilter::Mode::Exact, token};
 }
 
-std::string time_filter_sql(const std::string &time_range, const std::string &time_expr) {
-  if (time_range == "all_time") {
-    return "1 = 1";
-  }
-  if (time_range == "last_7d") {
-    return std::format("{} >= now() - interval '7 days'", time_expr);
-  }
-  if (time_range == "last_30d") {
-    return std::format("{} >= now() - interval '30 days'", time_expr);
-  }
-  if (time_range == "this_month") {
-    return std::format("{} >= date_trunc('month', now())", time_expr);
-  }
-  if (time_range == "last_month") {
-    return std::format(
-        "{} >= date_trunc('month', now()) - interval '1 month' and {} < "
-        "date_trunc('month', now())",
-        time_expr, time_expr);
-  }
-
-  return "";
-}
-
 bool parse_limit(const ollama::json &request, int default_limit, int max_limit,
                  int &out_limit) {
   out_limit = default_limit;
@@ -237,6 +214,29 @@ std::string build_emoji_clause(const std::vector<EmojiFilter> &filters,
 
 namespace analytics_query {
 
+std::string time_filter_sql(const std::string &time_range, const std::string &time_expr) {
+  if (time_range == "all_time") {
+    return "1 = 1";
+  }
+  if (time_range == "last_7d") {
+    return std::format("{} >= now() - interval '7 days'", time_expr);
+  }
+  if (time_range == "last_30d") {
+    return std::format("{} >= now() - interval '30 days'", time_expr);
+  }
+  if (time_range == "this_month") {
+    return std::format("{} >= date_trunc('month', now())", time_expr);
+  }
+  if (time_range == "last_month") {
+    return std::format(
+        "{} >= date_trunc('month', now()) - interval '1 month' and {} < "
+        "date_trunc('month', now())",
+        time_expr, time_expr);
+  }
+
+  return "";
+}
+
 ParseResult parse_and_compile(const std::string &request_json) {
   ollama::json request;
   try {
@@ -203,7 +203,15 @@ CalculationService::calculate_with_bc(const std::string &expression,
     co_return "Tool error: scale must be between 0 and 100.";
   }
 
-  CommandResult result = run_bc(trimmed_expression, scale, timeout);
+  // bc runs on the work queue so concurrent tool calls are not serialized
+  // behind the blocking poll loop.
+  CommandResult result = co_await dpp::async<CommandResult>(
+      [&](std::function<void(CommandResult)> cb) {
+        bot.queue_work(10, [cb = std::move(cb), trimmed_expression, scale,
+                            timeout]() mutable {
+          cb(run_bc(trimmed_expression, scale, timeout));
+        });
+      });
   std::string output = trim_copy(result.output);
 
   if (result.timed_out) {
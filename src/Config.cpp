@@ -151,6 +151,67 @@ Config::Config()
         } catch (...) {
         }
 
+        std::string router_model;
+        try {
+          router_model = ini["General"]["router_model"].as<std::string>();
+        } catch (...) {
+        }
+
+        std::string embedding_model;
+        try {
+          embedding_model = ini["General"]["embedding_model"].as<std::string>();
+        } catch (...) {
+        }
+
+        std::string embedding_index_path = "message_index.bin";
+        try {
+          embedding_index_path =
+              ini["General"]["embedding_index_path"].as<std::string>();
+        } catch (...) {
+        }
+
+        std::string sheet_key_column;
+        try {
+          sheet_key_column =
+              ini["General"]["sheet_key_column"].as<std::string>();
+        } catch (...) {
+        }
+
+        std::string sheet_snapshot_path = "sheet_snapshot.bin";
+        try {
+          sheet_snapshot_path =
+              ini["General"]["sheet_snapshot_path"].as<std::string>();
+        } catch (...) {
+        }
+
+        std::string drive_api_url = "https://www.googleapis.com/drive/v3";
+        try {
+          drive_api_url = ini["General"]["drive_api_url"].as<std::string>();
+        } catch (...) {
+        }
+
+        std::string drive_watch_address;
+        try {
+          drive_watch_address =
+              ini["General"]["drive_watch_address"].as<std::string>();
+        } catch (...) {
+        }
+
+        int drive_watch_port = 0;
+        try {
+          int v = ini["General"]["drive_watch_port"].as<int>();
+          if (v > 0 && v < 65536)
+            drive_watch_port = v;
+        } catch (...) {
+        }
+
+        std::string sheet_history_path = "sheet_history.log";
+        try {
+          sheet_history_path =
+              ini["General"]["sheet_history_path"].as<std::string>();
+        } catch (...) {
+        }
+
         if (discord_token.empty() || google_api_key.empty() ||
             system_prompt.empty() || diff_system_prompt.empty() ||
             text_model.empty() || comparison_model.empty() ||
@@ -166,7 +227,11 @@ Config::Config()
                         max_history, context_size, num_predict, rate_limit_count,
                         rate_limit_window_seconds, youtube_summary_bot_id,
                         youtube_summary_channel_id, owner_id,
-                        allowed_channels, youtube_skip_channel_names);
+                        allowed_channels, youtube_skip_channel_names,
+                        router_model, embedding_model, embedding_index_path,
+                        sheet_key_column, sheet_snapshot_path, drive_api_url,
+                        drive_watch_address, drive_watch_port,
+                        sheet_history_path);
       }()) {}
 
 Config::Config(bool valid, std::string discord_token,
@@ -184,7 +249,12 @@ Config::Config(bool valid, std::string discord_token,
                std::string youtube_summary_channel_id,
                std::string owner_id,
                std::vector<std::string> allowed_channels,
-               std::vector<std::string> youtube_skip_channel_names)
+               std::vector<std::string> youtube_skip_channel_names,
+               std::string router_model, std::string embedding_model,
+               std::string embedding_index_path, std::string sheet_key_column,
+               std::string sheet_snapshot_path, std::string drive_api_url,
+               std::string drive_watch_address, int drive_watch_port,
+               std::string sheet_history_path)
     : discord_token(std::move(discord_token)),
       google_api_key(std::move(google_api_key)),
       max_history(max_history),
@@ -197,22 +267,32 @@ Config::Config(bool valid, std::string discord_token,
       image_description_system_prompt(
           std::move(image_description_system_prompt)),
       text_model(std::move(text_model)),
+      router_model(std::move(router_model)),
+      embedding_model(std::move(embedding_model)),
+      embedding_index_path(std::move(embedding_index_path)),
       comparison_model(std::move(comparison_model)),
       vision_model(std::move(vision_model)),
       image_description_model(std::move(image_description_model)),
       ollama_server_url(std::move(ollama_server_url)),
       db_connection_string(std::move(db_connection_string)),
       video_summary_script_path(std::move(video_summary_script_path)),
+      drive_api_url(std::move(drive_api_url)),
+      sheet_key_column(std::move(sheet_key_column)),
+      sheet_snapshot_path(std::move(sheet_snapshot_path)),
+      sheet_history_path(std::move(sheet_history_path)),
+      drive_watch_address(std::move(drive_watch_address)),
+      drive_watch_port(drive_watch_port),
       youtube_summary_bot_id(std::move(youtube_summary_bot_id)),
       youtube_summary_channel_id(std::move(youtube_summary_channel_id)),
       owner_id(std::move(owner_id)),
       allowed_channels(std::move(allowed_channels)),
       youtube_skip_channel_names(std::move(youtube_skip_channel_names)),
       is_valid(valid) {
-  directory_url = std::format("https://www.googleapis.com/drive/v3/"
-                              "files?q='1HOwktdiZmm40atGPwymzrxErMi1ZrKPP'+in+"
+  directory_url = std::format("{}/"
+                              "files?q='{}'+in+"
                               "parents&key={}&fields=files("
                               "id,name,modifiedTime,webViewLink)",
+                              this->drive_api_url, sheet_folder_id,
                               this->google_api_key);
   youtube_url =
       std::format("https://www.googleapis.com/youtube/v3/"
@@ -0,0 +1,100 @@
+#include <ConversationSummaryService.h>
+#include <DbOps.h>
+
+#include <format>
+
+namespace {
+
+// Fold messages in only once this many have left the hot window, so a busy
+// channel is not re-summarized for every new message.
+constexpr int min_pending_messages = 20;
+constexpr int max_messages_per_update = 200;
+constexpr std::size_t max_message_chars = 500;
+
+} // namespace
+
+ConversationSummaryService::ConversationSummaryService(
+    const Config &config, dpp::cluster &bot, const LlmService &llm_service)
+    : config(config), bot(bot), llm_service(llm_service) {}
+
+dpp::task<void> ConversationSummaryService::process() {
+  if (running.exchange(true))
+    co_return;
+
+  try {
+    const auto channels = dbops::fetch_channels_needing_summary(
+        config.max_history, min_pending_messages);
+    for (const auto &row : channels) {
+      const int channel_id = row["channel_id"].as<int>();
+      const auto newest = row["newest_message_id"].as<std::uint64_t>();
+      if (const auto it = summarized_up_to.find(channel_id);
+          it != summarized_up_to.end() && it->second == newest) {
+        continue;
+      }
+      const bool done = co_await update_channel(
+          channel_id, row["channel_name"].as<std::string>(),
+          row["summary"].as<std::string>(),
+          row["last_message_id"].as<std::uint64_t>());
+      if (done) {
+        summarized_up_to[channel_id] = newest;
+      } else {
+        summarized_up_to.erase(channel_id);
+      }
+    }
+  } catch (const std::exception &e) {
+    bot.log(dpp::ll_error,
+            std::format("Conversation summary update failed: {}", e.what()));
+  }
+
+  running = false;
+  co_return;
+}
+
+dpp::task<bool> ConversationSummaryService::update_channel(
+    int channel_id, std::string channel_name, std::string summary,
+    std::uint64_t last_message_id) {
+  const auto messages = dbops::fetch_messages_for_summary(
+      channel_id, last_message_id, config.max_history, max_messages_per_update);
+  if (messages.empty())
+    co_return true;
+
+  std::string prompt = std::format(
+      "Channel: {}\nPrevious summary:\n{}\n\nNew messages, oldest first:",
+      channel_name, summary.empty() ? "(none)" : summary);
+  std::uint64_t newest_message_id = last_message_id;
+  for (const auto &row : messages) {
+    std::string content = row["content"].as<std::string>();
+    if (content.size() > max_message_chars) {
+      content.resize(max_message_chars);
+      content += "...";
+    }
+    prompt += std::format("\n[{}] {}: {}", row["created_at"].as<std::string>(),
+                          row["user_name"].as<std::string>(), content);
+    newest_message_id = row["message_id"].as<std::uint64_t>();
+  }
+
+  auto updated = co_await dpp::async<std::string>(
+      [&](std::function<void(std::string)> cb) {
+        bot.queue_work(10, [cb = std::move(cb), prompt,
+                            &llm = llm_service]() mutable {
+          cb(llm.generate_text(prompt, ollama::images{},
+                               LlmService::GenerationType::ConversationSummary));
+        });
+      });
+
+  if (updated.empty() || updated.starts_with("Exception running llm:")) {
+    bot.log(dpp::ll_warning,
+            std::format("Conversation summary for {} not updated: {}",
+                        channel_name, updated));
+    co_return true;
+  }
+
+  dbops::upsert_channel_summary(channel_id, updated, newest_message_id);
+  bot.log(dpp::ll_info,
+          std::format("Conversation summary for {} folded in {} messages "
+                      "({} -> {} bytes)",
+                      channel_name, messages.size(), summary.size(),
+                      updated.size()));
+  // A full batch may have left more backlog for the next pass.
+  co_return static_cast<int>(messages.size()) < max_messages_per_update;
+}
@@ -0,0 +1,145 @@
+#include <CsvParser.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+bool is_delimiter(char ch) { return ch == ',' || ch == '\n' || ch == '\r'; }
+
+// Offset of the first comma, LF or CR in [p, p + n), or n. Sixteen bytes at
+// a time with SSE2; most cells are short, but long text cells and runs of
+// empty cells in wide sheets dominate multi-megabyte exports.
+std::size_t find_delimiter(const char *p, std::size_t n) {
+  std::size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i comma = _mm_set1_epi8(',');
+  const __m128i lf = _mm_set1_epi8('\n');
+  const __m128i cr = _mm_set1_epi8('\r');
+  for (; i + 16 <= n; i += 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+    const __m128i hits = _mm_or_si128(
+        _mm_cmpeq_epi8(chunk, comma),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, lf), _mm_cmpeq_epi8(chunk, cr)));
+    const int mask = _mm_movemask_epi8(hits);
+    if (mask != 0)
+      return i + static_cast<std::size_t>(__builtin_ctz(mask));
+  }
+#endif
+  for (; i < n; ++i) {
+    if (is_delimiter(p[i]))
+      return i;
+  }
+  return n;
+}
+
+// Offset of the next quote, or n; memchr is vectorized in the C library.
+std::size_t find_quote(const char *p, std::size_t n) {
+  const void *hit = std::memchr(p, '"', n);
+  return hit == nullptr ? n : static_cast<const char *>(hit) - p;
+}
+
+} // namespace
+
+CsvTable::CsvTable(std::string text) : buffer(std::move(text)) {
+  // Cells are unescaped in place: the write position never passes the read
+  // position, so finished cells are never overwritten.
+  char *data = buffer.data();
+  const std::size_t n = buffer.size();
+  std::size_t r = 0;
+  std::size_t w = 0;
+
+  auto move_bytes = [&](std::size_t count) {
+    if (w != r)
+      std::memmove(data + w, data + r, count);
+    w += count;
+    r += count;
+  };
+
+  bool record_quoted = false;
+  auto end_record = [&] {
+    const std::size_t first = row_starts.back();
+    const std::size_t count = cells.size() - first;
+    if (count == 1 && cells.back().empty() && !record_quoted) {
+      cells.pop_back();
+    } else {
+      row_starts.push_back(cells.size());
+      widest = std::max(widest, count);
+    }
+    record_quoted = false;
+  };
+
+  while (r < n) {
+    const std::size_t cell_start = w;
+    if (data[r] == '"') {
+      record_quoted = true;
+      ++r;
+      while (r < n) {
+        move_bytes(find_quote(data + r, n - r));
+        if (r >= n)
+          break;
+        if (r + 1 < n && data[r + 1] == '"') {
+          data[w++] = '"';
+          r += 2;
+        } else {
+          ++r;
+          break;
+        }
+      }
+    }
+    // Unquoted text, or stray text after a closing quote, up to the next
+    // delimiter.
+    move_bytes(find_delimiter(data + r, n - r));
+    cells.emplace_back(data + cell_start, w - cell_start);
+
+    if (r >= n) {
+      end_record();
+      break;
+    }
+    const char delimiter = data[r++];
+    if (delimiter == ',') {
+      if (r == n) {
+        cells.emplace_back();
+        end_record();
+      }
+      continue;
+    }
+    if (delimiter == '\r' && r < n && data[r] == '\n')
+      ++r;
+    end_record();
+  }
+}
+
+std::span<const std::string_view> CsvTable::row(std::size_t index) const {
+  const std::size_t first = row_starts[index];
+  return {cells.data() + first, row_starts[index + 1] - first};
+}
+
+std::string csv_escape(std::string_view cell) {
+  if (cell.find_first_of(",\"\n\r") == std::string_view::npos)
+    return std::string(cell);
+
+  std::string quoted = "\"";
+  for (const char ch : cell) {
+    if (ch == '"')
+      quoted += '"';
+    quoted += ch;
+  }
+  quoted += '"';
+  return quoted;
+}
+
+std::string csv_join(std::span<const std::string_view> cells) {
+  std::string line;
+  for (std::size_t i = 0; i < cells.size(); ++i) {
+    if (i != 0)
+      line += ',';
+    line += csv_escape(cells[i]);
+  }
+  return line;
+}
@@ -166,6 +166,63 @@ pqxx::result fetch_reactions_for_message(std::uint64_t message_id) {
                     message_id);
 }
 
+// The message and up to max_depth - 1 ancestors, nearest first.
+pqxx::result fetch_reply_chain(dpp::snowflake message_id, int max_depth) {
+  auto &db = Database::instance();
+  return db.execute(
+      "with recursive chain as ( "
+      "  select m.message_id, m.message_snowflake_id, m.reply_to_snowflake_id, "
+      "         m.user_id, m.content, m.created_at, 0 as depth "
+      "  from message m where m.message_snowflake_id = $1 "
+      "  union all "
+      "  select p.message_id, p.message_snowflake_id, p.reply_to_snowflake_id, "
+      "         p.user_id, p.content, p.created_at, chain.depth + 1 "
+      "  from chain "
+      "  join message p on p.message_snowflake_id = chain.reply_to_snowflake_id "
+      "  where chain.reply_to_snowflake_id <> 0 and chain.depth + 1 < $2 "
+      ") "
+      "select distinct on (c.depth) c.message_snowflake_id "
+      "     , c.reply_to_snowflake_id "
+      "     , u.user_snowflake_id "
+      "     , c.content "
+      "     , c.created_at "
+      "     , c.depth "
+      "from chain c "
+      "inner join discord_user u on (u.user_id = c.user_id) "
+      "order by c.depth asc, c.message_id asc",
+      std::stol(message_id.str()), max_depth);
+}
+
+std::vector<std::uint64_t> fetch_recent_message_ids(dpp::snowflake channel_id,
+                                                    int max_history) {
+  auto &db = Database::instance();
+  auto res = db.execute("select m.message_id "
+                        "from message m "
+                        "inner join channel c on (c.channel_id = m.channel_id) "
+                        "where c.channel_snowflake_id = $1 "
+                        "order by m.message_id desc limit $2",
+                        std::stol(channel_id.str()), max_history);
+  std::vector<std::uint64_t> ids;
+  ids.reserve(res.size());
+  for (const auto &row : res)
+    ids.push_back(row["message_id"].as<std::uint64_t>());
+  return ids;
+}
+
+pqxx::result fetch_messages_by_ids(const std::vector<std::int64_t> &message_ids) {
+  auto &db = Database::instance();
+  return db.execute("select m.message_id "
+                    "     , u.user_name "
+                    "     , c.channel_name "
+                    "     , m.content "
+                    "     , to_char(m.created_at, 'YYYY-MM-DD HH24:MI') as created_at "
+                    "from message m "
+                    "inner join discord_user u on (u.user_id = m.user_id) "
+                    "inner join channel c on (c.channel_id = m.channel_id) "
+                    "where m.message_id = any($1)",
+                    message_ids);
+}
+
 std::optional<std::uint64_t> find_message_id(dpp::snowflake message_snowflake) {
   auto &db = Database::instance();
   auto res = db.execute(
@@ -249,6 +306,74 @@ StoredMessageIds store_message(const Message &message, dpp::guild *server,
                           res.front()["message_id"].as<int>()};
 }
 
+std::optional<ChannelSummary> fetch_channel_summary(dpp::snowflake channel_id) {
+  auto &db = Database::instance();
+  auto res = db.execute("select s.channel_id, s.summary, s.last_message_id "
+                        "from channel_summary s "
+                        "inner join channel c on (c.channel_id = s.channel_id) "
+                        "where c.channel_snowflake_id = $1",
+                        std::stol(channel_id.str()));
+  if (res.empty())
+    return std::nullopt;
+  return ChannelSummary{res.front()["channel_id"].as<int>(),
+                        res.front()["summary"].as<std::string>(),
+                        res.front()["last_message_id"].as<std::uint64_t>()};
+}
+
+// Channels with a message in the last day and at least min_pending messages
+// that have left the hot window but are not in the summary yet, with the id
+// of their newest message.
+pqxx::result fetch_channels_needing_summary(int max_history, int min_pending) {
+  auto &db = Database::instance();
+  return db.execute(
+      "select c.channel_id "
+      "     , c.channel_name "
+      "     , coalesce(s.summary, '') as summary "
+      "     , coalesce(s.last_message_id, 0) as last_message_id "
+      "     , (select max(m.message_id) from message m "
+      "        where m.channel_id = c.channel_id) as newest_message_id "
+      "from channel c "
+      "left join channel_summary s on (s.channel_id = c.channel_id) "
+      "where exists (select 1 from message m where m.channel_id = c.channel_id "
+      "              and m.created_at > now() - interval '1 day') "
+      "  and (select count(*) from message m where m.channel_id = c.channel_id "
+      "       and m.message_id > coalesce(s.last_message_id, 0)) - $1 >= $2",
+      max_history, min_pending);
+}
+
+// Oldest messages after after_message_id that are outside the newest
+// max_history messages of the channel.
+pqxx::result fetch_messages_for_summary(int channel_id,
+                                        std::uint64_t after_message_id,
+                                        int max_history, int limit) {
+  auto &db = Database::instance();
+  return db.execute(
+      "select m.message_id "
+      "     , u.user_name "
+      "     , m.content "
+      "     , m.created_at "
+      "from message m "
+      "inner join discord_user u on (u.user_id = m.user_id) "
+      "where m.channel_id = $1 "
+      "  and m.message_id > $2 "
+      "  and m.message_id < (select min(h.message_id) from "
+      "                      (select message_id from message "
+      "                       where channel_id = $1 "
+      "                       order by message_id desc limit $3) h) "
+      "order by m.message_id asc limit $4",
+      channel_id, after_message_id, max_history, limit);
+}
+
+void upsert_channel_summary(int channel_id, const std::string &summary,
+                            std::uint64_t last_message_id) {
+  auto &db = Database::instance();
+  db.execute("insert into channel_summary (channel_id, summary, last_message_id, "
+             "updated_at) values ($1, $2, $3, now()) "
+             "on conflict (channel_id) do update set summary = excluded.summary, "
+             "last_message_id = excluded.last_message_id, updated_at = now()",
+             channel_id, summary, last_message_id);
+}
+
 pqxx::result fetch_chanstats(dpp::snowflake channel_id, dpp::snowflake bot_id) {
   auto &db = Database::instance();
   return db.execute(
@@ -410,4 +535,47 @@ std::string run_compiled_channel_analytics_query(
   return build_json_result(res, compiled, markdown_preview);
 }
 
+std::string run_message_search(dpp::snowflake channel_id,
+                               dpp::snowflake server_id,
+                               const message_search::CompiledSearch &compiled) {
+  pqxx::params params;
+  if (compiled.scope == "server") {
+    if (server_id.str() == "0") {
+      return "Tool error: server scope is not available in this context.";
+    }
+    params.append(std::stol(server_id.str()));
+  } else {
+    params.append(std::stol(channel_id.str()));
+  }
+  for (const auto &param : compiled.bind_params) {
+    params.append(param);
+  }
+
+  pqxx::result res;
+  try {
+    res = Database::instance().execute_with_session_limits(
+        compiled.sql, params, 2500, 500, 3000, true);
+  } catch (const std::exception &e) {
+    return std::format("Tool error: message search failed: {}", e.what());
+  }
+
+  if (res.empty()) {
+    return std::format("No messages found for \"{}\".", compiled.query);
+  }
+
+  std::string output = std::format("Found {} messages for \"{}\" ({}, {}):",
+                                   res.size(), compiled.query, compiled.scope,
+                                   compiled.sort);
+  for (const auto &row : res) {
+    output += std::format("\n[{}] #{} {} (score {}, id {}): {}",
+                          row["created_at"].as<std::string>(),
+                          row["channel"].as<std::string>(),
+                          row["author"].as<std::string>(),
+                          row["score"].as<std::string>(),
+                          row["message_id"].as<std::string>(),
+                          row["snippet"].as<std::string>());
+  }
+  return output;
+}
+
 } // namespace dbops
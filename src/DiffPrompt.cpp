@@ -0,0 +1,96 @@
+#include <DiffPrompt.h>
+
+#include <format>
+
+namespace {
+
+constexpr std::string_view truncated_note = "\n[diff truncated]\n";
+// Room for the "N sheets changed" line of a prompt with several sections.
+constexpr std::size_t preamble_bytes = 64;
+
+std::string sheet_section(const SheetDiff &diff) {
+  return std::format("Sheet name: {}\nCSV Header: {}\nDiff:\n{}",
+                     diff.sheet_name, diff.header, diff.diff);
+}
+
+// Longest prefix of text within max_bytes that does not split a UTF-8
+// sequence.
+std::size_t utf8_prefix(std::string_view text, std::size_t max_bytes) {
+  if (text.size() <= max_bytes)
+    return text.size();
+  std::size_t end = max_bytes;
+  while (end > 0 && (static_cast<unsigned char>(text[end]) & 0xC0) == 0x80)
+    --end;
+  return end;
+}
+
+} // namespace
+
+std::vector<std::string> build_diff_prompts(const std::string &filename,
+                                            const std::vector<SheetDiff> &diffs,
+                                            std::size_t max_bytes) {
+  std::vector<std::vector<std::string>> groups;
+  std::size_t group_bytes = 0;
+  const std::string file_line = std::format("Filename: {}\n", filename);
+
+  for (const auto &diff : diffs) {
+    std::string section = sheet_section(diff);
+    if (file_line.size() + section.size() > max_bytes) {
+      const std::size_t room =
+          max_bytes > file_line.size() + truncated_note.size()
+              ? max_bytes - file_line.size() - truncated_note.size()
+              : 0;
+      section.resize(utf8_prefix(section, room));
+      section += truncated_note;
+    }
+    // Two bytes for the blank line between sections.
+    const bool fits = !groups.empty() &&
+                      file_line.size() + preamble_bytes + group_bytes + 2 +
+                              section.size() <=
+                          max_bytes;
+    if (!fits) {
+      groups.emplace_back();
+      group_bytes = 0;
+    }
+    group_bytes += section.size() + 2;
+    groups.back().push_back(std::move(section));
+  }
+
+  std::vector<std::string> prompts;
+  prompts.reserve(groups.size());
+  for (auto &group : groups) {
+    std::string prompt = file_line;
+    if (group.size() > 1) {
+      prompt += std::format("{} sheets changed; summarize them together in one "
+                            "message.\n\n",
+                            group.size());
+    }
+    for (std::size_t i = 0; i < group.size(); ++i) {
+      if (i != 0)
+        prompt += "\n\n";
+      prompt += group[i];
+    }
+    prompts.push_back(std::move(prompt));
+  }
+  return prompts;
+}
+
+std::vector<std::string> split_message(const std::string &text,
+                                       std::size_t max_bytes) {
+  std::vector<std::string> parts;
+  std::string_view rest = text;
+  while (rest.size() > max_bytes) {
+    std::size_t cut = rest.rfind('\n', max_bytes);
+    if (cut == std::string_view::npos || cut == 0)
+      cut = utf8_prefix(rest, max_bytes);
+    if (cut == 0)
+      cut = max_bytes;
+    parts.emplace_back(rest.substr(0, cut));
+    rest.remove_prefix(cut);
+    if (!rest.empty() && rest.front() == '\n')
+      rest.remove_prefix(1);
+  }
+  if (!rest.empty())
+    parts.emplace_back(rest);
+  return parts;
+}
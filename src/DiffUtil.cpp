@@ -1,160 +1,471 @@
+#include <CsvParser.h>
 #include <DiffUtil.h>
 
 #include <algorithm>
-#include <array>
-#include <cstdio>
-#include <filesystem>
-#include <fstream>
+#include <cstddef>
 #include <format>
-#include <memory>
+#include <optional>
 #include <ranges>
-#include <sstream>
+#include <span>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
-std::string transpose_csv(const std::string &raw) {
-  if (raw.empty()) {
-    return "";
+namespace {
+
+using Rows = std::vector<std::vector<std::string_view>>;
+
+// Records of the table, optionally transposed. Transposing pads every record
+// to the widest one first.
+Rows table_rows(const CsvTable &table, bool transpose) {
+  Rows rows;
+  rows.reserve(table.row_count());
+  for (std::size_t i = 0; i < table.row_count(); ++i) {
+    const auto row = table.row(i);
+    rows.emplace_back(row.begin(), row.end());
+  }
+  if (!transpose) {
+    return rows;
   }
 
-  auto split_csv_line = [](const std::string &line) -> std::vector<std::string> {
-    std::vector<std::string> cells;
-    std::string cell;
+  Rows transposed(table.max_columns(),
+                  std::vector<std::string_view>(rows.size()));
+  for (std::size_t r = 0; r < rows.size(); ++r) {
+    for (std::size_t c = 0; c < rows[r].size(); ++c) {
+      transposed[c][r] = rows[r][c];
+    }
+  }
+  return transposed;
+}
 
-    for (const char c : line) {
-      if (c == ',') {
-        cells.push_back(cell);
-        cell.clear();
-      } else {
-        cell += c;
-      }
+// One diff line per record. Line breaks inside quoted cells are written as
+// \n so a record stays on one line of the diff.
+std::string diff_line(std::span<const std::string_view> cells) {
+  std::string line = csv_join(cells);
+  if (line.find_first_of("\r\n") == std::string::npos) {
+    return line;
+  }
+  std::string escaped;
+  for (std::size_t i = 0; i < line.size(); ++i) {
+    if (line[i] == '\r' && i + 1 < line.size() && line[i + 1] == '\n') {
+      continue;
     }
+    escaped += line[i] == '\n' || line[i] == '\r' ? std::string("\\n")
+                                                   : std::string(1, line[i]);
+  }
+  return escaped;
+}
 
-    cells.push_back(cell);
-    return cells;
+// Header record first, then the remaining records in sorted order.
+std::vector<std::string> sorted_diff_lines(const Rows &rows) {
+  std::vector<std::string> lines;
+  lines.reserve(rows.size());
+  for (const auto &row : rows) {
+    lines.push_back(diff_line(row));
+  }
+  if (lines.size() > 1) {
+    std::sort(lines.begin() + 1, lines.end());
+  }
+  return lines;
+}
+
+// "start,count" as diff -u prints it: 1-based, count omitted when it is one,
+// and an empty range names the line before it.
+std::string hunk_range(std::size_t before, std::size_t count) {
+  if (count == 1) {
+    return std::format("{}", before + 1);
+  }
+  return std::format("{},{}", count == 0 ? before : before + 1, count);
+}
+
+// Myers' O(ND) diff with the linear-space middle snake. Marks the lines of a
+// that are removed and the lines of b that are added.
+void myers_diff(const int *a, std::size_t n, const int *b, std::size_t m,
+                char *removed, char *added) {
+  while (n > 0 && m > 0 && a[0] == b[0]) {
+    ++a, ++b, ++removed, ++added;
+    --n, --m;
+  }
+  while (n > 0 && m > 0 && a[n - 1] == b[m - 1]) {
+    --n, --m;
+  }
+  if (n == 0 || m == 0) {
+    std::fill(removed, removed + n, 1);
+    std::fill(added, added + m, 1);
+    return;
+  }
+
+  const auto N = static_cast<std::ptrdiff_t>(n);
+  const auto M = static_cast<std::ptrdiff_t>(m);
+  const std::ptrdiff_t max_d = (N + M + 1) / 2;
+  const std::ptrdiff_t offset = max_d;
+  const std::ptrdiff_t length = 2 * max_d + 2;
+  std::vector<std::ptrdiff_t> forward(length, -1);
+  std::vector<std::ptrdiff_t> backward(length, -1);
+  forward[offset + 1] = 0;
+  backward[offset + 1] = 0;
+  const std::ptrdiff_t delta = N - M;
+  const bool odd = delta % 2 != 0;
+  std::ptrdiff_t k1_start = 0, k1_end = 0, k2_start = 0, k2_end = 0;
+
+  auto split = [&](std::ptrdiff_t x, std::ptrdiff_t y) {
+    myers_diff(a, x, b, y, removed, added);
+    myers_diff(a + x, n - x, b + y, m - y, removed + x, added + y);
   };
 
-  auto join_csv_line = [](const std::vector<std::string> &cells) -> std::string {
-    std::string line;
-    for (size_t i = 0; i < cells.size(); ++i) {
-      if (i != 0) {
-        line += ',';
+  for (std::ptrdiff_t d = 0; d < max_d; ++d) {
+    for (std::ptrdiff_t k1 = -d + k1_start; k1 <= d - k1_end; k1 += 2) {
+      const std::ptrdiff_t k1_offset = offset + k1;
+      std::ptrdiff_t x1 =
+          (k1 == -d || (k1 != d && forward[k1_offset - 1] < forward[k1_offset + 1]))
+              ? forward[k1_offset + 1]
+              : forward[k1_offset - 1] + 1;
+      std::ptrdiff_t y1 = x1 - k1;
+      while (x1 < N && y1 < M && a[x1] == b[y1]) {
+        ++x1, ++y1;
+      }
+      forward[k1_offset] = x1;
+      if (x1 > N) {
+        k1_end += 2;
+      } else if (y1 > M) {
+        k1_start += 2;
+      } else if (odd) {
+        const std::ptrdiff_t k2_offset = offset + delta - k1;
+        if (k2_offset >= 0 && k2_offset < length && backward[k2_offset] != -1 &&
+            x1 >= N - backward[k2_offset]) {
+          split(x1, y1);
+          return;
+        }
       }
-      line += cells[i];
     }
-    return line;
-  };
-
-  std::stringstream ss(raw);
-  std::string line;
-  std::vector<std::vector<std::string>> rows;
 
-  while (std::getline(ss, line)) {
-    if (!line.empty()) {
-      rows.push_back(split_csv_line(line));
+    for (std::ptrdiff_t k2 = -d + k2_start; k2 <= d - k2_end; k2 += 2) {
+      const std::ptrdiff_t k2_offset = offset + k2;
+      std::ptrdiff_t x2 =
+          (k2 == -d ||
+           (k2 != d && backward[k2_offset - 1] < backward[k2_offset + 1]))
+              ? backward[k2_offset + 1]
+              : backward[k2_offset - 1] + 1;
+      std::ptrdiff_t y2 = x2 - k2;
+      while (x2 < N && y2 < M && a[N - x2 - 1] == b[M - y2 - 1]) {
+        ++x2, ++y2;
+      }
+      backward[k2_offset] = x2;
+      if (x2 > N) {
+        k2_end += 2;
+      } else if (y2 > M) {
+        k2_start += 2;
+      } else if (!odd) {
+        const std::ptrdiff_t k1_offset = offset + delta - k2;
+        if (k1_offset >= 0 && k1_offset < length && forward[k1_offset] != -1) {
+          const std::ptrdiff_t x1 = forward[k1_offset];
+          const std::ptrdiff_t y1 = offset + x1 - k1_offset;
+          if (x1 >= N - x2) {
+            split(x1, y1);
+            return;
+          }
+        }
+      }
     }
   }
 
+  std::fill(removed, removed + n, 1);
+  std::fill(added, added + m, 1);
+}
+
+struct KeyedSheet {
+  std::vector<std::string_view> header;
+  // Data rows in sheet order, and the row index for each key.
+  Rows rows;
+  std::unordered_map<std::string_view, std::size_t> row_by_key;
+};
+
+std::optional<KeyedSheet> parse_keyed_sheet(const Rows &rows,
+                                            const std::string &key_column,
+                                            std::size_t &key_index) {
+  KeyedSheet sheet;
   if (rows.empty()) {
-    return "";
+    return sheet;
   }
-
-  size_t max_columns = 0;
-  for (const auto &row : rows) {
-    max_columns = std::max(max_columns, row.size());
+  sheet.header = rows.front();
+  if (!key_column.empty()) {
+    const auto it = std::ranges::find(sheet.header, key_column);
+    key_index = it == sheet.header.end()
+                    ? 0
+                    : static_cast<std::size_t>(it - sheet.header.begin());
   }
 
-  for (auto &row : rows) {
-    row.resize(max_columns);
+  for (std::size_t r = 1; r < rows.size(); ++r) {
+    auto cells = rows[r];
+    if (std::ranges::all_of(cells, [](const auto &c) { return c.empty(); })) {
+      continue;
+    }
+    cells.resize(std::max({cells.size(), sheet.header.size(), key_index + 1}));
+    if (!sheet.row_by_key.emplace(cells[key_index], sheet.rows.size()).second) {
+      return std::nullopt;
+    }
+    sheet.rows.push_back(std::move(cells));
   }
+  return sheet;
+}
 
-  std::vector<std::vector<std::string>> transposed(
-      max_columns, std::vector<std::string>(rows.size()));
-
-  for (size_t row_idx = 0; row_idx < rows.size(); ++row_idx) {
-    for (size_t col_idx = 0; col_idx < max_columns; ++col_idx) {
-      transposed[col_idx][row_idx] = rows[row_idx][col_idx];
+std::string describe_row(const KeyedSheet &sheet,
+                         const std::vector<std::string_view> &row,
+                         std::size_t key_index) {
+  std::string out(row[key_index]);
+  out += ':';
+  bool first = true;
+  for (std::size_t i = 0; i < row.size() && i < sheet.header.size(); ++i) {
+    if (i == key_index || row[i].empty()) {
+      continue;
     }
+    out += std::format("{} {}={}", first ? "" : ",", sheet.header[i], row[i]);
+    first = false;
   }
+  return out;
+}
+
+} // namespace
 
+std::string transpose_csv(const std::string &raw) {
+  const CsvTable table(raw);
   std::string result;
-  for (const auto &row : transposed) {
-    result += join_csv_line(row);
+  for (const auto &row : table_rows(table, true)) {
+    result += csv_join(row);
     result += "\n";
   }
-
   return result;
 }
 
 std::string diff_csv(const std::string &olddata, const std::string &newdata,
-                     int sheet_id, bool transpose) {
-  auto sort_csv = [](const std::string &raw) -> std::string {
-    if (raw.empty())
-      return "";
+                     bool transpose) {
+  const CsvTable old_table(olddata);
+  const CsvTable new_table(newdata);
 
-    std::stringstream ss(raw);
-    std::string line, header, result;
-    std::vector<std::string> rows;
+  // Row order in a sheet carries no meaning, so rows are compared sorted.
+  const auto old_lines = sorted_diff_lines(table_rows(old_table, transpose));
+  const auto new_lines = sorted_diff_lines(table_rows(new_table, transpose));
 
-    if (std::getline(ss, header)) {
-      result += header + "\n";
-    }
-    while (std::getline(ss, line)) {
-      if (!line.empty()) {
-        rows.push_back(line);
-      }
-    }
+  return unified_diff(std::vector<std::string_view>(old_lines.begin(),
+                                                    old_lines.end()),
+                      std::vector<std::string_view>(new_lines.begin(),
+                                                    new_lines.end()));
+}
 
-    std::ranges::sort(rows);
+std::optional<std::string> keyed_diff_csv(const std::string &olddata,
+                                          const std::string &newdata,
+                                          const std::string &key_column,
+                                          bool transpose) {
+  const CsvTable old_table(olddata);
+  const CsvTable new_table(newdata);
 
-    for (const auto &row : rows) {
-      result += row + "\n";
+  std::size_t key_index = 0;
+  std::size_t old_key_index = 0;
+  auto new_sheet = parse_keyed_sheet(table_rows(new_table, transpose),
+                                     key_column, key_index);
+  auto old_sheet = parse_keyed_sheet(table_rows(old_table, transpose),
+                                     key_column, old_key_index);
+  if (!new_sheet || !old_sheet) {
+    return std::nullopt;
+  }
+
+  // Columns are matched by name (the n-th column of a name to the n-th of
+  // the same name), so inserted or moved columns do not turn into a change in
+  // every row.
+  auto column_ids = [](const std::vector<std::string_view> &header) {
+    std::vector<std::string> ids;
+    std::unordered_map<std::string_view, int> seen;
+    for (const auto name : header) {
+      ids.push_back(std::format("{}\x1f{}", name, seen[name]++));
     }
-    return result;
+    return ids;
+  };
+  const auto old_ids = column_ids(old_sheet->header);
+  const auto new_ids = column_ids(new_sheet->header);
+  std::unordered_map<std::string, std::size_t> old_column;
+  for (std::size_t i = 0; i < old_ids.size(); ++i) {
+    old_column.emplace(old_ids[i], i);
+  }
+  std::vector<std::optional<std::size_t>> new_to_old;
+  std::vector<std::string> added_columns;
+  for (std::size_t i = 0; i < new_ids.size(); ++i) {
+    const auto it = old_column.find(new_ids[i]);
+    if (it == old_column.end()) {
+      new_to_old.push_back(std::nullopt);
+      added_columns.emplace_back(new_sheet->header[i]);
+    } else {
+      new_to_old.push_back(it->second);
+      old_column.erase(it);
+    }
+  }
+  std::vector<std::string> removed_columns;
+  for (std::size_t i = 0; i < old_ids.size(); ++i) {
+    if (old_column.contains(old_ids[i])) {
+      removed_columns.emplace_back(old_sheet->header[i]);
+    }
+  }
+
+  auto shown = [](std::string_view value) -> std::string {
+    return value.empty() ? "(empty)" : std::string(value);
   };
 
-  const std::string normalized_old = transpose ? transpose_csv(olddata) : olddata;
-  const std::string normalized_new = transpose ? transpose_csv(newdata) : newdata;
+  std::string changed_cells;
+  std::string added_rows;
+  for (const auto &row : new_sheet->rows) {
+    const auto &key = row[key_index];
+    const auto old_it = old_sheet->row_by_key.find(key);
+    if (old_it == old_sheet->row_by_key.end()) {
+      added_rows += describe_row(*new_sheet, row, key_index) + "\n";
+      continue;
+    }
+    const auto &old_row = old_sheet->rows[old_it->second];
+    for (std::size_t i = 0; i < new_sheet->header.size(); ++i) {
+      if (i == key_index || new_to_old[i] == old_key_index) {
+        continue;
+      }
+      const std::string_view old_value =
+          new_to_old[i] ? old_row[*new_to_old[i]] : std::string_view{};
+      if (old_value != row[i]) {
+        changed_cells += std::format("{} / {} / {} → {}\n", key,
+                                     new_sheet->header[i], shown(old_value),
+                                     shown(row[i]));
+      }
+    }
+  }
 
-  std::string sorted_old = sort_csv(normalized_old);
-  std::string sorted_new = sort_csv(normalized_new);
+  std::string removed_rows;
+  for (const auto &row : old_sheet->rows) {
+    if (!new_sheet->row_by_key.contains(row[old_key_index])) {
+      removed_rows += describe_row(*old_sheet, row, old_key_index) + "\n";
+    }
+  }
 
-  std::array<char, 128> buffer;
   std::string result;
+  auto join = [](const std::vector<std::string> &names) {
+    std::string out;
+    for (const auto &name : names) {
+      out += out.empty() ? name : ", " + name;
+    }
+    return out;
+  };
+  if (!added_columns.empty()) {
+    result += std::format("Added columns: {}\n", join(added_columns));
+  }
+  if (!removed_columns.empty()) {
+    result += std::format("Removed columns: {}\n", join(removed_columns));
+  }
+  if (!changed_cells.empty()) {
+    result += "Changed cells (row key / column / old → new):\n" + changed_cells;
+  }
+  if (!added_rows.empty()) {
+    result += "Added rows:\n" + added_rows;
+  }
+  if (!removed_rows.empty()) {
+    result += "Removed rows:\n" + removed_rows;
+  }
+  if (!result.empty() && key_index < new_sheet->header.size()) {
+    result = std::format("Rows keyed by column: {}\n",
+                         new_sheet->header[key_index]) +
+             result;
+  }
+  return result;
+}
 
-  std::string tempfiledir = std::filesystem::temp_directory_path();
-  std::string oldtempfile = std::format("{}/nisseold{}", tempfiledir, sheet_id);
-  std::string newtempfile = std::format("{}/nissenew{}", tempfiledir, sheet_id);
-
-  {
-    std::ofstream oldfile(oldtempfile);
-    if (oldfile.is_open()) {
-      oldfile << sorted_old;
+std::string unified_diff(const std::vector<std::string_view> &old_lines,
+                         const std::vector<std::string_view> &new_lines,
+                         std::size_t context) {
+  // Lines are interned to ids so the diff compares integers.
+  std::unordered_map<std::string_view, int> ids;
+  ids.reserve(old_lines.size() + new_lines.size());
+  auto intern = [&ids](const std::vector<std::string_view> &lines) {
+    std::vector<int> out;
+    out.reserve(lines.size());
+    for (const auto line : lines) {
+      out.push_back(
+          ids.try_emplace(line, static_cast<int>(ids.size())).first->second);
     }
+    return out;
+  };
+  const auto a = intern(old_lines);
+  const auto b = intern(new_lines);
 
-    std::ofstream newfile(newtempfile);
-    if (newfile.is_open()) {
-      newfile << sorted_new;
+  std::vector<char> removed(a.size(), 0);
+  std::vector<char> added(b.size(), 0);
+  myers_diff(a.data(), a.size(), b.data(), b.size(), removed.data(),
+             added.data());
+
+  struct Op {
+    char kind;
+    std::size_t old_pos;
+    std::size_t new_pos;
+  };
+  std::vector<Op> ops;
+  ops.reserve(a.size() + b.size());
+  std::size_t i = 0;
+  std::size_t j = 0;
+  while (i < a.size() || j < b.size()) {
+    if (i < a.size() && removed[i]) {
+      ops.push_back({'-', i, j});
+      ++i;
+    } else if (j < b.size() && added[j]) {
+      ops.push_back({'+', i, j});
+      ++j;
+    } else {
+      ops.push_back({' ', i, j});
+      ++i;
+      ++j;
     }
   }
 
-  std::unique_ptr<FILE, void (*)(FILE *)> pipe(
-      popen(std::format("diff -u {} {}", oldtempfile, newtempfile).c_str(),
-            "r"),
-      [](FILE *f) -> void { std::ignore = pclose(f); });
+  std::string result;
+  std::size_t pos = 0;
+  while (pos < ops.size()) {
+    if (ops[pos].kind == ' ') {
+      ++pos;
+      continue;
+    }
 
-  if (!pipe) {
-    std::filesystem::remove(oldtempfile);
-    std::filesystem::remove(newtempfile);
-    return std::string("Kunne ikke kjøre diff pipe");
-  }
+    // Extend the hunk while the unchanged gaps are short enough to share
+    // context with the next change.
+    const std::size_t start = pos >= context ? pos - context : 0;
+    std::size_t change_end = pos + 1;
+    std::size_t scan = change_end;
+    while (scan < ops.size()) {
+      if (ops[scan].kind != ' ') {
+        change_end = ++scan;
+        continue;
+      }
+      const std::size_t run_start = scan;
+      while (scan < ops.size() && ops[scan].kind == ' ') {
+        ++scan;
+      }
+      if (scan == ops.size() || scan - run_start > 2 * context) {
+        break;
+      }
+    }
+    const std::size_t end = std::min(ops.size(), change_end + context);
 
-  while (fgets(buffer.data(), static_cast<int>(buffer.size()), pipe.get()) !=
-         nullptr)
-    result += buffer.data();
+    std::size_t old_count = 0;
+    std::size_t new_count = 0;
+    for (std::size_t k = start; k < end; ++k) {
+      old_count += ops[k].kind != '+';
+      new_count += ops[k].kind != '-';
+    }
 
-  std::filesystem::remove(oldtempfile);
-  std::filesystem::remove(newtempfile);
+    if (result.empty()) {
+      result = "--- old\n+++ new\n";
+    }
+    result += std::format("@@ -{} +{} @@\n",
+                          hunk_range(ops[start].old_pos, old_count),
+                          hunk_range(ops[start].new_pos, new_count));
+    for (std::size_t k = start; k < end; ++k) {
+      result += ops[k].kind;
+      result += ops[k].kind == '+' ? new_lines[ops[k].new_pos]
+                                   : old_lines[ops[k].old_pos];
+      result += '\n';
+    }
+    pos = end;
+  }
 
   return result;
 }
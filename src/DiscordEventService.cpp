@@ -2,8 +2,14 @@
 #include <DbOps.h>
 #include <DiscordEventService.h>
 #include <AnalyticsQuery.h>
+#include <MessageSearch.h>
 #include <Formatting.h>
 #include <GoogleDocsService.h>
+#include <MessageIndexService.h>
+#include <SheetQuery.h>
+#include <SnowflakeAliases.h>
+#include <ToolRegistry.h>
+#include <ToolResultCache.h>
 #include <CalculationService.h>
 #include <WebPageService.h>
 #include <VideoSummaryService.h>
@@ -18,11 +24,48 @@
 #include <ranges>
 #include <regex>
 #include <sstream>
+#include <string_view>
 #include <thread>
 #include <variant>
 
 namespace {
 
+// Guards the single webpage/video slot. A std::mutex cannot be used here: the
+// guard is held across co_await, tool calls of one turn run concurrently on the
+// same thread, and the coroutine may resume on a different thread. The slot
+// belongs to a request, so a webpage and a video asked for in the same turn
+// share it instead of locking each other out.
+class HeavyToolGuard {
+public:
+  HeavyToolGuard(std::atomic<bool> &running, std::atomic<int> &request_holders)
+      : running(running), request_holders(request_holders) {
+    int holders = request_holders.load();
+    while (holders > 0 &&
+           !request_holders.compare_exchange_weak(holders, holders + 1)) {
+    }
+    if (holders > 0) {
+      owns = true;
+      return;
+    }
+    owns = !running.exchange(true);
+    if (owns)
+      request_holders.fetch_add(1);
+  }
+  ~HeavyToolGuard() {
+    if (owns && request_holders.fetch_sub(1) == 1)
+      running.store(false);
+  }
+  HeavyToolGuard(const HeavyToolGuard &) = delete;
+  HeavyToolGuard &operator=(const HeavyToolGuard &) = delete;
+
+  bool owns_lock() const { return owns; }
+
+private:
+  std::atomic<bool> &running;
+  std::atomic<int> &request_holders;
+  bool owns = false;
+};
+
 std::string format_available_guild_emojis(const dpp::emoji_map &emoji_map,
                                           std::size_t max_entries = 120) {
   if (emoji_map.empty()) {
@@ -70,6 +113,116 @@ std::string format_available_guild_emojis(const dpp::emoji_map &emoji_map,
   return out.str();
 }
 
+const std::map<std::string, std::string> &sheet_tool_tabs() {
+  static const std::map<std::string, std::string> tool_to_sheet = {
+      {"get_banana_data", "Banana"},
+      {"get_weight_data", "Weight"},
+      {"get_acceleration_data", "Acceleration"},
+      {"get_noise_data", "Noise"},
+      {"get_range_data", "Range"},
+      {"get_1000km_data", "1000 km"},
+      {"get_charging_curve_data", "Charging curve"}};
+  return tool_to_sheet;
+}
+
+// Tools whose results are shared across requests, and for how long. Sheet and
+// analytics entries are additionally invalidated when their source changes.
+std::optional<std::chrono::seconds> tool_cache_ttl(const std::string &tool_name) {
+  using namespace std::chrono_literals;
+  static const std::map<std::string, std::chrono::seconds> ttls = {
+      {"get_webpage_text", 10min},
+      {"summarize_video", 24h},
+      {"query_channel_analytics", 5min},
+      {"search_messages", 5min},
+      {"query_sheet", 1h},
+      {"lookup_vehicle", 1h},
+      {"sheet_history", 1h},
+      {"calculate_with_bc", 1h}};
+
+  if (sheet_tool_tabs().contains(tool_name)) {
+    return 1h;
+  }
+  auto it = ttls.find(tool_name);
+  if (it == ttls.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+std::string analytics_cache_group(dpp::snowflake server_id) {
+  return std::format("analytics:{}", server_id.str());
+}
+
+std::string tool_cache_group(const std::string &tool_name,
+                             dpp::snowflake server_id) {
+  // Both read stored messages, so new messages invalidate them together.
+  if (tool_name == "query_channel_analytics" || tool_name == "search_messages") {
+    return analytics_cache_group(server_id);
+  }
+  if (sheet_tool_tabs().contains(tool_name) || tool_name == "query_sheet" ||
+      tool_name == "lookup_vehicle" || tool_name == "sheet_history") {
+    return "sheets";
+  }
+  return tool_name;
+}
+
+// The one-per-request limits of the handlers, for results that skip them
+// (cache hits and prefetch handovers). Counts the call when it is allowed.
+std::optional<std::string> take_limited_call(ToolRequestContext &context,
+                                             const std::string &tool_name) {
+  if (tool_name == "get_webpage_text") {
+    if (context.webpage_calls >= 1)
+      return "Tool error: only one webpage fetch is allowed per request.";
+    context.webpage_calls += 1;
+  } else if (tool_name == "summarize_video") {
+    if (context.video_calls >= 1)
+      return "Tool error: only one video summary is allowed per request.";
+    context.video_calls += 1;
+  } else if (tool_name == "query_channel_analytics") {
+    if (context.analytics_calls >= 1)
+      return "Tool error: only one analytics query is allowed per request. "
+             "Use the previous tool result to answer.";
+    context.analytics_calls += 1;
+  }
+  return std::nullopt;
+}
+
+// Object keys are ordered in the parsed JSON, so dumping it gives the same key
+// for argument objects that only differ in key order or whitespace.
+std::string canonicalize_tool_arguments(const std::string &arguments_json) {
+  try {
+    return ollama::json::parse(arguments_json).dump();
+  } catch (...) {
+    return arguments_json;
+  }
+}
+
+bool is_youtube_url(const std::string &url) {
+  static const std::regex youtube_url_re(
+      R"(^https?://(?:(?:www\.|m\.)?youtube\.com/(?:watch\?|shorts/|live/)|youtu\.be/))",
+      std::regex::optimize | std::regex::icase);
+  return std::regex_search(url, youtube_url_re);
+}
+
+// First http(s) URL in a message, without the trailing punctuation or the
+// angle brackets Discord uses to suppress embeds.
+std::optional<std::string> extract_first_url(const std::string &content) {
+  static const std::regex url_re(R"(https?://[^\s<>|]+)",
+                                 std::regex::optimize | std::regex::icase);
+  std::smatch m;
+  if (!std::regex_search(content, m, url_re))
+    return std::nullopt;
+
+  std::string url = m[0].str();
+  while (!url.empty() && std::string_view(".,;:!?)]}\"'*_~").find(url.back()) !=
+                             std::string_view::npos) {
+    url.pop_back();
+  }
+  if (url.size() <= std::string_view("https://").size())
+    return std::nullopt;
+  return url;
+}
+
 static std::optional<std::string> extract_youtube_video_id(const std::string &url) {
   static const std::regex watch_re(R"([?&]v=([a-zA-Z0-9_-]{11}))",
                                    std::regex::optimize);
@@ -92,20 +245,686 @@ DiscordEventService::DiscordEventService(
     const WebPageService &web_page_service,
     const YoutubeService &youtube_service,
     const VideoSummaryService &video_summary_service,
-    const CalculationService &calculation_service)
+    const CalculationService &calculation_service,
+    ToolResultCache &tool_result_cache, MessageIndexService &message_index)
     : config(config), bot(bot), llm_service(llm_service),
       google_docs_service(google_docs_service),
       web_page_service(web_page_service), youtube_service(youtube_service),
       video_summary_service(video_summary_service),
-      calculation_service(calculation_service) {}
+      calculation_service(calculation_service),
+      tool_result_cache(tool_result_cache), message_index(message_index) {
+  register_tools();
+}
+
+void DiscordEventService::register_tools() {
+  const auto sheet_handler =
+      [this](const std::string &tool_name) -> ToolRegistry::Handler {
+    const std::string tab_name = sheet_tool_tabs().at(tool_name);
+    const bool transpose = tool_name == "get_charging_curve_data";
+    return [this, tab_name, transpose](ToolRequestContext &,
+                                       const std::string &) {
+      return run_sheet_tool(tab_name, transpose);
+    };
+  };
+
+  chat_tools.add(
+      {"get_banana_data", "Get EV trunk size dataset from Banana sheet", ""},
+      sheet_handler("get_banana_data"));
+  chat_tools.add(
+      {"get_weight_data", "Get EV vehicle weight dataset from Weight sheet", ""},
+      sheet_handler("get_weight_data"));
+  chat_tools.add({"get_acceleration_data",
+                  "Get EV acceleration dataset from Acceleration sheet", ""},
+                 sheet_handler("get_acceleration_data"));
+  chat_tools.add(
+      {"get_noise_data", "Get EV vehicle noise dataset from Noise sheet", ""},
+      sheet_handler("get_noise_data"));
+  chat_tools.add(
+      {"get_range_data",
+       "Get EV 90 and 120 km/h range and efficiency data from Range sheet", ""},
+      sheet_handler("get_range_data"));
+  chat_tools.add({"get_1000km_data", "Get EV 1000 km challenge dataset", ""},
+                 sheet_handler("get_1000km_data"));
+  chat_tools.add(
+      {"get_charging_curve_data",
+       "Get EV charging power by SoC from Charging curve sheet as transposed CSV",
+       ""},
+      sheet_handler("get_charging_curve_data"));
+
+  chat_tools.add(
+      {"query_sheet",
+       "Look up rows in an EV test sheet without fetching the whole dataset. Prefer this over the get_*_data tools for questions about specific cars or top lists. filters: column, op (contains, eq, ne, lt, le, gt, ge) and value; all must match; contains ignores case. columns: which columns to return (the car column is always included). sort_by with order asc or desc, limit rows (default 10). An unknown column returns the list of columns. Example: 120 km/h range of the EV9 => {\"sheet\":\"Range\",\"filters\":[{\"column\":\"Model\",\"op\":\"contains\",\"value\":\"EV9\"}]}.",
+       R"({"type":"object","properties":{"sheet":{"type":"string","enum":["Banana","Weight","Acceleration","Noise","Range","1000 km","Charging curve"]},"columns":{"type":"array","items":{"type":"string"}},"filters":{"type":"array","items":{"type":"object","properties":{"column":{"type":"string"},"op":{"type":"string","enum":["contains","eq","ne","lt","le","gt","ge"]},"value":{"type":["string","number"]}},"required":["column","value"]}},"sort_by":{"type":"string"},"order":{"type":"string","enum":["asc","desc"]},"limit":{"type":"integer","minimum":1,"maximum":50}},"required":["sheet"]})"},
+      [this](ToolRequestContext &, const std::string &arguments_json) {
+        return run_sheet_query_tool(arguments_json);
+      });
+
+  chat_tools.add(
+      {"lookup_vehicle",
+       "Everything the test sheets have on one vehicle: its rows from every sheet (range, weight, noise, acceleration, trunk, 1000 km, charging curve) in one record. Use it for general questions about a car. Names are matched loosely, e.g. \"model y\" or \"ioniq 5\".",
+       R"({"type":"object","properties":{"vehicle":{"type":"string","description":"Vehicle name or part of it"}},"required":["vehicle"]})"},
+      [this](ToolRequestContext &, const std::string &arguments_json) {
+        return run_vehicle_lookup_tool(arguments_json);
+      });
+
+  chat_tools.add(
+      {"sheet_history",
+       "Past versions of an EV test sheet. Without dates: when the sheet changed. With only to (YYYY-MM-DD): the sheet as it was at the end of that day. With from: what changed from the start of that day until the end of to, or until now. Example: changes to the Range sheet since March => {\"sheet\":\"Range\",\"from\":\"2026-03-01\"}.",
+       R"({"type":"object","properties":{"sheet":{"type":"string","enum":["Banana","Weight","Acceleration","Noise","Range","1000 km","Charging curve"]},"from":{"type":"string","description":"YYYY-MM-DD"},"to":{"type":"string","description":"YYYY-MM-DD"}},"required":["sheet"]})"},
+      [this](ToolRequestContext &, const std::string &arguments_json) {
+        return run_sheet_history_tool(arguments_json);
+      });
+
+  chat_tools.add(
+      {"get_youtube_stream_status",
+       "Check whether the tracked YouTube stream is currently live. If live, returns the current stream title.",
+       ""},
+      [this](ToolRequestContext &, const std::string &) {
+        return run_stream_status_tool();
+      });
+
+  chat_tools.add(
+      {"get_webpage_text",
+       "Fetch and extract readable text from a public webpage. Use this when the user asks to summarize or answer questions about a URL.",
+       R"({"type":"object","properties":{"url":{"type":"string","description":"Absolute http/https URL to fetch"}},"required":["url"]})"},
+      [this](ToolRequestContext &context, const std::string &arguments_json) {
+        return run_webpage_tool(context, arguments_json);
+      });
+
+  const LlmService::ToolDefinition summarize_video_definition{
+      "summarize_video",
+      "Summarize a public online video URL by transcribing audio and producing a concise summary.",
+      R"({"type":"object","properties":{"url":{"type":"string","description":"Absolute http/https video URL to summarize"}},"required":["url"]})"};
+
+  chat_tools.add(summarize_video_definition,
+                 [this](ToolRequestContext &context,
+                        const std::string &arguments_json) {
+                   return run_video_tool(context, arguments_json, true);
+                 });
+
+  chat_tools.add(
+      {"query_channel_analytics",
+       "Run generic channel/server analytics. scope: channel or server. kind: leaderboard or time_series. target: reactions or messages. group_by: leaderboard => emoji, message, reactor, recipient, author. time_series => day, week, month. filters.emojis: array of emoji tokens like 🤡, :copium:, <:1Head:123>. time_range: all_time, last_7d, last_30d, this_month, last_month. Examples: most used reactions => {\"scope\":\"server\",\"kind\":\"leaderboard\",\"target\":\"reactions\",\"group_by\":\"emoji\",\"time_range\":\"all_time\",\"limit\":10}. most clown posts => {\"scope\":\"server\",\"kind\":\"leaderboard\",\"target\":\"messages\",\"group_by\":\"message\",\"time_range\":\"all_time\",\"filters\":{\"emojis\":[\"🤡\"]},\"limit\":10}. stats for multiple emojis => {\"scope\":\"server\",\"kind\":\"leaderboard\",\"target\":\"reactions\",\"group_by\":\"emoji\",\"filters\":{\"emojis\":[\"🤡\",\":copium:\",\":1Head:\",\":3Head:\"]},\"time_range\":\"all_time\",\"limit\":20}.",
+       R"({"type":"object","properties":{"scope":{"type":"string","enum":["channel","server"]},"kind":{"type":"string","enum":["leaderboard","time_series"]},"target":{"type":"string","enum":["reactions","messages"]},"group_by":{"type":"string","enum":["emoji","message","reactor","recipient","author","day","week","month"]},"time_range":{"type":"string","enum":["all_time","last_7d","last_30d","this_month","last_month"]},"filters":{"type":"object","properties":{"emojis":{"type":"array","items":{"type":"string"}}}},"limit":{"type":"integer","minimum":1,"maximum":120}},"required":["kind","target","group_by"]})"},
+      [this](ToolRequestContext &context, const std::string &arguments_json) {
+        return run_analytics_tool(context, arguments_json);
+      });
+
+  chat_tools.add(
+      {"calculate_with_bc",
+       "Evaluate a mathematical expression using bc -l for accurate calculations. Supports arithmetic and bc math functions like sqrt(x), l(x), e(x), s(x), c(x), a(x), j(n,x).",
+       R"({"type":"object","properties":{"expression":{"type":"string","description":"Mathematical expression to evaluate"},"scale":{"type":"integer","description":"Optional decimal precision (0-100). Defaults to 10."}},"required":["expression"]})"},
+      [this](ToolRequestContext &, const std::string &arguments_json) {
+        return run_calculation_tool(arguments_json);
+      });
+
+  chat_tools.add(
+      {"search_messages",
+       "Full-text search over all stored messages. Use it to find when something was said or who mentioned a topic. scope: channel or server (default server). sort: relevance or newest. time_range: all_time, last_7d, last_30d, this_month, last_month. author: optional user name.",
+       R"({"type":"object","properties":{"query":{"type":"string","description":"Words or phrase to search for, at least 3 characters"},"scope":{"type":"string","enum":["channel","server"]},"author":{"type":"string"},"sort":{"type":"string","enum":["relevance","newest"]},"time_range":{"type":"string","enum":["all_time","last_7d","last_30d","this_month","last_month"]},"limit":{"type":"integer","minimum":1,"maximum":20}},"required":["query"]})"},
+      [this](ToolRequestContext &context, const std::string &arguments_json) {
+        return run_message_search_tool(context, arguments_json);
+      });
+
+  if (message_index.enabled()) {
+    chat_tools.add(
+        {"search_history",
+         "Semantic search over older messages on this server that are not in the recent history. Use it when the user refers to an earlier discussion.",
+         R"({"type":"object","properties":{"query":{"type":"string","description":"What the earlier discussion was about"},"limit":{"type":"integer","minimum":1,"maximum":8}},"required":["query"]})"},
+        [this](ToolRequestContext &context, const std::string &arguments_json) {
+          return run_history_search_tool(context, arguments_json);
+        });
+  }
+
+  summary_tools.add(summarize_video_definition,
+                    [this](ToolRequestContext &context,
+                           const std::string &arguments_json) {
+                      return run_video_tool(context, arguments_json, false);
+                    });
+
+  bot.log(dpp::ll_info,
+          std::format("Registered {} chat tools ({} schema bytes)",
+                      chat_tools.size(), chat_tools.serialized_bytes()));
+}
+
+dpp::task<std::optional<std::string>> DiscordEventService::try_intent_fast_path(
+    const ToolRequestContext &request_context, const std::string &content,
+    const std::string &prompt) const {
+  const auto intent = intent_matcher.match(content);
+  if (!intent.has_value() || !chat_tools.contains(intent->tool_name))
+    co_return std::nullopt;
+
+  bot.log(dpp::ll_info,
+          std::format("Intent fast path: rule={} tool={} args={}", intent->rule,
+                      intent->tool_name, intent->arguments_json));
+
+  // Separate limits, so a failed fast path leaves the full loop its budget.
+  ToolRequestContext fast_context{.channel_id = request_context.channel_id,
+                                  .server_id = request_context.server_id};
+  const std::string tool_output = co_await execute_chat_tool(
+      fast_context, intent->tool_name, intent->arguments_json);
+  if (tool_output.starts_with("Tool error:")) {
+    bot.log(dpp::ll_info,
+            std::format("Intent fast path fell back after tool error: {}",
+                        tool_output));
+    co_return std::nullopt;
+  }
+
+  std::string answer = llm_service.generate_text_from_tool_result(
+      prompt, intent->tool_name, intent->arguments_json, tool_output);
+  if (answer.empty())
+    co_return std::nullopt;
+  co_return answer;
+}
+
+void DiscordEventService::start_tool_prefetch(ToolRequestContext &context,
+                                              const std::string &content) const {
+  const auto url = extract_first_url(content);
+  if (!url.has_value())
+    return;
+
+  // A video summary holds the shared webpage/video slot for minutes, which
+  // is too long to lock other users out for a result that may go unused.
+  if (is_youtube_url(*url))
+    return;
+
+  const std::string tool_name = "get_webpage_text";
+  ollama::json args = ollama::json::object();
+  args["url"] = *url;
+  const std::string arguments_json = args.dump();
+
+  bot.log(dpp::ll_info,
+          std::format("Prefetching {} for {}", tool_name, *url));
+
+  context.prefetch.emplace(ToolPrefetch{
+      tool_name, arguments_json,
+      run_prefetch(tool_name, arguments_json, context.channel_id,
+                   context.server_id, context.heavy_tools_running)});
+}
+
+dpp::task<std::string>
+DiscordEventService::run_prefetch(std::string tool_name,
+                                  std::string arguments_json,
+                                  dpp::snowflake channel_id,
+                                  dpp::snowflake server_id,
+                                  std::shared_ptr<std::atomic<int>>
+                                      heavy_tools_running) const {
+  // Own limits: a speculative fetch must not use up the request's calls
+  // unless the model actually asks for it. The heavy-tool slot is shared, so
+  // the request's own webpage or video call is not refused while the
+  // prefetch holds it.
+  ToolRequestContext prefetch_context{
+      .channel_id = channel_id,
+      .server_id = server_id,
+      .heavy_tools_running = std::move(heavy_tools_running)};
+  co_return co_await execute_chat_tool(prefetch_context, tool_name,
+                                       arguments_json);
+}
+
+dpp::task<std::string> DiscordEventService::execute_chat_tool(
+    ToolRequestContext &context, const std::string &tool_name,
+    const std::string &raw_arguments_json) const {
+  std::string arguments_json = raw_arguments_json;
+  if (context.aliases != nullptr) {
+    std::lock_guard lock(context.aliases_mutex);
+    arguments_json = context.aliases->restore_arguments(raw_arguments_json);
+  }
+  // Applied after the cache: handles are per request, cached output is not.
+  const auto alias_output = [&context, &tool_name](std::string output) {
+    if (context.aliases == nullptr || tool_name != "search_messages")
+      return output;
+    std::lock_guard lock(context.aliases_mutex);
+    return context.aliases->alias_tool_output(output);
+  };
+
+  if (context.prefetch.has_value() && !context.prefetch->consumed &&
+      context.prefetch->tool_name == tool_name &&
+      context.prefetch->canonical_arguments ==
+          canonicalize_tool_arguments(arguments_json)) {
+    if (auto limited = take_limited_call(context, tool_name)) {
+      co_return std::move(*limited);
+    }
+    context.prefetch->consumed = true;
+    bot.log(dpp::ll_info,
+            std::format("Tool prefetch handed over: {}", tool_name));
+    co_return co_await context.prefetch->task;
+  }
+
+  const auto ttl = tool_cache_ttl(tool_name);
+  if (!ttl.has_value()) {
+    co_return co_await chat_tools.dispatch(context, tool_name, arguments_json);
+  }
+
+  const std::string scope =
+      tool_name == "query_channel_analytics" || tool_name == "search_messages"
+          ? std::format("{}/{}", context.server_id.str(),
+                        context.channel_id.str())
+          : std::string{};
+  const std::string key = ToolResultCache::make_key(
+      tool_name, canonicalize_tool_arguments(arguments_json), scope);
+
+  const std::string group = tool_cache_group(tool_name, context.server_id);
+  // Taken before the call, so a result computed before an invalidation is
+  // not stored afterwards.
+  const auto generation = tool_result_cache.generation(group);
+  const auto cached = tool_result_cache.get(key);
+  const auto stats = tool_result_cache.stats();
+  bot.log(dpp::ll_info,
+          std::format("Tool cache {}: {} hit_rate={:.1f}% hits={} misses={} "
+                      "entries={} bytes={}",
+                      cached.has_value() ? "hit" : "miss", tool_name,
+                      stats.hit_rate() * 100.0, stats.hits, stats.misses,
+                      stats.entries, stats.bytes));
+  if (cached.has_value()) {
+    if (auto limited = take_limited_call(context, tool_name)) {
+      co_return std::move(*limited);
+    }
+    co_return alias_output(*cached);
+  }
+
+  std::string output =
+      co_await chat_tools.dispatch(context, tool_name, arguments_json);
+  if (!output.starts_with("Tool error:")) {
+    tool_result_cache.put(key, group, output, *ttl, generation);
+  }
+  co_return alias_output(std::move(output));
+}
+
+dpp::task<std::string>
+DiscordEventService::run_webpage_tool(ToolRequestContext &context,
+                                      const std::string &arguments_json) const {
+  if (context.webpage_calls >= 1) {
+    co_return "Tool error: only one webpage fetch is allowed per request.";
+  }
+
+  std::string requested_url;
+  try {
+    ollama::json args = ollama::json::parse(arguments_json);
+    if (args.contains("url") && args["url"].is_string()) {
+      requested_url = args["url"].get<std::string>();
+    }
+  } catch (...) {
+    co_return "Tool error: invalid tool arguments JSON.";
+  }
+
+  if (requested_url.empty()) {
+    co_return "Tool error: missing required argument 'url'.";
+  }
+
+  HeavyToolGuard guard(heavy_tool_running, *context.heavy_tools_running);
+  if (!guard.owns_lock()) {
+    co_return "Tool error: another webpage/video summary task is already running.";
+  }
+
+  context.webpage_calls += 1;
+  co_return co_await web_page_service.fetch_webpage_text(requested_url);
+}
+
+dpp::task<std::string>
+DiscordEventService::run_video_tool(ToolRequestContext &context,
+                                    const std::string &arguments_json,
+                                    bool exclusive) const {
+  if (context.video_calls >= 1) {
+    co_return "Tool error: only one video summary is allowed per request.";
+  }
+
+  std::string requested_url;
+  try {
+    ollama::json args = ollama::json::parse(arguments_json);
+    if (args.contains("url") && args["url"].is_string()) {
+      requested_url = args["url"].get<std::string>();
+    }
+  } catch (...) {
+    co_return "Tool error: invalid tool arguments JSON.";
+  }
+
+  if (requested_url.empty()) {
+    co_return "Tool error: missing required argument 'url'.";
+  }
+
+  // The queued carl-bot summaries run one at a time already and do not
+  // compete for the interactive webpage/video slot.
+  std::optional<HeavyToolGuard> guard;
+  if (exclusive) {
+    guard.emplace(heavy_tool_running, *context.heavy_tools_running);
+    if (!guard->owns_lock()) {
+      co_return "Tool error: another webpage/video summary task is already running.";
+    }
+  }
+
+  context.video_calls += 1;
+  co_return co_await video_summary_service.summarize_video(requested_url);
+}
+
+dpp::task<std::string> DiscordEventService::run_calculation_tool(
+    const std::string &arguments_json) const {
+  std::string expression;
+  int scale = 10;
+  try {
+    ollama::json args = ollama::json::parse(arguments_json);
+    if (args.contains("expression") && args["expression"].is_string()) {
+      expression = args["expression"].get<std::string>();
+    }
+    if (args.contains("scale") && args["scale"].is_number_integer()) {
+      scale = args["scale"].get<int>();
+    }
+  } catch (...) {
+    co_return "Tool error: invalid tool arguments JSON.";
+  }
+
+  if (expression.empty()) {
+    co_return "Tool error: missing required argument 'expression'.";
+  }
+
+  co_return co_await calculation_service.calculate_with_bc(expression, scale);
+}
+
+dpp::task<std::string>
+DiscordEventService::run_analytics_tool(ToolRequestContext &context,
+                                        const std::string &arguments_json) const {
+  if (context.analytics_calls >= 1) {
+    co_return "Tool error: only one analytics query is allowed per request. Use the previous tool result to answer.";
+  }
+
+  const auto parsed = analytics_query::parse_and_compile(arguments_json);
+  if (!parsed.ok()) {
+    co_return std::format("Tool error: invalid analytics request: {}",
+                          parsed.error);
+  }
+
+  context.analytics_calls += 1;
+
+  const dpp::snowflake channel_id = context.channel_id;
+  const dpp::snowflake server_id = context.server_id;
+
+  bot.log(dpp::ll_info,
+          std::format("Executing analytics query in {} {} target={} group_by={} "
+                      "range={} limit={} sql={}",
+                      parsed.query->scope == "server" ? server_id.str()
+                                                       : channel_id.str(),
+                      parsed.query->kind, parsed.query->target,
+                      parsed.query->group_by, parsed.query->time_range,
+                      parsed.query->limit, parsed.query->sql));
+
+  // The query blocks on the database; run it on the work queue so it can
+  // overlap with other tool calls from the same turn.
+  co_return co_await dpp::async<std::string>(
+      [&](std::function<void(std::string)> cb) {
+        bot.queue_work(10, [cb = std::move(cb), channel_id, server_id,
+                            query = *parsed.query]() mutable {
+          cb(dbops::run_compiled_channel_analytics_query(channel_id, server_id,
+                                                         query));
+        });
+      });
+}
+
+dpp::task<std::string> DiscordEventService::run_message_search_tool(
+    ToolRequestContext &context, const std::string &arguments_json) const {
+  const auto parsed = message_search::parse_and_compile(arguments_json);
+  if (!parsed.ok()) {
+    co_return std::format("Tool error: invalid search request: {}", parsed.error);
+  }
+
+  const dpp::snowflake channel_id = context.channel_id;
+  const dpp::snowflake server_id = context.server_id;
+
+  bot.log(dpp::ll_info,
+          std::format("Executing message search in {} scope={} sort={} range={} "
+                      "limit={} query='{}'",
+                      parsed.search->scope == "server" ? server_id.str()
+                                                        : channel_id.str(),
+                      parsed.search->scope, parsed.search->sort,
+                      parsed.search->time_range, parsed.search->limit,
+                      parsed.search->query));
+
+  const auto started = std::chrono::steady_clock::now();
+  auto output = co_await dpp::async<std::string>(
+      [&](std::function<void(std::string)> cb) {
+        bot.queue_work(10, [cb = std::move(cb), channel_id, server_id,
+                            search = *parsed.search]() mutable {
+          cb(dbops::run_message_search(channel_id, server_id, search));
+        });
+      });
+  bot.log(dpp::ll_info,
+          std::format("Message search finished in {} ms, output_bytes={}",
+                      std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::steady_clock::now() - started)
+                          .count(),
+                      output.size()));
+  co_return output;
+}
+
+dpp::task<std::string> DiscordEventService::run_history_search_tool(
+    ToolRequestContext &context, const std::string &arguments_json) const {
+  std::string query;
+  std::size_t limit = 5;
+  try {
+    ollama::json args = ollama::json::parse(arguments_json);
+    if (args.contains("query") && args["query"].is_string()) {
+      query = args["query"].get<std::string>();
+    }
+    if (args.contains("limit") && args["limit"].is_number_integer()) {
+      limit = static_cast<std::size_t>(std::clamp(args["limit"].get<int>(), 1, 8));
+    }
+  } catch (...) {
+    co_return "Tool error: invalid tool arguments JSON.";
+  }
+
+  if (query.empty()) {
+    co_return "Tool error: missing required argument 'query'.";
+  }
+
+  // The recent history is already in the prompt. Database calls block, so
+  // they run on the work queue like the other history tools.
+  using MessageIds = std::vector<std::uint64_t>;
+  auto exclude_ids = co_await dpp::async<MessageIds>(
+      [&](std::function<void(MessageIds)> cb) {
+        bot.queue_work(10, [cb = std::move(cb), channel_id = context.channel_id,
+                            max_history = config.max_history]() mutable {
+          cb(dbops::fetch_recent_message_ids(channel_id, max_history));
+        });
+      });
+  const auto hits = co_await message_index.search(
+      query, context.server_id, std::move(exclude_ids), limit);
+  if (hits.empty()) {
+    co_return "No related older messages found.";
+  }
+
+  co_return co_await dpp::async<std::string>(
+      [&](std::function<void(std::string)> cb) {
+        bot.queue_work(10, [cb = std::move(cb), &hits]() mutable {
+          std::vector<std::int64_t> ids;
+          ids.reserve(hits.size());
+          for (const auto &hit : hits)
+            ids.push_back(static_cast<std::int64_t>(hit.id));
+          const auto rows = dbops::fetch_messages_by_ids(ids);
+
+          std::unordered_map<std::uint64_t, pqxx::row> by_id;
+          for (const auto &row : rows)
+            by_id.emplace(row["message_id"].as<std::uint64_t>(), row);
+
+          std::string output = "Related older messages, best match first:";
+          for (const auto &hit : hits) {
+            const auto it = by_id.find(hit.id);
+            if (it == by_id.end())
+              continue;
+            std::string content = it->second["content"].as<std::string>();
+            if (content.size() > 300) {
+              content.resize(300);
+              content += "...";
+            }
+            output += std::format("\n[{}] #{} {} (score {:.2f}): {}",
+                                  it->second["created_at"].as<std::string>(),
+                                  it->second["channel_name"].as<std::string>(),
+                                  it->second["user_name"].as<std::string>(),
+                                  hit.score, content);
+          }
+          cb(std::move(output));
+        });
+      });
+}
+
+dpp::task<std::string> DiscordEventService::run_stream_status_tool() const {
+  const auto status = youtube_service.get_stream_status();
+  ollama::json payload = ollama::json::object();
+  payload["is_live"] = status.is_live;
+  if (status.is_live && !status.title.empty()) {
+    payload["title"] = status.title;
+  }
+  co_return payload.dump();
+}
+
+dpp::task<std::string>
+DiscordEventService::run_sheet_query_tool(const std::string &arguments_json) const {
+  const auto parsed = sheet_query::parse(arguments_json);
+  if (!parsed.ok()) {
+    co_return std::format("Tool error: invalid sheet query: {}", parsed.error);
+  }
+
+  const auto tab = google_docs_service.find_sheet(parsed.query->sheet);
+  if (!tab) {
+    co_return std::format("Tool error: dataset '{}' is not loaded",
+                          parsed.query->sheet);
+  }
+
+  // The tab is parsed already, so the query runs inline in microseconds.
+  const auto started = std::chrono::steady_clock::now();
+  auto result = sheet_query::run(*tab, *parsed.query);
+  const auto elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                              std::chrono::steady_clock::now() - started)
+                              .count();
+  if (!result.error.empty()) {
+    co_return std::format("Tool error: {}", result.error);
+  }
+
+  const std::size_t full_bytes = tab->csv->size();
+  bot.log(dpp::ll_info,
+          std::format("Sheet query on {} took {} us: matched={} returned={} "
+                      "output_bytes={} full_sheet_bytes={} saved_tokens~{}",
+                      tab->name, elapsed_us, result.matched_rows,
+                      result.returned_rows, result.output.size(), full_bytes,
+                      full_bytes > result.output.size()
+                          ? static_cast<std::size_t>(
+                                (full_bytes - result.output.size()) / 3.5)
+                          : 0));
+  co_return std::move(result.output);
+}
+
+dpp::task<std::string> DiscordEventService::run_vehicle_lookup_tool(
+    const std::string &arguments_json) const {
+  std::string vehicle;
+  try {
+    ollama::json args = ollama::json::parse(arguments_json);
+    if (args.contains("vehicle") && args["vehicle"].is_string()) {
+      vehicle = args["vehicle"].get<std::string>();
+    }
+  } catch (...) {
+    co_return "Tool error: invalid tool arguments JSON.";
+  }
+  if (vehicle.empty() || vehicle.size() > 100) {
+    co_return "Tool error: missing or too long argument 'vehicle'.";
+  }
+
+  const auto started = std::chrono::steady_clock::now();
+  auto output = google_docs_service.lookup_vehicle(vehicle);
+  bot.log(dpp::ll_info,
+          std::format("Vehicle lookup '{}' took {} us, output_bytes={}", vehicle,
+                      std::chrono::duration_cast<std::chrono::microseconds>(
+                          std::chrono::steady_clock::now() - started)
+                          .count(),
+                      output.size()));
+  co_return output;
+}
+
+dpp::task<std::string> DiscordEventService::run_sheet_history_tool(
+    const std::string &arguments_json) const {
+  std::string sheet;
+  std::optional<SheetHistory::TimePoint> from;
+  std::optional<SheetHistory::TimePoint> to;
+  try {
+    ollama::json args = ollama::json::parse(arguments_json);
+    if (args.contains("sheet") && args["sheet"].is_string()) {
+      sheet = args["sheet"].get<std::string>();
+    }
+    for (const auto &[name, date] : {std::pair{"from", &from},
+                                     std::pair{"to", &to}}) {
+      if (!args.contains(name)) {
+        continue;
+      }
+      if (!args[name].is_string() ||
+          !(*date = parse_history_date(args[name].get<std::string>()))) {
+        co_return std::format("Tool error: '{}' must be a date as YYYY-MM-DD.",
+                              name);
+      }
+    }
+  } catch (...) {
+    co_return "Tool error: invalid tool arguments JSON.";
+  }
+  if (sheet.empty()) {
+    co_return "Tool error: missing required argument 'sheet'.";
+  }
+  if (from && to && *from > *to) {
+    co_return "Tool error: 'from' is after 'to'.";
+  }
+
+  // Rebuilding a version reads the log file, so it runs on the work queue.
+  const auto started = std::chrono::steady_clock::now();
+  auto output = co_await dpp::async<std::string>(
+      [&](std::function<void(std::string)> cb) {
+        bot.queue_work(10, [cb = std::move(cb), &docs = google_docs_service,
+                            sheet, from, to]() mutable {
+          cb(docs.sheet_history(sheet, from, to));
+        });
+      });
+  if (output.empty()) {
+    co_return std::format("Tool error: no history recorded for '{}'", sheet);
+  }
+  bot.log(dpp::ll_info,
+          std::format("Sheet history for {} took {} ms, output_bytes={}", sheet,
+                      std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::steady_clock::now() - started)
+                          .count(),
+                      output.size()));
+  co_return output;
+}
+
+dpp::task<std::string>
+DiscordEventService::run_sheet_tool(const std::string &tab_name,
+                                    bool transpose) const {
+  auto csv_data = google_docs_service.get_sheet_csv_by_tab_name(tab_name, transpose);
+  if (!csv_data) {
+    co_return std::format("Tool error: dataset '{}' is not loaded", tab_name);
+  }
+
+  const std::string data_label = transpose ? "Transposed CSV data" : "CSV data";
+  co_return std::format("Dataset: {}\n{}:\n{}", tab_name, data_label, *csv_data);
+}
 
 std::string
-DiscordEventService::format_message_history(dpp::snowflake channel_id) const {
+DiscordEventService::format_message_history(dpp::snowflake channel_id,
+                                            SnowflakeAliases &aliases) const {
+  using Kind = SnowflakeAliases::Kind;
   std::string message_history{};
 
+  // Older history lives in the rolling summary kept by
+  // ConversationSummaryService.
+  try {
+    const auto summary = dbops::fetch_channel_summary(channel_id);
+    if (summary.has_value() && !summary->summary.empty()) {
+      message_history = std::format(
+          "Summary of earlier conversation in this channel:\n{}\n",
+          aliases.alias_mentions(summary->summary));
+    }
+  } catch (const std::exception &e) {
+    bot.log(dpp::ll_warning,
+            std::format("Could not load channel summary: {}", e.what()));
+  }
+
   auto res = dbops::fetch_channel_history(channel_id, config.max_history);
   if (!res.empty()) {
-    message_history = "Channel message history:";
+    message_history +=
+        "Ids are short handles: mN for messages, uN for users. Mention a user "
+        "as <@uN>.\nChannel message history:";
 
     for (auto message : res | std::views::reverse) {
       message_history +=
@@ -115,11 +934,14 @@ DiscordEventService::format_message_history(dpp::snowflake channel_id) const {
                       "Author: {}\n"
                       "Timestamp: {}\n"
                       "Message content: {}",
-                      message["message_snowflake_id"].as<std::string>(),
-                      message["reply_to_snowflake_id"].as<std::string>(),
-                      message["user_snowflake_id"].as<std::string>(),
+                      aliases.alias(Kind::Message,
+                                    message["message_snowflake_id"].as<std::string>()),
+                      aliases.alias(Kind::Message,
+                                    message["reply_to_snowflake_id"].as<std::string>()),
+                      aliases.alias(Kind::User,
+                                    message["user_snowflake_id"].as<std::string>()),
                       message["created_at"].as<std::string>(),
-                      message["content"].as<std::string>());
+                      aliases.alias_mentions(message["content"].as<std::string>()));
 
       auto react_res =
           dbops::fetch_reactions_for_message(message["message_id"].as<std::uint64_t>());
@@ -128,7 +950,8 @@ DiscordEventService::format_message_history(dpp::snowflake channel_id) const {
         for (auto reaction : react_res) {
           message_history +=
               std::format("\nReaction by {}: {}",
-                          reaction["user_snowflake_id"].as<std::string>(),
+                          aliases.alias(Kind::User,
+                                        reaction["user_snowflake_id"].as<std::string>()),
                           reaction["reaction"].as<std::string>());
         }
       }
@@ -146,7 +969,80 @@ DiscordEventService::format_message_history(dpp::snowflake channel_id) const {
   return message_history;
 }
 
-std::string DiscordEventService::format_replyto_message(const Message &msg) const {
+// Ancestors of the message being replied to, so a reply to an old message
+// carries its thread. Bounded by depth and bytes; messages already in the
+// history are only referenced by handle.
+std::string
+DiscordEventService::format_reply_thread(const Message &msg,
+                                         SnowflakeAliases &aliases) const {
+  using Kind = SnowflakeAliases::Kind;
+  constexpr int max_depth = 8;
+  constexpr std::size_t max_thread_bytes = 3000;
+  constexpr std::size_t max_content_bytes = 500;
+
+  if (msg.msg_replied_to.empty())
+    return {};
+
+  pqxx::result chain;
+  try {
+    chain = dbops::fetch_reply_chain(msg.msg_replied_to, max_depth);
+  } catch (const std::exception &e) {
+    bot.log(dpp::ll_warning,
+            std::format("Could not load reply thread: {}", e.what()));
+    return {};
+  }
+
+  // Rows come nearest first; keep the nearest ones within budget and print
+  // them oldest first.
+  std::vector<std::string> entries;
+  std::size_t thread_bytes = 0;
+  for (const auto &row : chain) {
+    const std::string message_id = row["message_snowflake_id"].as<std::string>();
+    std::string entry;
+    if (aliases.contains(Kind::Message, message_id)) {
+      entry = std::format("Message id: {} (in the history above)",
+                          aliases.alias(Kind::Message, message_id));
+    } else {
+      std::string content = row["content"].as<std::string>();
+      if (content.size() > max_content_bytes) {
+        content.resize(max_content_bytes);
+        content += "...";
+      }
+      entry = std::format(
+          "Message id: {}\nReply to message id: {}\nAuthor: {}\n"
+          "Timestamp: {}\nMessage content: {}",
+          aliases.alias(Kind::Message, message_id),
+          aliases.alias(Kind::Message,
+                        row["reply_to_snowflake_id"].as<std::string>()),
+          aliases.alias(Kind::User, row["user_snowflake_id"].as<std::string>()),
+          row["created_at"].as<std::string>(), aliases.alias_mentions(content));
+    }
+    if (thread_bytes + entry.size() > max_thread_bytes)
+      break;
+    thread_bytes += entry.size();
+    entries.push_back(std::move(entry));
+  }
+
+  if (entries.empty())
+    return {};
+
+  bot.log(dpp::ll_info,
+          std::format("Reply thread: depth={} of {} fetched, bytes={}",
+                      entries.size(), chain.size(), thread_bytes));
+
+  std::string thread = "\nReply thread leading to the message you reply to, "
+                       "oldest first:";
+  for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+    thread += "\n----------------------\n" + *it;
+  }
+  thread += "\n----------------------\n";
+  return thread;
+}
+
+std::string
+DiscordEventService::format_replyto_message(const Message &msg,
+                                            SnowflakeAliases &aliases) const {
+  using Kind = SnowflakeAliases::Kind;
   std::string message_text =
       std::format("\nThe message you reply to:\n"
                   "----------------------\n"
@@ -154,8 +1050,10 @@ std::string DiscordEventService::format_replyto_message(const Message &msg) cons
                   "Author: {}\n"
                   "Message content: {}"
                   "\n----------------------\n",
-                  msg.msg_id.str(), msg.msg_replied_to.str(), msg.author.str(),
-                  msg.content);
+                  aliases.alias(Kind::Message, msg.msg_id.str()),
+                  aliases.alias(Kind::Message, msg.msg_replied_to.str()),
+                  aliases.alias(Kind::User, msg.author.str()),
+                  aliases.alias_mentions(msg.content));
 
   return message_text;
 }
@@ -164,6 +1062,12 @@ void DiscordEventService::store_message(const Message &message, dpp::guild *serv
                                         dpp::channel *channel,
                                         const std::string &user_name) const {
   auto ids = dbops::store_message(message, server, channel, user_name);
+
+  std::string index_text = message.content;
+  for (const auto &description : message.image_descriptions)
+    index_text += "\n" + description;
+  message_index.enqueue(static_cast<std::uint64_t>(ids.message_id), server->id,
+                        channel->id, std::move(index_text));
   bot.log(dpp::ll_info,
           std::format("server_id: {} channel id: {} user_id: {}, message_id {}",
                       ids.server_id, ids.channel_id, ids.user_id,
@@ -227,9 +1131,22 @@ DiscordEventService::handle_message(const dpp::message_create_t &event) {
     answer = false;
   }
 
+  std::optional<dpp::task<std::string>> unused_prefetch;
+
   if (answer) {
     const dpp::snowflake request_channel_id = event.msg.channel_id;
     const dpp::snowflake request_server_id = event.msg.guild_id;
+
+    // Start fetching a linked web page while the prompt is assembled and the
+    // first LLM call runs; the tool call hands the result over.
+    SnowflakeAliases aliases;
+    ToolRequestContext tool_context{.channel_id = request_channel_id,
+                                    .server_id = request_server_id};
+    tool_context.aliases = &aliases;
+    if (imagelist.empty()) {
+      start_tool_prefetch(tool_context, event.msg.content);
+    }
+
     std::string guild_emoji_context =
         "Available guild emojis (custom only): unavailable\n";
 
@@ -268,215 +1185,84 @@ DiscordEventService::handle_message(const dpp::message_create_t &event) {
         "- Bad: :unknown_custom:\n"
         "- Good: ⚡\n";
 
-    const std::vector<LlmService::ToolDefinition> available_tools = {
-        {"get_banana_data", "Get EV trunk size dataset from Banana sheet", ""},
-        {"get_weight_data", "Get EV vehicle weight dataset from Weight sheet", ""},
-        {"get_acceleration_data",
-         "Get EV acceleration dataset from Acceleration sheet", ""},
-        {"get_noise_data", "Get EV vehicle noise dataset from Noise sheet", ""},
-        {"get_range_data",
-         "Get EV 90 and 120 km/h range and efficiency data from Range sheet", ""},
-        {"get_1000km_data", "Get EV 1000 km challenge dataset", ""},
-        {"get_charging_curve_data",
-         "Get EV charging power by SoC from Charging curve sheet as transposed CSV", ""},
-        {"get_youtube_stream_status",
-         "Check whether the tracked YouTube stream is currently live. If live, returns the current stream title.",
-         ""},
-        {"get_webpage_text",
-         "Fetch and extract readable text from a public webpage. Use this when the user asks to summarize or answer questions about a URL.",
-         R"({"type":"object","properties":{"url":{"type":"string","description":"Absolute http/https URL to fetch"}},"required":["url"]})"},
-        {"summarize_video",
-         "Summarize a public online video URL by transcribing audio and producing a concise summary.",
-         R"({"type":"object","properties":{"url":{"type":"string","description":"Absolute http/https video URL to summarize"}},"required":["url"]})"},
-        {"query_channel_analytics",
-         "Run generic channel/server analytics. scope: channel or server. kind: leaderboard or time_series. target: reactions or messages. group_by: leaderboard => emoji, message, reactor, recipient, author. time_series => day, week, month. filters.emojis: array of emoji tokens like 🤡, :copium:, <:1Head:123>. time_range: all_time, last_7d, last_30d, this_month, last_month. Examples: most used reactions => {\"scope\":\"server\",\"kind\":\"leaderboard\",\"target\":\"reactions\",\"group_by\":\"emoji\",\"time_range\":\"all_time\",\"limit\":10}. most clown posts => {\"scope\":\"server\",\"kind\":\"leaderboard\",\"target\":\"messages\",\"group_by\":\"message\",\"time_range\":\"all_time\",\"filters\":{\"emojis\":[\"🤡\"]},\"limit\":10}. stats for multiple emojis => {\"scope\":\"server\",\"kind\":\"leaderboard\",\"target\":\"reactions\",\"group_by\":\"emoji\",\"filters\":{\"emojis\":[\"🤡\",\":copium:\",\":1Head:\",\":3Head:\"]},\"time_range\":\"all_time\",\"limit\":20}.",
-         R"({"type":"object","properties":{"scope":{"type":"string","enum":["channel","server"]},"kind":{"type":"string","enum":["leaderboard","time_series"]},"target":{"type":"string","enum":["reactions","messages"]},"group_by":{"type":"string","enum":["emoji","message","reactor","recipient","author","day","week","month"]},"time_range":{"type":"string","enum":["all_time","last_7d","last_30d","this_month","last_month"]},"filters":{"type":"object","properties":{"emojis":{"type":"array","items":{"type":"string"}}}},"limit":{"type":"integer","minimum":1,"maximum":120}},"required":["kind","target","group_by"]})"},
-        {"calculate_with_bc",
-         "Evaluate a mathematical expression using bc -l for accurate calculations. Supports arithmetic and bc math functions like sqrt(x), l(x), e(x), s(x), c(x), a(x), j(n,x).",
-         R"({"type":"object","properties":{"expression":{"type":"string","description":"Mathematical expression to evaluate"},"scale":{"type":"integer","description":"Optional decimal precision (0-100). Defaults to 10."}},"required":["expression"]})"}};
-
-    const auto webpage_tool_calls = std::make_shared<int>(0);
-    const auto video_tool_calls = std::make_shared<int>(0);
-    const auto analytics_tool_calls = std::make_shared<int>(0);
-
     const auto execute_tool =
-        [this, webpage_tool_calls, video_tool_calls,
-         analytics_tool_calls, request_channel_id,
-         request_server_id](const std::string &tool_name,
-                              const std::string &arguments_json)
-        -> dpp::task<std::string> {
-
-      static const std::map<std::string, std::string> tool_to_sheet = {
-          {"get_banana_data", "Banana"},
-          {"get_weight_data", "Weight"},
-          {"get_acceleration_data", "Acceleration"},
-          {"get_noise_data", "Noise"},
-          {"get_range_data", "Range"},
-          {"get_1000km_data", "1000 km"},
-          {"get_charging_curve_data", "Charging curve"}};
-
-      if (tool_name == "get_webpage_text") {
-        if (*webpage_tool_calls >= 1) {
-          co_return "Tool error: only one webpage fetch is allowed per request.";
-        }
+        [this, &tool_context](const std::string &tool_name,
+                              const std::string &arguments_json) {
+          return execute_chat_tool(tool_context, tool_name, arguments_json);
+        };
 
-        std::string requested_url;
-        try {
-          ollama::json args = ollama::json::parse(arguments_json);
-          if (args.contains("url") && args["url"].is_string()) {
-            requested_url = args["url"].get<std::string>();
-          }
-        } catch (...) {
-          co_return "Tool error: invalid tool arguments JSON.";
-        }
-
-        if (requested_url.empty()) {
-          co_return "Tool error: missing required argument 'url'.";
-        }
-
-        std::unique_lock<std::mutex> lock(heavy_tool_mutex, std::try_to_lock);
-        if (!lock.owns_lock()) {
-          co_return "Tool error: another webpage/video summary task is already running.";
-        }
-
-        *webpage_tool_calls += 1;
-        co_return co_await web_page_service.fetch_webpage_text(requested_url);
-      }
-
-      if (tool_name == "summarize_video") {
-        if (*video_tool_calls >= 1) {
-          co_return "Tool error: only one video summary is allowed per request.";
-        }
-
-        std::string requested_url;
-        try {
-          ollama::json args = ollama::json::parse(arguments_json);
-          if (args.contains("url") && args["url"].is_string()) {
-            requested_url = args["url"].get<std::string>();
-          }
-        } catch (...) {
-          co_return "Tool error: invalid tool arguments JSON.";
-        }
-
-        if (requested_url.empty()) {
-          co_return "Tool error: missing required argument 'url'.";
-        }
-
-        std::unique_lock<std::mutex> lock(heavy_tool_mutex, std::try_to_lock);
-        if (!lock.owns_lock()) {
-          co_return "Tool error: another webpage/video summary task is already running.";
-        }
-
-        *video_tool_calls += 1;
-        co_return co_await video_summary_service.summarize_video(requested_url);
-      }
-
-      if (tool_name == "calculate_with_bc") {
-        std::string expression;
-        int scale = 10;
-        try {
-          ollama::json args = ollama::json::parse(arguments_json);
-          if (args.contains("expression") && args["expression"].is_string()) {
-            expression = args["expression"].get<std::string>();
-          }
-          if (args.contains("scale") && args["scale"].is_number_integer()) {
-            scale = args["scale"].get<int>();
-          }
-        } catch (...) {
-          co_return "Tool error: invalid tool arguments JSON.";
-        }
-
-        if (expression.empty()) {
-          co_return "Tool error: missing required argument 'expression'.";
-        }
-
-        co_return co_await calculation_service.calculate_with_bc(expression, scale);
-      }
-
-      if (tool_name == "query_channel_analytics") {
-        if (*analytics_tool_calls >= 1) {
-          co_return "Tool error: only one analytics query is allowed per request. Use the previous tool result to answer.";
-        }
-
-        const auto parsed = analytics_query::parse_and_compile(arguments_json);
-        if (!parsed.ok()) {
-          co_return std::format("Tool error: invalid analytics request: {}",
-                                parsed.error);
-        }
-
-        *analytics_tool_calls += 1;
-
-        bot.log(dpp::ll_info,
-                std::format(
-                    "Executing analytics query in {} {} target={} group_by={} "
-                    "range={} limit={} sql={}",
-                    parsed.query->scope == "server" ? request_server_id.str()
-                                                     : request_channel_id.str(),
-                    parsed.query->kind, parsed.query->target,
-                    parsed.query->group_by, parsed.query->time_range,
-                    parsed.query->limit,
-                    parsed.query->sql));
-
-        co_return dbops::run_compiled_channel_analytics_query(
-            request_channel_id, request_server_id, *parsed.query);
-      }
-
-      if (tool_name == "get_youtube_stream_status") {
-        const auto status = youtube_service.get_stream_status();
-        ollama::json payload = ollama::json::object();
-        payload["is_live"] = status.is_live;
-        if (status.is_live && !status.title.empty()) {
-          payload["title"] = status.title;
-        }
-        co_return payload.dump();
-      }
-
-      auto it = tool_to_sheet.find(tool_name);
-      if (it == tool_to_sheet.end()) {
-        co_return std::format("Tool error: unknown tool '{}'", tool_name);
-      }
-
-      const bool transpose = tool_name == "get_charging_curve_data";
-      auto csv_data =
-          google_docs_service.get_sheet_csv_by_tab_name(it->second, transpose);
-      if (!csv_data.has_value()) {
-        co_return std::format("Tool error: dataset '{}' is not loaded", it->second);
-      }
-
-      const std::string data_label = transpose ? "Transposed CSV data" : "CSV data";
-      co_return std::format("Dataset: {}\n{}:\n{}", it->second, data_label,
-                            *csv_data);
-    };
+    // History first: the reply thread only references messages that
+    // already have a handle from it.
+    const std::string history =
+        format_message_history(event.msg.channel_id, aliases);
+    const std::string reply_thread = format_reply_thread(last_message, aliases);
 
     std::string prompt =
-        std::format("\nBot user id: {}\n", bot.me.id.str()) +
+        std::format("\nBot user id: {}\n",
+                    aliases.alias(SnowflakeAliases::Kind::User, bot.me.id.str())) +
         std::format("Channel name: \"{}\"\n", current_chan->name) +
         std::format("Current time: {:%Y-%m-%d %H:%M}\n",
                     std::chrono::zoned_time{std::chrono::current_zone(),
                                             std::chrono::system_clock::now()}) +
         emoji_output_contract +
         guild_emoji_context +
-        format_message_history(event.msg.channel_id) +
-        format_replyto_message(last_message);
+        history + reply_thread +
+        format_replyto_message(last_message, aliases);
 
     bot.log(dpp::ll_info, prompt);
+    // Same 3.5 bytes per token estimate as the num_ctx sizing.
+    const std::size_t unaliased_bytes = prompt.size() + aliases.saved_bytes();
+    bot.log(dpp::ll_info,
+            std::format("Prompt aliasing: aliases={} bytes={} -> {} "
+                        "est_tokens={} -> {}",
+                        aliases.size(), unaliased_bytes, prompt.size(),
+                        static_cast<std::size_t>(unaliased_bytes / 3.5),
+                        static_cast<std::size_t>(prompt.size() / 3.5)));
     bot.log(dpp::ll_info, std::format("Number of images: {}", imagelist.size()));
 
-    auto tool_answer =
-        co_await llm_service.generate_text_with_tools(prompt, imagelist,
-                                                      available_tools,
-                                                      execute_tool);
-    event.reply(tool_answer, true);
+    std::optional<std::string> fast_answer;
+    if (imagelist.empty()) {
+      fast_answer =
+          co_await try_intent_fast_path(tool_context, event.msg.content, prompt);
+    }
+
+    std::string tool_answer;
+    if (fast_answer.has_value()) {
+      tool_answer = std::move(*fast_answer);
+    } else {
+      tool_answer = co_await llm_service.generate_text_with_tools(
+          prompt, imagelist, chat_tools, execute_tool);
+    }
+    event.reply(aliases.restore_text(tool_answer), true);
+
+    if (tool_context.prefetch.has_value() && !tool_context.prefetch->consumed) {
+      unused_prefetch.emplace(std::move(tool_context.prefetch->task));
+    }
   }
 
   co_await handle_carlbot_video(event);
 
   store_message(last_message, current_server, current_chan,
                 event.msg.author.format_username());
+  invalidate_analytics_cache(event.msg.guild_id);
+
+  // The model did not use the prefetch. Let it finish after the reply so its
+  // result lands in the tool cache for follow-up questions.
+  if (unused_prefetch.has_value()) {
+    const auto output = co_await *unused_prefetch;
+    bot.log(dpp::ll_info,
+            std::format("Unused tool prefetch finished, cached output_bytes={}",
+                        output.size()));
+  }
 
   co_return;
 }
 
+void DiscordEventService::invalidate_analytics_cache(
+    dpp::snowflake server_id) const {
+  tool_result_cache.invalidate_group(analytics_cache_group(server_id));
+}
+
 bool DiscordEventService::is_rate_limited(dpp::snowflake user_id) const {
   const auto window =
       std::chrono::seconds(config.rate_limit_window_seconds);
@@ -549,38 +1335,12 @@ dpp::task<void> DiscordEventService::run_summary_queue(dpp::snowflake channel_id
 
     bot.log(dpp::ll_info, std::format("Processing queued YouTube video: {}", url));
 
-    const std::vector<LlmService::ToolDefinition> summary_tools = {
-        {"summarize_video",
-         "Summarize a public online video URL by transcribing audio and producing a concise summary.",
-         R"({"type":"object","properties":{"url":{"type":"string","description":"Absolute http/https video URL to summarize"}},"required":["url"]})"}};
-
-    const auto video_tool_calls = std::make_shared<int>(0);
-
+    ToolRequestContext tool_context{.channel_id = channel_id, .server_id = 0};
     const auto execute_summary_tool =
-        [this, video_tool_calls](const std::string &tool_name,
-                                 const std::string &arguments_json)
-        -> dpp::task<std::string> {
-      if (tool_name != "summarize_video")
-        co_return std::format("Tool error: unknown tool '{}'", tool_name);
-
-      if (*video_tool_calls >= 1)
-        co_return "Tool error: only one video summary is allowed per request.";
-
-      std::string requested_url;
-      try {
-        ollama::json args = ollama::json::parse(arguments_json);
-        if (args.contains("url") && args["url"].is_string())
-          requested_url = args["url"].get<std::string>();
-      } catch (...) {
-        co_return "Tool error: invalid tool arguments JSON.";
-      }
-
-      if (requested_url.empty())
-        co_return "Tool error: missing required argument 'url'.";
-
-      *video_tool_calls += 1;
-      co_return co_await video_summary_service.summarize_video(requested_url);
-    };
+        [this, &tool_context](const std::string &tool_name,
+                              const std::string &arguments_json) {
+          return summary_tools.dispatch(tool_context, tool_name, arguments_json);
+        };
 
     const std::string prompt =
         std::format("A YouTube video was posted. Summarize it: {}", url);
@@ -602,6 +1362,7 @@ dpp::task<void> DiscordEventService::handle_message_update(
   auto message_id = dbops::find_message_id(event.msg.id);
   if (message_id.has_value()) {
     dbops::update_message_content(*message_id, event.msg.content);
+    invalidate_analytics_cache(event.msg.guild_id);
   }
   co_return;
 }
@@ -679,6 +1440,9 @@ dpp::task<void> DiscordEventService::remove_reaction(
   if (react_id.has_value()) {
     bot.log(dpp::ll_info, std::format("Deleting reaction id {}", *react_id));
     dbops::delete_reaction(*react_id);
+    if (const dpp::channel *channel = dpp::find_channel(event.channel_id)) {
+      invalidate_analytics_cache(channel->guild_id);
+    }
   }
 
   co_return;
@@ -697,6 +1461,9 @@ DiscordEventService::handle_reaction(const dpp::message_reaction_add_t &event) {
     auto user_id = dbops::find_user_id(event.reacting_user.id);
     if (user_id.has_value()) {
       dbops::insert_reaction(*message_id, *user_id, emoji);
+      if (const dpp::channel *channel = dpp::find_channel(event.channel_id)) {
+        invalidate_analytics_cache(channel->guild_id);
+      }
       bot.log(dpp::ll_info,
               std::format("message: {}, user: {}, reaction added: {}",
                           *message_id, event.reacting_user.format_username(),
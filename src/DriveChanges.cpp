@@ -0,0 +1,233 @@
+#include <DriveChanges.h>
+
+#include <algorithm>
+#include <cctype>
+#include <format>
+#include <iterator>
+#include <unordered_map>
+
+#include <ollama.hpp>
+
+namespace {
+
+// Only the fields the refresh needs; the full resources are much larger.
+constexpr const char *file_fields =
+    "id,name,modifiedTime,webViewLink,parents";
+
+std::optional<ollama::json> parse_object(const std::string &body) {
+  try {
+    auto json = ollama::json::parse(body);
+    if (json.is_object())
+      return json;
+  } catch (...) {
+  }
+  return std::nullopt;
+}
+
+std::optional<drive_changes::DriveFile> parse_file(const ollama::json &file) {
+  if (!file.is_object() || !file.contains("id") || !file["id"].is_string() ||
+      !file.contains("name") || !file["name"].is_string() ||
+      !file.contains("modifiedTime") || !file["modifiedTime"].is_string())
+    return std::nullopt;
+
+  drive_changes::DriveFile out;
+  out.id = file["id"].get<std::string>();
+  out.name = file["name"].get<std::string>();
+  out.modified_time = file["modifiedTime"].get<std::string>();
+  if (file.contains("webViewLink") && file["webViewLink"].is_string())
+    out.web_view_link = file["webViewLink"].get<std::string>();
+  if (file.contains("parents") && file["parents"].is_array()) {
+    for (const auto &parent : file["parents"]) {
+      if (parent.is_string())
+        out.parents.push_back(parent.get<std::string>());
+    }
+  }
+  return out;
+}
+
+std::string string_field(const ollama::json &json, const char *name) {
+  if (json.contains(name) && json[name].is_string())
+    return json[name].get<std::string>();
+  return {};
+}
+
+} // namespace
+
+namespace drive_changes {
+
+std::string url_encode(const std::string &value) {
+  constexpr char hex[] = "0123456789ABCDEF";
+  std::string out;
+  out.reserve(value.size());
+  for (const unsigned char ch : value) {
+    if (std::isalnum(ch) != 0 || ch == '-' || ch == '_' || ch == '.' ||
+        ch == '~') {
+      out += static_cast<char>(ch);
+    } else {
+      out += '%';
+      out += hex[ch >> 4];
+      out += hex[ch & 0x0f];
+    }
+  }
+  return out;
+}
+
+std::string start_page_token_url(const std::string &api_url,
+                                 const std::string &api_key) {
+  return std::format("{}/changes/startPageToken?key={}", api_url,
+                     url_encode(api_key));
+}
+
+std::string changes_url(const std::string &api_url,
+                        const std::string &page_token,
+                        const std::string &api_key) {
+  return std::format("{}/changes?pageToken={}&key={}&pageSize=1000&fields="
+                     "nextPageToken,newStartPageToken,changes(removed,file({}))",
+                     api_url, url_encode(page_token), url_encode(api_key),
+                     file_fields);
+}
+
+std::string watch_url(const std::string &api_url, const std::string &page_token,
+                      const std::string &api_key) {
+  return std::format("{}/changes/watch?pageToken={}&key={}", api_url,
+                     url_encode(page_token), url_encode(api_key));
+}
+
+std::string watch_request_body(const std::string &channel_id,
+                               const std::string &address,
+                               const std::string &token,
+                               std::int64_t expiration_ms) {
+  ollama::json body;
+  body["id"] = channel_id;
+  body["type"] = "web_hook";
+  body["address"] = address;
+  body["token"] = token;
+  // Drive takes the expiration as a string of milliseconds.
+  body["expiration"] = std::to_string(expiration_ms);
+  return body.dump();
+}
+
+std::optional<std::string> parse_start_page_token(const std::string &body) {
+  const auto json = parse_object(body);
+  if (!json)
+    return std::nullopt;
+  auto token = string_field(*json, "startPageToken");
+  if (token.empty())
+    return std::nullopt;
+  return token;
+}
+
+std::optional<ChangesPage> parse_changes_page(const std::string &body) {
+  const auto json = parse_object(body);
+  if (!json || !json->contains("changes") || !(*json)["changes"].is_array())
+    return std::nullopt;
+
+  ChangesPage page;
+  page.next_page_token = string_field(*json, "nextPageToken");
+  page.new_start_page_token = string_field(*json, "newStartPageToken");
+  // One of the two is always present; without either the feed cannot go on.
+  if (page.next_page_token.empty() && page.new_start_page_token.empty())
+    return std::nullopt;
+
+  for (const auto &change : (*json)["changes"]) {
+    if (!change.is_object())
+      continue;
+    if (change.contains("removed") && change["removed"].is_boolean() &&
+        change["removed"].get<bool>())
+      continue;
+    if (!change.contains("file"))
+      continue;
+    if (auto file = parse_file(change["file"]))
+      page.files.push_back(std::move(*file));
+  }
+  return page;
+}
+
+std::optional<std::vector<DriveFile>> parse_file_list(const std::string &body) {
+  const auto json = parse_object(body);
+  if (!json || !json->contains("files") || !(*json)["files"].is_array())
+    return std::nullopt;
+
+  std::vector<DriveFile> files;
+  for (const auto &item : (*json)["files"]) {
+    if (auto file = parse_file(item))
+      files.push_back(std::move(*file));
+  }
+  return files;
+}
+
+std::vector<DriveFile> latest_per_file(std::vector<DriveFile> files) {
+  std::unordered_map<std::string, std::size_t> latest;
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    latest[files[i].id] = i;
+  }
+  std::vector<DriveFile> unique;
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    if (latest[files[i].id] == i) {
+      unique.push_back(std::move(files[i]));
+    }
+  }
+  return unique;
+}
+
+bool is_auth_failure(int status) { return status == 401 || status == 403; }
+
+ChangesPoll::ChangesPoll(std::string api_url, std::string page_token,
+                         std::string api_key, std::string folder_id,
+                         int max_pages)
+    : api_url(std::move(api_url)), api_key(std::move(api_key)),
+      folder_id(std::move(folder_id)), max_pages(max_pages),
+      request_token(std::move(page_token)) {}
+
+std::string ChangesPoll::url() const {
+  return changes_url(api_url, request_token, api_key);
+}
+
+ChangesPoll::Step ChangesPoll::feed(int response_status,
+                                    const std::string &body) {
+  if (current != Step::Next)
+    return current;
+  status = response_status;
+  auto page = status == 200 ? parse_changes_page(body) : std::nullopt;
+  // Guards against a feed that keeps returning nextPageToken.
+  if (!page || ++pages > max_pages) {
+    denied_ = is_auth_failure(status);
+    changed.clear();
+    next_token.clear();
+    current = Step::Failed;
+    return current;
+  }
+
+  changed.insert(changed.end(), std::make_move_iterator(page->files.begin()),
+                 std::make_move_iterator(page->files.end()));
+  if (!page->next_page_token.empty()) {
+    request_token = std::move(page->next_page_token);
+    return current;
+  }
+  // Filtered after deduplication, so a file moved out of the folder is
+  // dropped even if an earlier entry had it inside.
+  changed = latest_per_file(std::move(changed));
+  std::erase_if(changed, [this](const DriveFile &file) {
+    return std::ranges::find(file.parents, folder_id) == file.parents.end();
+  });
+  next_token = std::move(page->new_start_page_token);
+  current = Step::Done;
+  return current;
+}
+
+std::optional<std::int64_t> parse_watch_expiration(const std::string &body) {
+  const auto json = parse_object(body);
+  if (!json || !json->contains("expiration"))
+    return std::nullopt;
+  const auto &value = (*json)["expiration"];
+  try {
+    if (value.is_string())
+      return std::stoll(value.get<std::string>());
+    if (value.is_number_integer())
+      return value.get<std::int64_t>();
+  } catch (...) {
+  }
+  return std::nullopt;
+}
+
+} // namespace drive_changes
@@ -0,0 +1,204 @@
+#include <DriveWebhookServer.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <string_view>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// Notifications have no body worth reading; cap what one request may send.
+constexpr std::size_t max_request_bytes = 16 * 1024;
+// Whole request, not per read, so a client trickling bytes cannot hold its
+// connection open.
+constexpr auto client_timeout = std::chrono::milliseconds(500);
+// Connections read at once; the oldest is dropped to make room.
+constexpr std::size_t max_clients = 32;
+
+std::string lowercase(std::string_view text) {
+  std::string out(text);
+  std::ranges::transform(out, out.begin(), [](unsigned char ch) {
+    return static_cast<char>(std::tolower(ch));
+  });
+  return out;
+}
+
+std::string_view trim(std::string_view text) {
+  while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+    text.remove_prefix(1);
+  while (!text.empty() && (text.back() == ' ' || text.back() == '\t' ||
+                           text.back() == '\r'))
+    text.remove_suffix(1);
+  return text;
+}
+
+// Value of a header in the raw request head, case-insensitive; empty if
+// missing.
+std::string header_value(std::string_view head, std::string_view name) {
+  const std::string wanted = lowercase(name);
+  std::size_t pos = head.find('\n');
+  while (pos != std::string_view::npos && pos + 1 < head.size()) {
+    const std::size_t start = pos + 1;
+    const std::size_t end = head.find('\n', start);
+    const auto line = head.substr(start, end == std::string_view::npos
+                                             ? std::string_view::npos
+                                             : end - start);
+    const auto colon = line.find(':');
+    if (colon != std::string_view::npos &&
+        lowercase(trim(line.substr(0, colon))) == wanted)
+      return std::string(trim(line.substr(colon + 1)));
+    pos = end;
+  }
+  return {};
+}
+
+void send_all(int fd, std::string_view data) {
+  while (!data.empty()) {
+    const auto sent = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+    if (sent <= 0)
+      return;
+    data.remove_prefix(static_cast<std::size_t>(sent));
+  }
+}
+
+void respond(int fd, std::string_view status) {
+  send_all(fd, std::string("HTTP/1.1 ") + std::string(status) +
+                   "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+}
+
+} // namespace
+
+DriveWebhookServer::DriveWebhookServer(std::string channel_token,
+                                       Callback on_notification)
+    : channel_token(std::move(channel_token)),
+      on_notification(std::move(on_notification)) {}
+
+DriveWebhookServer::~DriveWebhookServer() { stop(); }
+
+bool DriveWebhookServer::start(std::uint16_t port) {
+  listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (listen_fd < 0)
+    return false;
+
+  const int reuse = 1;
+  ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+  socklen_t length = sizeof(address);
+  if (::bind(listen_fd, reinterpret_cast<sockaddr *>(&address), length) != 0 ||
+      ::listen(listen_fd, 16) != 0 ||
+      ::getsockname(listen_fd, reinterpret_cast<sockaddr *>(&address),
+                    &length) != 0) {
+    ::close(listen_fd);
+    listen_fd = -1;
+    return false;
+  }
+  bound_port = ntohs(address.sin_port);
+
+  stopping = false;
+  thread = std::thread([this] { serve(); });
+  return true;
+}
+
+void DriveWebhookServer::stop() {
+  if (listen_fd < 0)
+    return;
+  stopping = true;
+  if (thread.joinable())
+    thread.join();
+  ::close(listen_fd);
+  listen_fd = -1;
+}
+
+void DriveWebhookServer::serve() {
+  struct Client {
+    int fd;
+    std::string request;
+    std::chrono::steady_clock::time_point deadline;
+  };
+  std::vector<Client> clients;
+  std::vector<pollfd> fds;
+
+  // Clients are read side by side, so an idle connection never delays a
+  // notification. Polls with a timeout so stop() never waits on accept().
+  while (!stopping) {
+    fds.assign(1, pollfd{listen_fd, POLLIN, 0});
+    for (const auto &c : clients)
+      fds.push_back(pollfd{c.fd, POLLIN, 0});
+    if (::poll(fds.data(), fds.size(), 100) < 0)
+      continue;
+
+    const auto now = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < clients.size(); ++i) {
+      auto &c = clients[i];
+      // The deadline covers the whole request, so a client that is still
+      // sending is closed as well.
+      bool done = now >= c.deadline;
+      if (!done && fds[i + 1].revents != 0) {
+        char buffer[2048];
+        const auto received = ::recv(c.fd, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+          done = true;
+        } else {
+          c.request.append(buffer, static_cast<std::size_t>(received));
+          // Drive sends no body, so the request ends with the blank line.
+          if (c.request.find("\r\n\r\n") != std::string::npos ||
+              c.request.size() >= max_request_bytes) {
+            handle(c.fd, c.request);
+            done = true;
+          }
+        }
+      }
+      if (done) {
+        ::close(c.fd);
+        c.fd = -1;
+      }
+    }
+    std::erase_if(clients, [](const Client &c) { return c.fd < 0; });
+
+    if (fds[0].revents & POLLIN) {
+      const int client = ::accept(listen_fd, nullptr, nullptr);
+      if (client < 0)
+        continue;
+      if (clients.size() >= max_clients) {
+        ::close(clients.front().fd);
+        clients.erase(clients.begin());
+      }
+      clients.push_back(Client{client, {}, now + client_timeout});
+    }
+  }
+  for (const auto &c : clients)
+    ::close(c.fd);
+}
+
+void DriveWebhookServer::handle(int client, const std::string &request) {
+  const auto head_end = request.find("\r\n\r\n");
+  if (head_end == std::string::npos) {
+    respond(client, "413 Payload Too Large");
+    return;
+  }
+  const std::string_view head(request.data(), head_end);
+
+  if (!head.starts_with("POST ")) {
+    respond(client, "405 Method Not Allowed");
+    return;
+  }
+  if (channel_token.empty() ||
+      header_value(head, "X-Goog-Channel-Token") != channel_token) {
+    respond(client, "403 Forbidden");
+    return;
+  }
+
+  respond(client, "200 OK");
+  on_notification(header_value(head, "X-Goog-Resource-State"));
+}
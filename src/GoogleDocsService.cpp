@@ -1,43 +1,350 @@
+#include <DiffPrompt.h>
 #include <DiffUtil.h>
+#include <DriveWebhookServer.h>
 #include <GoogleDocsService.h>
+#include <SheetSnapshotFile.h>
+#include <ToolResultCache.h>
 
+#include <algorithm>
+#include <random>
 #include <sstream>
 
+namespace {
+
+// Tab exports fetched at once per file, and the per-request timeout in
+// seconds. Google throttles bursts from one key, so keep the fan-out small.
+constexpr std::size_t max_parallel_sheet_fetches = 4;
+constexpr time_t sheet_request_timeout = 20;
+
+// Drive caps changes channels at a week; a day keeps stale channels short.
+// Renew ahead of expiry, and back off after a failed watch request.
+constexpr auto watch_channel_lifetime = std::chrono::hours(24);
+constexpr auto watch_renewal_margin = std::chrono::minutes(10);
+constexpr auto watch_retry_delay = std::chrono::hours(1);
+// Diff summaries run at once, and the tokens kept free for the answer when
+// sizing a batched diff prompt to the context window.
+constexpr std::size_t max_parallel_summaries = 3;
+constexpr int diff_answer_tokens = 1024;
+constexpr int min_diff_prompt_tokens = 2048;
+
+// Guards against a feed that keeps returning nextPageToken.
+constexpr int max_change_pages = 50;
+
+// Output budget of the sheet history tool, like the other sheet tools.
+constexpr std::size_t max_history_bytes = 4000;
+
+std::string format_history_time(SheetHistory::TimePoint time) {
+  return std::format("{:%Y-%m-%d %H:%M} UTC",
+                     std::chrono::floor<std::chrono::minutes>(time));
+}
+
+std::string format_history_stats(const SheetHistory::Stats &stats) {
+  return std::format("Sheet history: {} tabs, {} records ({} checkpoints), "
+                     "{} KiB on disk for {} KiB of versions",
+                     stats.tabs, stats.checkpoints + stats.deltas,
+                     stats.checkpoints, stats.file_bytes / 1024,
+                     stats.full_copy_bytes / 1024);
+}
+
+// Cut to the tool budget with a marker, like the sheet query output.
+std::string fit_history_output(std::string text) {
+  if (text.size() > max_history_bytes) {
+    text.resize(max_history_bytes - 12);
+    text += "\n[truncated]";
+  }
+  return text;
+}
+
+std::string random_hex(std::size_t bytes) {
+  std::random_device device;
+  std::mt19937_64 engine(
+      (static_cast<std::uint64_t>(device()) << 32) ^ device());
+  std::string out;
+  for (std::size_t i = 0; i < bytes; ++i) {
+    out += std::format("{:02x}", static_cast<unsigned>(engine() & 0xff));
+  }
+  return out;
+}
+
+} // namespace
+
 GoogleDocsService::GoogleDocsService(const Config &config, dpp::cluster &bot,
-                                     const LlmService &llm_service)
-    : config(config), bot(bot), llm_service(llm_service) {}
+                                     const LlmService &llm_service,
+                                     ToolResultCache &tool_result_cache)
+    : config(config), bot(bot), llm_service(llm_service),
+      tool_result_cache(tool_result_cache) {
+  load_snapshot();
+
+  if (!config.sheet_history_path.empty()) {
+    history = std::make_unique<SheetHistory>(config.sheet_history_path);
+    if (history->open()) {
+      bot.log(dpp::ll_info, format_history_stats(history->stats()));
+    } else {
+      bot.log(dpp::ll_error,
+              std::format("Could not read sheet history {}; not recording",
+                          config.sheet_history_path));
+      history.reset();
+    }
+  }
+
+  if (config.drive_watch_address.empty() || config.drive_watch_port == 0)
+    return;
+
+  watch_token = random_hex(32);
+  webhook_server = std::make_unique<DriveWebhookServer>(
+      watch_token, [this](const std::string &resource_state) {
+        // "sync" only confirms a new channel.
+        if (resource_state != "sync")
+          change_notified = true;
+      });
+  if (!webhook_server->start(
+          static_cast<std::uint16_t>(config.drive_watch_port))) {
+    bot.log(dpp::ll_error,
+            std::format("Could not listen for Drive notifications on port {}",
+                        config.drive_watch_port));
+    webhook_server.reset();
+    return;
+  }
+  bot.log(dpp::ll_info,
+          std::format("Listening for Drive notifications on 127.0.0.1:{}",
+                      webhook_server->port()));
+}
+
+GoogleDocsService::~GoogleDocsService() = default;
+
+void GoogleDocsService::load_snapshot() {
+  if (config.sheet_snapshot_path.empty())
+    return;
+
+  auto persisted = load_sheet_snapshot(config.sheet_snapshot_path);
+  if (!persisted) {
+    bot.log(dpp::ll_info, "No sheet snapshot; fetching every tab");
+    return;
+  }
 
+  const std::size_t tab_count = persisted->tabs.size();
+  for (const auto &tab : sheet_store.update(std::move(persisted->tabs))) {
+    index_vehicles(tab);
+  }
+  // Files edited while the bot was down now show a newer modification
+  // time, so the first refresh diffs them against these tabs.
+  timestamps = std::move(persisted->timestamps);
+  page_token = std::move(persisted->page_token);
+  bot.log(dpp::ll_info,
+          std::format("Loaded sheet snapshot: {} tabs from {} files",
+                      tab_count, timestamps.size()));
+}
+
+dpp::task<void> GoogleDocsService::save_snapshot() {
+  if (config.sheet_snapshot_path.empty())
+    co_return;
 
-std::optional<std::string>
+  // Compression and the write run off the event loop.
+  const bool saved = co_await dpp::async<bool>(
+      [&](std::function<void(bool)> cb) {
+        bot.queue_work(10, [cb = std::move(cb), snapshot = sheet_store.snapshot(),
+                            timestamps = timestamps, page_token = page_token,
+                            &path = config.sheet_snapshot_path]() mutable {
+          cb(save_sheet_snapshot(path, *snapshot, timestamps, page_token));
+        });
+      });
+  if (!saved) {
+    bot.log(dpp::ll_error,
+            std::format("Failed to save sheet snapshot to {}",
+                        config.sheet_snapshot_path));
+  }
+  co_return;
+}
+
+dpp::task<void> GoogleDocsService::record_history(
+    std::vector<std::shared_ptr<const SheetTab>> previous,
+    std::vector<std::shared_ptr<const SheetTab>> stored,
+    SheetHistory::TimePoint modified) {
+  if (!history || stored.empty())
+    co_return;
+
+  const bool recorded = co_await dpp::async<bool>(
+      [&](std::function<void(bool)> cb) {
+        bot.queue_work(10, [cb = std::move(cb), &log = *history, &previous,
+                            &stored, modified]() {
+          bool ok = true;
+          for (std::size_t i = 0; i < stored.size(); ++i) {
+            const SheetTab *old_tab =
+                previous[i] && !previous[i]->csv->empty() ? previous[i].get()
+                                                          : nullptr;
+            ok = log.record(old_tab, *stored[i], modified) && ok;
+          }
+          cb(ok);
+        });
+      });
+  if (!recorded) {
+    bot.log(dpp::ll_error,
+            std::format("Failed to append to sheet history {}",
+                        config.sheet_history_path));
+    co_return;
+  }
+  bot.log(dpp::ll_info, format_history_stats(history->stats()));
+  co_return;
+}
+
+std::shared_ptr<const std::string>
 GoogleDocsService::get_sheet_csv_by_tab_name(const std::string &sheet_name,
                                              bool transpose) const {
-  for (const auto &[filename, tab_metadata] : sheet_metadata) {
-    auto data_by_tab = sheet_data.find(filename);
-    if (data_by_tab == sheet_data.end()) {
-      continue;
+  auto csv = sheet_store.csv(sheet_name, transpose);
+  if (!csv || csv->empty()) {
+    return nullptr;
+  }
+  return csv;
+}
+
+std::shared_ptr<const SheetTab>
+GoogleDocsService::find_sheet(const std::string &sheet_name) const {
+  return sheet_store.find(sheet_name);
+}
+
+std::string GoogleDocsService::lookup_vehicle(const std::string &query) const {
+  return vehicle_index.format_lookup(query);
+}
+
+std::string GoogleDocsService::sheet_history(
+    const std::string &sheet_name, std::optional<SheetHistory::TimePoint> from,
+    std::optional<SheetHistory::TimePoint> to) const {
+  if (!history)
+    return {};
+  const auto versions = history->versions(sheet_name);
+  if (versions.empty())
+    return {};
+
+  if (!from && !to) {
+    std::string out = std::format(
+        "Sheet history: {}, {} versions from {} to {}\nVersions, newest "
+        "first:\n",
+        sheet_name, versions.size(), format_history_time(versions.front().time),
+        format_history_time(versions.back().time));
+    std::size_t listed = 0;
+    for (auto it = versions.rbegin(); it != versions.rend(); ++it) {
+      std::string line = format_history_time(it->time) + "\n";
+      // Leave room for the count of omitted versions.
+      if (out.size() + line.size() + 40 > max_history_bytes)
+        break;
+      out += line;
+      ++listed;
     }
+    if (listed < versions.size()) {
+      out += std::format("... {} older versions\n", versions.size() - listed);
+    }
+    return out;
+  }
 
-    for (const auto &[sheet_id, metadata] : tab_metadata) {
-      if (metadata.sheet_name != sheet_name) {
-        continue;
-      }
+  // `to` covers the whole day; without it the latest version is used.
+  const auto end =
+      to ? *to + std::chrono::days(1) - std::chrono::milliseconds(1)
+         : versions.back().time;
+  const auto newer = history->version_at(sheet_name, end);
+  if (!newer) {
+    return std::format("Sheet: {} has no version before {}; the first is from "
+                       "{}",
+                       sheet_name, format_history_time(end),
+                       format_history_time(versions.front().time));
+  }
+  const bool transpose = sheet_name == "Charging curve";
+
+  if (!from) {
+    return fit_history_output(std::format(
+        "Sheet: {} as of {} (version from {})\n{}:\n{}", sheet_name,
+        format_history_time(end), format_history_time(newer->time),
+        transpose ? "Transposed CSV data" : "CSV data",
+        transpose ? transpose_csv(newer->csv) : newer->csv));
+  }
 
-      auto csv_data = data_by_tab->second.find(sheet_id);
-      if (csv_data != data_by_tab->second.end() && !csv_data->second.empty()) {
-        if (transpose) {
-          return transpose_csv(csv_data->second);
-        }
-        return csv_data->second;
+  // Changes made during the `from` day are included.
+  auto older = history->version_at(sheet_name, *from);
+  if (!older) {
+    older = history->first_version(sheet_name);
+  }
+  if (older->time >= newer->time) {
+    return std::format("Sheet: {} did not change between {} and {}; version "
+                       "from {}",
+                       sheet_name, format_history_time(*from),
+                       format_history_time(end),
+                       format_history_time(newer->time));
+  }
+
+  auto keyed = keyed_diff_csv(older->csv, newer->csv, config.sheet_key_column,
+                              transpose);
+  std::string diff =
+      keyed ? std::move(*keyed) : diff_csv(older->csv, newer->csv, transpose);
+  if (diff.empty()) {
+    return std::format("Sheet: {} only reordered rows between the versions "
+                       "from {} and {}",
+                       sheet_name, format_history_time(older->time),
+                       format_history_time(newer->time));
+  }
+  return fit_history_output(
+      std::format("Sheet: {} changes from the version of {} to the version "
+                  "of {}\n{}",
+                  sheet_name, format_history_time(older->time),
+                  format_history_time(newer->time), diff));
+}
+
+void GoogleDocsService::index_vehicles(
+    const std::shared_ptr<const SheetTab> &tab) {
+  // The charging curve has one column per car; index its transposed view so
+  // each car is a row like in the other tabs.
+  if (tab->file_name == "Charging curves") {
+    vehicle_index.update_tab(std::make_shared<const SheetTab>(SheetStore::parse(
+        tab->file_name, tab->sheet_id, tab->name, *tab->transposed_csv)));
+    return;
+  }
+
+  const int key_column = config.sheet_key_column.empty()
+                             ? -1
+                             : tab->column_index(config.sheet_key_column);
+  vehicle_index.update_tab(tab, key_column < 0 ? 0 : key_column);
+}
+
+dpp::task<std::optional<std::string>>
+GoogleDocsService::fetch_tab_csv(std::string file_id, int sheet_id) {
+  std::string sheet_url =
+      std::format("https://docs.google.com/spreadsheets/d/{}/"
+                  "export?format=csv&gid={}",
+                  file_id, sheet_id);
+
+  int redirect_count = 0;
+  constexpr int max_redirects = 10;
+
+  while (true) {
+    auto sheet_resp = co_await bot.co_request(sheet_url, dpp::m_get, "",
+                                              "text/plain", {}, "1.1",
+                                              sheet_request_timeout);
+
+    if (sheet_resp.status == 307) {
+      const auto location = sheet_resp.headers.find("location");
+      if (location == sheet_resp.headers.end()) {
+        bot.log(dpp::ll_warning,
+                std::format("Redirect without location for sheet {}", sheet_id));
+        co_return std::nullopt;
+      }
+      if (++redirect_count > max_redirects) {
+        bot.log(dpp::ll_warning,
+                std::format("Too many redirects for sheet {}", sheet_id));
+        co_return std::nullopt;
       }
+      sheet_url = location->second;
+    } else if (sheet_resp.status == 200) {
+      co_return std::format("{}\n", sheet_resp.body.data());
+    } else {
+      bot.log(dpp::ll_info,
+              std::format("Error: unknown response for sheet {}: {}", sheet_id,
+                          sheet_resp.status));
+      co_return std::nullopt;
     }
   }
-
-  return std::nullopt;
 }
 
-dpp::task<void> GoogleDocsService::process_sheets(const std::string filename,
-                                                  const std::string file_id,
-                                                  std::string weblink) {
+dpp::task<bool> GoogleDocsService::process_sheets(
+    const std::string filename, const std::string file_id, std::string weblink,
+    std::chrono::sys_time<std::chrono::milliseconds> modified) {
   bot.log(dpp::ll_info, std::format("Processing file {}", filename));
 
   std::string file_url =
@@ -45,16 +352,26 @@ dpp::task<void> GoogleDocsService::process_sheets(const std::string filename,
                   "{}?key={}&fields=sheets.properties(sheetId,title)",
                   file_id, config.google_api_key);
 
-  auto file_resp = co_await bot.co_request(file_url, dpp::m_get);
+  auto file_resp = co_await bot.co_request(file_url, dpp::m_get, "",
+                                           "text/plain", {}, "1.1",
+                                           sheet_request_timeout);
 
   if (file_resp.status != 200) {
     bot.log(dpp::ll_error, std::format("Error fetching sheets for file {}: {}",
                                        filename, file_resp.status));
-    co_return;
+    co_return false;
   }
 
   auto file_data = nlohmann::json::parse(file_resp.body.data());
+  // Tabs missing from the listing are dropped, so an unexpected payload must
+  // not read as a file without tabs.
+  if (!file_data.contains("sheets") || !file_data["sheets"].is_array()) {
+    bot.log(dpp::ll_error,
+            std::format("Unexpected sheet listing for file {}", filename));
+    co_return false;
+  }
 
+  std::vector<FetchedTab> tabs;
   for (auto sheet : file_data["sheets"]) {
     int sheet_id = sheet["properties"]["sheetId"].get<int>();
     std::string sheet_name = sheet["properties"]["title"].get<std::string>();
@@ -69,139 +386,440 @@ dpp::task<void> GoogleDocsService::process_sheets(const std::string filename,
       }
     }
 
-    std::string sheet_url =
-        std::format("https://docs.google.com/spreadsheets/d/{}/"
-                    "export?format=csv&gid={}",
-                    file_id, sheet_id);
-
-    bool is_done = false;
-    int redirect_count = 0;
-    constexpr int max_redirects = 10;
+    tabs.push_back(FetchedTab{sheet_id, std::move(sheet_name), {}});
+  }
 
-    while (!is_done) {
-      auto sheet_resp = co_await bot.co_request(sheet_url, dpp::m_get);
+  // Tasks start when created, so each batch runs its requests in parallel.
+  std::vector<bool> fetched(tabs.size(), false);
+  for (std::size_t first = 0; first < tabs.size();
+       first += max_parallel_sheet_fetches) {
+    const std::size_t last =
+        std::min(tabs.size(), first + max_parallel_sheet_fetches);
+    std::vector<dpp::task<std::optional<std::string>>> batch;
+    batch.reserve(last - first);
+    for (std::size_t i = first; i < last; ++i) {
+      batch.push_back(fetch_tab_csv(file_id, tabs[i].sheet_id));
+    }
+    for (std::size_t i = first; i < last; ++i) {
+      if (auto csv = co_await batch[i - first]) {
+        tabs[i].csv = std::move(*csv);
+        fetched[i] = true;
+      }
+    }
+  }
+  // A tab that failed keeps its stored version until the file is retried.
+  const bool complete = std::ranges::find(fetched, false) == fetched.end();
+
+  struct ChangedTab {
+    std::shared_ptr<const SheetTab> old_tab;
+    std::shared_ptr<const SheetTab> new_tab;
+    RowChanges rows;
+  };
+  std::vector<ChangedTab> changed;
+
+  // All tabs of the file are published as one snapshot, so tool readers
+  // never see the file half refreshed.
+  const auto before = sheet_store.snapshot();
+  std::vector<SheetStore::TabUpdate> updates;
+  std::vector<std::shared_ptr<const SheetTab>> previous;
+  for (std::size_t i = 0; i < tabs.size(); ++i) {
+    if (!fetched[i]) {
+      continue;
+    }
+    auto &tab = tabs[i];
+    auto old_tab = before->find(filename, tab.sheet_id);
+    if (old_tab && !old_tab->csv->empty() && *old_tab->csv == tab.csv) {
+      continue;
+    }
+    updates.push_back(SheetStore::TabUpdate{filename, tab.sheet_id,
+                                            tab.sheet_name, std::move(tab.csv)});
+    previous.push_back(std::move(old_tab));
+  }
 
-      if (sheet_resp.status == 307) {
-        if (++redirect_count > max_redirects) {
-          bot.log(dpp::ll_warning,
-                  std::format("Too many redirects for sheet {}", sheet_id));
-          is_done = true;
-        } else {
-          sheet_url = sheet_resp.headers.find("location")->second;
-        }
-      } else if (sheet_resp.status == 200) {
+  // Every listed tab stays, even if its export failed this time; tabs no
+  // longer listed were deleted from the spreadsheet.
+  std::vector<int> listed;
+  listed.reserve(tabs.size());
+  for (const auto &tab : tabs) {
+    listed.push_back(tab.sheet_id);
+  }
+  auto [stored, removed] =
+      sheet_store.update_file(filename, listed, std::move(updates));
+  for (const auto &tab : removed) {
+    vehicle_index.remove_tab(tab->file_name, tab->sheet_id);
+    bot.log(dpp::ll_info,
+            std::format("The sheet \"{}\" was deleted from {}", tab->name,
+                        filename));
+  }
+  // Only the tabs that changed are re-indexed.
+  for (const auto &tab : stored) {
+    index_vehicles(tab);
+  }
+  // Versions are dated by the file's modification time, not the fetch.
+  co_await record_history(previous, stored, modified);
+  bool replaced = !removed.empty();
+  for (std::size_t i = 0; i < stored.size(); ++i) {
+    if (!previous[i] || previous[i]->csv->empty()) {
+      continue;
+    }
+    replaced = true;
+    // The export differs byte for byte, but the rows may only have moved.
+    auto rows = changed_rows(*previous[i], *stored[i]);
+    if (rows.empty()) {
+      bot.log(dpp::ll_info,
+              std::format("The sheet \"{}\" only reordered rows; not diffing",
+                          stored[i]->name));
+      continue;
+    }
+    bot.log(dpp::ll_info,
+            std::format("The sheet \"{}\" has changed ({} rows removed, {} "
+                        "added)",
+                        stored[i]->name, rows.removed.size(),
+                        rows.added.size()));
+    changed.push_back(
+        ChangedTab{std::move(previous[i]), stored[i], std::move(rows)});
+  }
 
-        auto newdata = std::format("{}\n", sheet_resp.body.data());
+  if (replaced) {
+    const auto dropped = tool_result_cache.invalidate_group("sheets");
+    bot.log(dpp::ll_info,
+            std::format("Invalidated {} cached sheet tool results", dropped));
+  }
+  if (changed.empty()) {
+    co_return complete;
+  }
 
-        std::istringstream nds(newdata);
-        std::string header{};
-        std::getline(nds, header);
-        sheet_metadata[filename][sheet_id] = SheetTabMetadata{sheet_name, header};
+  std::map<int, Diffdata> diffs;
+  for (auto &tab : changed) {
+    const auto &sheet_name = tab.new_tab->name;
+    const bool transpose_for_diff =
+        filename == "Charging curves" && sheet_name == "Charging curve";
+
+    auto diff_result = co_await dpp::async<std::string>(
+        [&](std::function<void(std::string)> cb) {
+          bot.queue_work(10, [cb = std::move(cb), &tab, transpose_for_diff,
+                              key_column = config.sheet_key_column]() mutable {
+            // Unless the header changed, only the rows without an equal row
+            // in the other version are diffed; unchanged rows cannot show up
+            // in either diff.
+            std::string old_data;
+            std::string new_data;
+            if (tab.rows.header_changed) {
+              old_data = *tab.old_tab->csv;
+              new_data = *tab.new_tab->csv;
+            } else {
+              old_data = rows_csv(*tab.old_tab, tab.rows.removed);
+              new_data = rows_csv(*tab.new_tab, tab.rows.added);
+            }
+            // Cell-level changes keep the diff prompt small; duplicate row
+            // keys fall back to the line diff.
+            auto keyed = keyed_diff_csv(old_data, new_data, key_column,
+                                        transpose_for_diff);
+            cb(keyed ? std::move(*keyed)
+                     : diff_csv(old_data, new_data, transpose_for_diff));
+          });
+        });
 
-        if (sheet_data[filename][sheet_id].empty()) {
-          sheet_data[filename][sheet_id] = newdata;
-        } else {
-          if (sheet_data[filename][sheet_id] != newdata) {
-            bot.log(dpp::ll_info,
-                    std::format("The sheet \"{}\" has changed", sheet_name));
-
-            const bool transpose_for_diff =
-                filename == "Charging curves" && sheet_name == "Charging curve";
-
-            const std::string old_data = sheet_data[filename][sheet_id];
-            sheet_data[filename][sheet_id] = newdata;
-
-            auto diff_result = co_await dpp::async<std::string>(
-                [&](std::function<void(std::string)> cb) {
-                  bot.queue_work(10, [cb = std::move(cb), old_data, newdata,
-                                      sheet_id, transpose_for_diff]() mutable {
-                    cb(diff_csv(old_data, newdata, sheet_id, transpose_for_diff));
-                  });
-                });
-
-            sheet_diffs[filename][sheet_id] =
-                Diffdata{std::move(diff_result), weblink, header, sheet_name};
-          }
-        }
-        is_done = true;
-      } else {
-        bot.log(dpp::ll_info,
-                std::format("Error: unknown response: {}", sheet_resp.status));
-        is_done = true;
-      }
+    if (diff_result.empty()) {
+      continue;
     }
+    const auto &csv = *tab.new_tab->csv;
+    diffs[tab.new_tab->sheet_id] =
+        Diffdata{std::move(diff_result), weblink,
+                 csv.substr(0, csv.find('\n')), sheet_name};
   }
-  co_return;
+
+  std::lock_guard lock(sheet_mutex);
+  for (auto &[sheet_id, diff] : diffs) {
+    sheet_diffs[filename][sheet_id] = std::move(diff);
+  }
+  co_return complete;
 }
 
 dpp::task<void> GoogleDocsService::process_diffs() {
-  for (auto &[filename, diffmap] : sheet_diffs) {
+  std::map<std::string, std::map<int, Diffdata>> pending;
+  {
+    std::lock_guard lock(sheet_mutex);
+    pending.swap(sheet_diffs);
+  }
+
+  struct Summary {
+    std::string filename;
+    std::string prompt;
+  };
+  std::vector<Summary> summaries;
+  std::map<std::string, std::string> weblinks;
+
+  // The changed tabs of a file share as few prompts as the context allows.
+  const std::size_t max_prompt_bytes = static_cast<std::size_t>(
+      std::max(config.context_size - diff_answer_tokens, min_diff_prompt_tokens) *
+      3.5);
+  for (auto &[filename, diffmap] : pending) {
+    std::vector<SheetDiff> diffs;
     for (auto &[sheet_id, diffdata] : diffmap) {
-      auto prompt = std::format(
-          "Filename: {}\nSheet name: {}\nCSV Header: {}\nDiff:\n{}", filename,
-          diffdata.sheet_name, diffdata.header, diffdata.diffdata);
-      auto answer = co_await dpp::async<std::string>(
-          [&](std::function<void(std::string)> cb) {
-            bot.queue_work(10, [cb = std::move(cb), prompt,
-                                &llm = llm_service]() mutable {
-              cb(llm.generate_text(prompt, ollama::images{},
-                                   LlmService::GenerationType::Diff));
-            });
-          });
-      answer += std::format("\n{}", diffdata.weblink);
-      dpp::message msg(1267731118895927347, answer);
-      bot.message_create(msg);
+      diffs.push_back(SheetDiff{diffdata.sheet_name, diffdata.header,
+                                std::move(diffdata.diffdata)});
+      weblinks[filename] = diffdata.weblink;
+    }
+    auto prompts = build_diff_prompts(filename, diffs, max_prompt_bytes);
+    bot.log(dpp::ll_info,
+            std::format("Summarizing {} changed sheets of {} in {} request(s)",
+                        diffs.size(), filename, prompts.size()));
+    for (auto &prompt : prompts) {
+      summaries.push_back(Summary{filename, std::move(prompt)});
+    }
+  }
+
+  // Async operations start when created, so each batch of summaries runs
+  // concurrently on the work queue.
+  std::vector<std::string> answers(summaries.size());
+  for (std::size_t first = 0; first < summaries.size();
+       first += max_parallel_summaries) {
+    const std::size_t last =
+        std::min(summaries.size(), first + max_parallel_summaries);
+    std::vector<dpp::async<std::string>> batch;
+    batch.reserve(last - first);
+    for (std::size_t i = first; i < last; ++i) {
+      batch.emplace_back([&, i](std::function<void(std::string)> cb) {
+        bot.queue_work(10, [cb = std::move(cb), prompt = summaries[i].prompt,
+                            &llm = llm_service]() mutable {
+          cb(llm.generate_text(prompt, ollama::images{},
+                               LlmService::GenerationType::Diff));
+        });
+      });
+    }
+    for (std::size_t i = first; i < last; ++i) {
+      answers[i] = co_await batch[i - first];
+    }
+  }
+
+  // One post per file, split only where Discord's length limit forces it.
+  for (const auto &[filename, weblink] : weblinks) {
+    std::string message;
+    for (std::size_t i = 0; i < summaries.size(); ++i) {
+      if (summaries[i].filename != filename || answers[i].empty()) {
+        continue;
+      }
+      if (!message.empty()) {
+        message += "\n\n";
+      }
+      message += answers[i];
+    }
+    if (message.empty()) {
+      continue;
+    }
+    message += std::format("\n{}", weblink);
+    for (auto &part : split_message(message)) {
+      bot.message_create(dpp::message(1267731118895927347, part));
     }
   }
-  sheet_diffs.clear();
   co_return;
 }
 
-dpp::task<void> GoogleDocsService::process_google_docs() {
-  bot.log(dpp::ll_info, "Processing directory");
+dpp::task<std::optional<std::vector<drive_changes::DriveFile>>>
+GoogleDocsService::fetch_changed_files() {
+  drive_changes::ChangesPoll poll(config.drive_api_url, page_token,
+                                  config.google_api_key, Config::sheet_folder_id,
+                                  max_change_pages);
+  while (poll.step() == drive_changes::ChangesPoll::Step::Next) {
+    auto response = co_await bot.co_request(poll.url(), dpp::m_get, "",
+                                            "text/plain", {}, "1.1",
+                                            sheet_request_timeout);
+    poll.feed(response.status, response.body);
+  }
+
+  // An expired token or a broken feed: list the folder and start over.
+  page_token = poll.next_page_token();
+  if (poll.step() == drive_changes::ChangesPoll::Step::Failed) {
+    changes_feed_denied = poll.denied();
+    bot.log(dpp::ll_warning,
+            std::format("Drive changes feed failed ({}); listing the folder",
+                        poll.last_status()));
+    co_return std::nullopt;
+  }
+  co_return poll.files();
+}
+
+dpp::task<std::optional<std::vector<drive_changes::DriveFile>>>
+GoogleDocsService::fetch_directory() {
+  // Taken before the listing, so edits made while listing are in the feed.
+  // The key does not change at runtime, so once the feed is refused every
+  // later request would fail too.
+  if (!changes_feed_denied) {
+    auto token_response = co_await bot.co_request(
+        drive_changes::start_page_token_url(config.drive_api_url,
+                                            config.google_api_key),
+        dpp::m_get, "", "text/plain", {}, "1.1", sheet_request_timeout);
+    if (auto token = token_response.status == 200
+                         ? drive_changes::parse_start_page_token(
+                               token_response.body)
+                         : std::nullopt) {
+      page_token = std::move(*token);
+    } else if (drive_changes::is_auth_failure(token_response.status)) {
+      changes_feed_denied = true;
+      bot.log(dpp::ll_warning,
+              std::format("Drive changes feed not authorized ({}); polling "
+                          "the folder from now on",
+                          token_response.status));
+    } else {
+      bot.log(dpp::ll_debug,
+              std::format("Drive changes feed unavailable ({}); polling the "
+                          "folder",
+                          token_response.status));
+    }
+  }
 
+  bot.log(dpp::ll_info, "Processing directory");
   auto response = co_await bot.co_request(config.directory_url, dpp::m_get);
+  auto files = response.status == 200
+                   ? drive_changes::parse_file_list(response.body)
+                   : std::nullopt;
+  if (!files) {
+    bot.log(dpp::ll_error, std::format("Error listing the sheet folder: {}",
+                                       response.status));
+  }
+  co_return files;
+}
 
-  auto directory_data = nlohmann::json::parse(response.body.data());
+dpp::task<void> GoogleDocsService::renew_watch() {
+  const auto now = std::chrono::system_clock::now();
+  if (!webhook_server || page_token.empty() || now < next_watch_renewal)
+    co_return;
 
-  for (auto filedata : directory_data["files"]) {
-    std::string datestring = filedata["modifiedTime"].get<std::string>();
-    std::string filename = filedata["name"].get<std::string>();
-    if (filename != "TB test results" && filename != "Charging curves")
-      continue;
-    const std::string file_id = filedata["id"].get<std::string>();
-    const std::string weblink = filedata["webViewLink"].get<std::string>();
+  const auto expiration = std::chrono::duration_cast<std::chrono::milliseconds>(
+      (now + watch_channel_lifetime).time_since_epoch());
+  auto response = co_await bot.co_request(
+      drive_changes::watch_url(config.drive_api_url, page_token,
+                               config.google_api_key),
+      dpp::m_post,
+      drive_changes::watch_request_body(random_hex(16),
+                                        config.drive_watch_address,
+                                        watch_token, expiration.count()),
+      "application/json", {}, "1.1", sheet_request_timeout);
+  if (response.status != 200) {
+    bot.log(dpp::ll_warning,
+            std::format("Drive watch request failed ({}); polling only",
+                        response.status));
+    next_watch_renewal = now + watch_retry_delay;
+    co_return;
+  }
 
-    std::chrono::sys_time<std::chrono::milliseconds> tp;
+  const auto expires_ms = drive_changes::parse_watch_expiration(response.body)
+                              .value_or(expiration.count());
+  // The previous channel is left to expire; duplicate notifications only
+  // cause an extra poll of the feed.
+  next_watch_renewal = std::chrono::system_clock::time_point(
+                           std::chrono::milliseconds(expires_ms)) -
+                       watch_renewal_margin;
+  bot.log(dpp::ll_info, "Drive push channel opened");
+  co_return;
+}
 
-    std::istringstream ds(datestring);
+dpp::task<void> GoogleDocsService::process_notifications() {
+  // Left set while a refresh runs, so the next tick picks it up.
+  if (running || !change_notified.exchange(false))
+    co_return;
+  co_await process_google_docs();
+}
 
-    ds >> std::chrono::parse("%Y-%m-%dT%H:%M:%S%Z", tp);
+dpp::task<void> GoogleDocsService::process_google_docs() {
+  if (running.exchange(true))
+    co_return;
 
-    if (ds.fail()) {
-      bot.log(dpp::ll_info,
-              std::format("Error parsing timestamp: {}", ds.str()));
-    } else {
-      const std::string ntime = std::format("{:%Y-%m-%d %H:%M:%S %Z}", tp);
-      if (timestamps[filename].time_since_epoch() ==
-          std::chrono::milliseconds(0)) {
-        bot.log(dpp::ll_info, std::format("New entry: {}, {}", filename, ntime));
-        timestamps[filename] = tp;
-        co_await process_sheets(filename, file_id, weblink);
+  try {
+    std::optional<std::vector<drive_changes::DriveFile>> files;
+    if (!page_token.empty()) {
+      files = co_await fetch_changed_files();
+    }
+    if (!files) {
+      files = co_await fetch_directory();
+    }
+    if (!files) {
+      running = false;
+      co_return;
+    }
+
+    // Files are fetched concurrently; diffs are posted once all are merged.
+    struct FileTask {
+      std::string filename;
+      std::chrono::sys_time<std::chrono::milliseconds> modified;
+      dpp::task<bool> task;
+    };
+    std::vector<FileTask> file_tasks;
+    bool has_changes = false;
+
+    for (const auto &file : *files) {
+      const std::string &datestring = file.modified_time;
+      const std::string &filename = file.name;
+      if (filename != "TB test results" && filename != "Charging curves")
+        continue;
+      const std::string &file_id = file.id;
+      const std::string &weblink = file.web_view_link;
+
+      std::chrono::sys_time<std::chrono::milliseconds> tp;
+
+      std::istringstream ds(datestring);
+
+      ds >> std::chrono::parse("%Y-%m-%dT%H:%M:%S%Z", tp);
+
+      if (ds.fail()) {
+        bot.log(dpp::ll_info,
+                std::format("Error parsing timestamp: {}", ds.str()));
       } else {
-        if (timestamps[filename] != tp) {
-          const std::string otime =
-              std::format("{:%Y-%m-%d %H:%M:%S %Z}", timestamps[filename]);
-          timestamps[filename] = tp;
-          bot.log(
-              dpp::ll_info,
-              std::format("File {} has changed.\nOld time: {}, New time: {}",
-                          filename, otime, ntime));
-          co_await process_sheets(filename, file_id, weblink);
-          co_await process_diffs();
+        const std::string ntime = std::format("{:%Y-%m-%d %H:%M:%S %Z}", tp);
+        // The timestamp is only recorded once the file is fetched, so a
+        // failed fetch is retried on the next poll.
+        const auto known = timestamps.find(filename);
+        if (known == timestamps.end()) {
+          bot.log(dpp::ll_info,
+                  std::format("New entry: {}, {}", filename, ntime));
+          file_tasks.push_back(FileTask{
+              filename, tp, process_sheets(filename, file_id, weblink, tp)});
+        } else {
+          if (known->second != tp) {
+            const std::string otime =
+                std::format("{:%Y-%m-%d %H:%M:%S %Z}", known->second);
+            bot.log(
+                dpp::ll_info,
+                std::format("File {} has changed.\nOld time: {}, New time: {}",
+                            filename, otime, ntime));
+            file_tasks.push_back(FileTask{
+                filename, tp, process_sheets(filename, file_id, weblink, tp)});
+            has_changes = true;
+          }
         }
       }
     }
+
+    bool all_fetched = true;
+    for (auto &file_task : file_tasks) {
+      if (co_await file_task.task) {
+        timestamps[file_task.filename] = file_task.modified;
+      } else {
+        all_fetched = false;
+        bot.log(dpp::ll_warning,
+                std::format("File {} was not fully fetched; retrying on the "
+                            "next poll",
+                            file_task.filename));
+      }
+    }
+    // The changes feed has moved past the failed file and would not list it
+    // again, so the next poll lists the folder instead.
+    if (!all_fetched) {
+      page_token.clear();
+    }
+    if (!file_tasks.empty()) {
+      co_await save_snapshot();
+    }
+    if (has_changes) {
+      co_await process_diffs();
+    }
+    co_await renew_watch();
+  } catch (const std::exception &e) {
+    bot.log(dpp::ll_error,
+            std::format("Processing google docs failed: {}", e.what()));
   }
+
+  running = false;
   co_return;
 }
@@ -0,0 +1,177 @@
+#include <IntentMatcher.h>
+
+#include <algorithm>
+#include <cctype>
+#include <utility>
+
+#include <ollama.hpp>
+
+namespace {
+
+// Optional trailing time range, captured for time_range_from().
+const std::string range_pattern =
+    R"((?:\s+((?:(?:in|for|over|during|i)\s+(?:the\s+)?)?)"
+    R"((?:this month|last month|last 7 days|past week|last 30 days|past month|)"
+    R"(all time|ever|denne måneden|forrige måned|siste 7 dager|siste 30 dager|)"
+    R"(noensinne)))?)";
+
+// Optional trailing scope; anything else means the whole server.
+const std::string scope_pattern =
+    R"((?:\s+(in this channel|in here|here|i denne kanalen|her))?)";
+
+const std::string question_end = R"(\s*[?!.]*$)";
+
+std::string time_range_from(const std::string &phrase) {
+  if (phrase.find("this month") != std::string::npos ||
+      phrase.find("denne måneden") != std::string::npos)
+    return "this_month";
+  if (phrase.find("last month") != std::string::npos ||
+      phrase.find("forrige måned") != std::string::npos)
+    return "last_month";
+  if (phrase.find("7 da") != std::string::npos ||
+      phrase.find("past week") != std::string::npos)
+    return "last_7d";
+  if (phrase.find("30 da") != std::string::npos ||
+      phrase.find("past month") != std::string::npos)
+    return "last_30d";
+  return "all_time";
+}
+
+// Leaderboard rows when the message names no count, and the analytics
+// tool's maximum.
+constexpr int default_leaderboard_limit = 10;
+constexpr int max_leaderboard_limit = 120;
+
+// "top 5 reactions" asks for five rows; counts are clamped to what the
+// analytics tool accepts.
+int leaderboard_limit(const std::ssub_match &count) {
+  if (!count.matched)
+    return default_leaderboard_limit;
+  const std::string digits = count.str();
+  if (digits.size() > 3)
+    return max_leaderboard_limit;
+  return std::clamp(std::stoi(digits), 1, max_leaderboard_limit);
+}
+
+std::string leaderboard_arguments(const std::string &target,
+                                  const std::string &group_by,
+                                  const std::ssub_match &range,
+                                  const std::ssub_match &scope,
+                                  int limit = default_leaderboard_limit) {
+  ollama::json args = ollama::json::object();
+  args["scope"] = scope.matched ? "channel" : "server";
+  args["kind"] = "leaderboard";
+  args["target"] = target;
+  args["group_by"] = group_by;
+  args["time_range"] = time_range_from(range.str());
+  args["limit"] = limit;
+  return args.dump();
+}
+
+} // namespace
+
+void IntentMatcher::add_rule(std::string name, const std::string &pattern,
+                             std::string tool_name,
+                             ArgumentBuilder build_arguments) {
+  rules.push_back(Rule{std::move(name),
+                       std::regex(pattern, std::regex::optimize),
+                       std::move(tool_name), std::move(build_arguments)});
+}
+
+std::optional<IntentMatcher::Match>
+IntentMatcher::match(const std::string &message) const {
+  const std::string normalized = normalize(message);
+  if (normalized.empty())
+    return std::nullopt;
+
+  for (const auto &rule : rules) {
+    std::smatch m;
+    if (!std::regex_match(normalized, m, rule.pattern))
+      continue;
+    auto arguments = rule.build_arguments(m);
+    if (!arguments.has_value())
+      continue;
+    return Match{rule.name, rule.tool_name, std::move(*arguments)};
+  }
+  return std::nullopt;
+}
+
+std::string IntentMatcher::normalize(const std::string &message) {
+  static const std::regex mention_re(R"(<@[!&]?\d+>)", std::regex::optimize);
+  const std::string without_mentions =
+      std::regex_replace(message, mention_re, " ");
+
+  std::string out;
+  out.reserve(without_mentions.size());
+  bool pending_space = false;
+  for (const unsigned char ch : without_mentions) {
+    if (std::isspace(ch)) {
+      pending_space = !out.empty();
+      continue;
+    }
+    if (pending_space) {
+      out.push_back(' ');
+      pending_space = false;
+    }
+    out.push_back(static_cast<char>(ch < 0x80 ? std::tolower(ch) : ch));
+  }
+
+  // A leading address like "nissefar," carries no intent.
+  static const std::regex address_re(R"(^(?:hey\s+|hei\s+)?nissefar[,:]?\s*)",
+                                     std::regex::optimize);
+  return std::regex_replace(out, address_re, "");
+}
+
+IntentMatcher IntentMatcher::with_default_rules() {
+  IntentMatcher matcher;
+
+  matcher.add_rule(
+      "stream_status",
+      R"(^(?:is|er)\s+(?:bjørn|bjorn|bjoern|the stream|streamen|he|han)\s+)"
+      R"((?:live|streaming|on air|direkte|på lufta)(?:\s+(?:now|right now|nå))?)" +
+          question_end,
+      "get_youtube_stream_status",
+      [](const std::smatch &) { return std::optional<std::string>("{}"); });
+
+  matcher.add_rule(
+      "top_reactions",
+      R"(^(?:what are the\s+|show\s+|vis\s+)?(?:top|most used|most popular|mest brukte|topp)\s+)"
+      R"((?:(\d+)\s+)?(?:reactions|reacts|emojis|reaksjoner|emojier))" +
+          range_pattern + scope_pattern + question_end,
+      "query_channel_analytics", [](const std::smatch &m) {
+        return std::optional<std::string>(leaderboard_arguments(
+            "reactions", "emoji", m[2], m[3], leaderboard_limit(m[1])));
+      });
+
+  matcher.add_rule(
+      "top_posters",
+      R"(^(?:who (?:posts|talks|writes) the most|top posters|most active (?:users|members|posters)|)"
+      R"(hvem skriver mest|hvem poster mest))" +
+          range_pattern + scope_pattern + question_end,
+      "query_channel_analytics", [](const std::smatch &m) {
+        return std::optional<std::string>(
+            leaderboard_arguments("messages", "author", m[1], m[2]));
+      });
+
+  matcher.add_rule(
+      "arithmetic",
+      R"(^(?:what is|what's|whats|hva er|calculate|regn ut)\s+([0-9.,\s+\-*/^()]+?))" +
+          question_end,
+      "calculate_with_bc", [](const std::smatch &m) -> std::optional<std::string> {
+        std::string expression = m[1].str();
+        // Only treat it as arithmetic when there is an operator between
+        // numbers; "what is 42" is a different question.
+        static const std::regex binary_re(R"(\d[\s)]*[+\-*/^][\s(]*[\d.(])");
+        if (!std::regex_search(expression, binary_re))
+          return std::nullopt;
+        for (auto &ch : expression) {
+          if (ch == ',')
+            ch = '.';
+        }
+        ollama::json args = ollama::json::object();
+        args["expression"] = expression;
+        return args.dump();
+      });
+
+  return matcher;
+}
@@ -1,46 +1,13 @@
 #include <LlmService.h>
 #include <OllamaToolCalling.h>
+#include <ToolRegistry.h>
 
+#include <cstdint>
+#include <optional>
 #include <unordered_set>
 
 namespace {
 
-std::string response_to_text(const ollama::response &response) {
-  const auto payload = response.as_json();
-
-  if (payload.contains("message") && payload["message"].is_object()) {
-    const auto &message = payload["message"];
-    if (message.contains("content")) {
-      if (message["content"].is_string()) {
-        return message["content"].get<std::string>();
-      }
-      if (!message["content"].is_null()) {
-        return message["content"].dump();
-      }
-    }
-  }
-
-  if (payload.contains("response") && payload["response"].is_string()) {
-    return payload["response"].get<std::string>();
-  }
-
-  return payload.dump();
-}
-
-std::string response_shape(const ollama::response &response) {
-  const auto payload = response.as_json();
-  if (!payload.contains("message") || !payload["message"].is_object()) {
-    return "missing message object";
-  }
-
-  const auto &message = payload["message"];
-  if (!message.contains("content")) {
-    return "message without content";
-  }
-
-  return std::format("message.content type={}", message["content"].type_name());
-}
-
 int estimate_num_ctx(std::size_t input_bytes, int num_predict) {
   const int ctx = static_cast<int>(input_bytes / 3.5 * 1.2) + num_predict;
   return std::max(ctx, 2048);
@@ -56,15 +23,36 @@ std::string truncate_for_log(std::string value, std::size_t max_size) {
   return value;
 }
 
-std::string tool_call_names_for_log(const ollama::response &response) {
-  if (!ollama_tools::has_tool_calls(response)) {
+// Calls and token counts of one model tier within a request.
+struct ModelUsage {
+  int calls = 0;
+  std::int64_t prompt_tokens = 0;
+  std::int64_t eval_tokens = 0;
+
+  // Reads the two counters in place from the response's JSON.
+  void add(const ollama::response &response) {
+    const auto &payload = response.as_json();
+    const auto counter = [&payload](const char *key) -> std::int64_t {
+      const auto it = payload.find(key);
+      return it != payload.end() && it->is_number_integer()
+                 ? it->get<std::int64_t>()
+                 : 0;
+    };
+    ++calls;
+    prompt_tokens += counter("prompt_eval_count");
+    eval_tokens += counter("eval_count");
+  }
+};
+
+std::string tool_call_names_for_log(const ollama_tools::ResponseView &response) {
+  if (!response.has_tool_calls()) {
     return "[]";
   }
 
   std::string names = "[";
   bool first = true;
 
-  for (const auto &tool_call : ollama_tools::tool_calls(response)) {
+  for (const auto &tool_call : response.tool_calls()) {
     std::string tool_name = "unknown_tool";
     if (tool_call.contains("function") && tool_call["function"].is_object()) {
       const auto &fn = tool_call["function"];
@@ -140,6 +128,19 @@ std::string LlmService::generate_text(const std::string &prompt,
     model = config.comparison_model;
     messages.emplace_back("user", prompt);
     break;
+  case ConversationSummary:
+    // Background bookkeeping, so the router model is good enough if set.
+    opts["num_predict"] = config.num_predict;
+    opts["num_ctx"] = estimate_num_ctx(prompt.size(), config.num_predict);
+    system_prompt =
+        "You maintain a running summary of a Discord channel. Merge the "
+        "previous summary with the new messages into one updated summary. "
+        "Keep names, decisions, recurring topics, running jokes and open "
+        "questions; drop small talk. Write plain prose or short bullet "
+        "points, at most 1500 characters, and nothing else.";
+    model = config.router_model.empty() ? config.text_model : config.router_model;
+    messages.emplace_back("user", prompt);
+    break;
   case ImageDescription:
     opts["num_predict"] = config.num_predict;
     system_prompt = config.image_description_system_prompt;
@@ -164,11 +165,11 @@ std::string LlmService::generate_text(const std::string &prompt,
       ollama::request request(model, prompt, opts, false, imagelist);
       request["system"] = system_prompt;
       const ollama::response response = ollama_client.generate(request);
-      answer = response_to_text(response);
+      answer = ollama_tools::ResponseView(response).text();
     } else {
       ollama::request request(model, messages, opts, false);
       const ollama::response response = ollama_client.chat(request);
-      answer = response_to_text(response);
+      answer = ollama_tools::ResponseView(response).text();
     }
   } catch (ollama::exception e) {
     answer = std::format("Exception running llm: {}", e.what());
@@ -188,7 +189,7 @@ std::string LlmService::generate_text(const std::string &prompt,
 
 dpp::task<std::string> LlmService::generate_text_with_tools(
     const std::string &prompt, const ollama::images &imagelist,
-    const std::vector<LlmService::ToolDefinition> &available_tools,
+    const ToolRegistry &available_tools,
     const std::function<dpp::task<std::string>(const std::string &,
                                                const std::string &)>
         &tool_executor) const {
@@ -199,22 +200,18 @@ dpp::task<std::string> LlmService::generate_text_with_tools(
   ollama::options opts;
   opts["num_predict"] = config.num_predict;
 
-  ollama_tools::tools json_tools;
-  for (const auto &tool : available_tools) {
-    ollama::json parameters =
-        ollama::json{{"type", "object"}, {"properties", ollama::json::object()}};
-    if (!tool.parameters_schema_json.empty()) {
-      try {
-        parameters = ollama::json::parse(tool.parameters_schema_json);
-      } catch (...) {
-      }
-    }
-
-    json_tools.push_back(ollama_tools::make_function_tool(
-        tool.name, tool.description, parameters));
-  }
+  const ollama_tools::tools &json_tools = available_tools.json_tools();
 
   const std::string model = imagelist.empty() ? config.text_model : config.vision_model;
+  // With a router model configured, the small model runs the tool loop and
+  // the large model is called once, without tools, for the final answer.
+  const bool use_router = !config.router_model.empty();
+  const std::string &routing_model = use_router ? config.router_model : model;
+  ModelUsage router_usage;
+  ModelUsage answer_usage;
+  const auto record_usage = [&](const ollama::response &resp, bool routed) {
+    (routed && use_router ? router_usage : answer_usage).add(resp);
+  };
   ollama::messages messages;
   messages.emplace_back("system", config.system_prompt);
 
@@ -231,8 +228,7 @@ dpp::task<std::string> LlmService::generate_text_with_tools(
     std::size_t initial_bytes = 0;
     for (const auto &msg : messages)
       initial_bytes += msg.dump().size();
-    for (const auto &tool : json_tools)
-      initial_bytes += tool.dump().size();
+    initial_bytes += available_tools.serialized_bytes();
     opts["num_ctx"] = estimate_num_ctx(initial_bytes, config.num_predict);
     bot.log(dpp::ll_info,
             std::format("Initial num_ctx={} (estimated from {} bytes)",
@@ -250,74 +246,75 @@ dpp::task<std::string> LlmService::generate_text_with_tools(
   std::unordered_set<std::string> seen_tool_calls;
   bool analytics_tool_used = false;
   bool saw_empty_content_without_tool_calls = false;
+  bool routing_complete = false;
 
   try {
     bot.log(dpp::ll_info,
-            std::format("Tool-calling enabled with {} tools", json_tools.size()));
+            std::format("Tool-calling enabled with {} tools routing_model={}",
+                        json_tools.size(), routing_model));
 
-    ollama::response response =
-        ollama_tools::chat(ollama_client, model, messages, opts, json_tools);
+    ollama::response response = ollama_tools::chat(
+        ollama_client, routing_model, messages, opts, json_tools);
+    record_usage(response, true);
 
     for (int iteration = 0; iteration < 4; ++iteration) {
-      const auto payload = response.as_json();
-      const bool has_tool_calls = ollama_tools::has_tool_calls(response);
-      std::size_t tool_call_count = 0;
-      if (has_tool_calls) {
-        tool_call_count = ollama_tools::tool_calls(response).size();
-      }
-
-      std::size_t content_length = 0;
-      if (payload.contains("message") && payload["message"].is_object() &&
-          payload["message"].contains("content")) {
-        const auto &content = payload["message"]["content"];
-        if (content.is_string()) {
-          content_length = content.get<std::string>().size();
-        } else if (!content.is_null()) {
-          content_length = content.dump().size();
-        }
-      }
-
-      std::string done = "n/a";
-      if (payload.contains("done")) {
-        done = payload["done"].dump();
-      }
-
-      std::string done_reason = "n/a";
-      if (payload.contains("done_reason")) {
-        done_reason = payload["done_reason"].dump();
-      }
+      const ollama_tools::ResponseView view(response);
+      const bool has_tool_calls = view.has_tool_calls();
+      const std::size_t tool_call_count = view.tool_calls().size();
+      const std::size_t content_length = view.content_length();
+      const std::string done = view.field_dump("done");
+      const std::string done_reason = view.field_dump("done_reason");
 
       bot.log(dpp::ll_info,
               std::format("Tool loop iteration={} has_tool_calls={} tool_calls_count={} "
                           "content_length={} done={} done_reason={} tool_names={}",
                           iteration + 1, has_tool_calls, tool_call_count,
                           content_length, done, done_reason,
-                          tool_call_names_for_log(response)));
+                          tool_call_names_for_log(view)));
+
+      if (!has_tool_calls && use_router) {
+        // The router's own text is discarded; it only decides tools.
+        routing_complete = true;
+        break;
+      }
 
       if (!has_tool_calls) {
-        answer = response_to_text(response);
+        answer = view.text();
         if (answer.empty()) {
           saw_empty_content_without_tool_calls = true;
           const std::string payload_preview =
-              truncate_for_log(payload.dump(), 600);
+              truncate_for_log(view.json().dump(), 600);
           bot.log(dpp::ll_warning,
                   std::format("Tool chat returned empty assistant content ({}) "
                               "payload={}",
-                              response_shape(response), payload_preview));
+                              view.shape(), payload_preview));
         }
         break;
       }
 
-      messages.push_back(ollama_tools::assistant_message(response));
+      messages.push_back(view.assistant_message());
 
-      int prompt_eval_count = 0;
-      if (payload.contains("prompt_eval_count") &&
-          payload["prompt_eval_count"].is_number_integer())
-        prompt_eval_count = payload["prompt_eval_count"].get<int>();
+      const auto prompt_eval_count = view.prompt_eval_count();
 
       std::size_t iteration_tool_output_bytes = 0;
 
-      for (const auto &tool_call : ollama_tools::tool_calls(response)) {
+      struct PendingToolCall {
+        std::string tool_name;
+        std::string arguments_json;
+        std::string logged_args;
+        std::optional<dpp::task<std::string>> task;
+        std::string blocked_output;
+      };
+
+      // Dispatch every tool call of this turn before awaiting any of them, so
+      // independent calls run concurrently. Results are awaited and appended
+      // in the original call order. The executor receives references into
+      // pending_calls, so it is sized up front and never reallocates while
+      // tasks are suspended.
+      const auto &requested_tool_calls = view.tool_calls();
+      std::vector<PendingToolCall> pending_calls;
+      pending_calls.reserve(requested_tool_calls.size());
+      for (const auto &tool_call : requested_tool_calls) {
         std::string tool_name = "unknown_tool";
         std::string arguments_json = "{}";
 
@@ -348,22 +345,49 @@ dpp::task<std::string> LlmService::generate_text_with_tools(
 
         const std::string tool_key = tool_name + "\n" + arguments_json;
 
-        std::string tool_output;
+        PendingToolCall &call = pending_calls.emplace_back();
+        call.tool_name = tool_name;
+        call.arguments_json = arguments_json;
+        call.logged_args = logged_args;
+
         if (seen_tool_calls.contains(tool_key)) {
-          tool_output =
+          call.blocked_output =
               "Tool error: duplicate tool call blocked in same request. Use the prior result.";
           bot.log(dpp::ll_warning,
                   std::format("Blocked duplicate tool call: {} args={}", tool_name,
                               logged_args));
         } else {
           seen_tool_calls.insert(tool_key);
-          tool_output = co_await tool_executor(tool_name, arguments_json);
+          call.task.emplace(tool_executor(call.tool_name, call.arguments_json));
           ++tool_calls_executed;
           if (tool_name == "query_channel_analytics") {
             analytics_tool_used = true;
           }
         }
+      }
 
+      if (pending_calls.size() > 1) {
+        bot.log(dpp::ll_info,
+                std::format("Dispatched {} tool calls concurrently",
+                            pending_calls.size()));
+      }
+
+      for (auto &call : pending_calls) {
+        std::string tool_output = call.blocked_output;
+        // A failed call becomes its tool result, so every started task is
+        // awaited before pending_calls goes away.
+        if (call.task.has_value()) {
+          try {
+            tool_output = co_await *call.task;
+          } catch (const std::exception &e) {
+            tool_output = std::format("Tool error: {}", e.what());
+          } catch (...) {
+            tool_output = "Tool error: the tool failed.";
+          }
+        }
+
+        last_tool_name = call.tool_name;
+        last_tool_args = call.logged_args;
         last_tool_output_size = tool_output.size();
         iteration_tool_output_bytes += tool_output.size();
         last_tool_output_preview = tool_output;
@@ -372,9 +396,10 @@ dpp::task<std::string> LlmService::generate_text_with_tools(
           last_tool_output_preview += "...";
         }
         bot.log(dpp::ll_info,
-                std::format("Tool call result: {} output_bytes={}", tool_name,
+                std::format("Tool call result: {} output_bytes={}", call.tool_name,
                             tool_output.size()));
-        messages.push_back(ollama_tools::tool_result_message(tool_name, tool_output));
+        messages.push_back(
+            ollama_tools::tool_result_message(call.tool_name, tool_output));
       }
 
       if (prompt_eval_count > 0) {
@@ -397,12 +422,32 @@ dpp::task<std::string> LlmService::generate_text_with_tools(
             "Tool phase is complete. Use the returned analytics result as the final "
             "source of truth. Do not ask to run another query. Provide the final "
             "answer now.");
+        if (use_router) {
+          routing_complete = true;
+          break;
+        }
         response =
             ollama_tools::chat(ollama_client, model, messages, opts,
                                ollama_tools::tools{});
+        record_usage(response, false);
       } else {
-        response =
-            ollama_tools::chat(ollama_client, model, messages, opts, json_tools);
+        response = ollama_tools::chat(ollama_client, routing_model, messages,
+                                      opts, json_tools);
+        record_usage(response, true);
+      }
+    }
+
+    if (routing_complete) {
+      const ollama::response final_response = ollama_tools::chat(
+          ollama_client, model, messages, opts, ollama_tools::tools{});
+      record_usage(final_response, false);
+      const ollama_tools::ResponseView final_view(final_response);
+      answer = final_view.text();
+      if (answer.empty()) {
+        saw_empty_content_without_tool_calls = true;
+        bot.log(dpp::ll_warning,
+                std::format("Final answer model returned empty content ({})",
+                            final_view.shape()));
       }
     }
 
@@ -440,7 +485,8 @@ dpp::task<std::string> LlmService::generate_text_with_tools(
       const ollama::response fallback_response =
           ollama_tools::chat(ollama_client, model, messages, opts,
                              ollama_tools::tools{});
-      answer = response_to_text(fallback_response);
+      record_usage(fallback_response, false);
+      answer = ollama_tools::ResponseView(fallback_response).text();
     } catch (ollama::exception e) {
       bot.log(dpp::ll_error,
               std::format("Fallback chat after tool-calling failure also failed: {}",
@@ -454,8 +500,93 @@ dpp::task<std::string> LlmService::generate_text_with_tools(
     }
   }
 
+  bot.log(dpp::ll_info,
+          std::format("Token trace: router_model={} router_calls={} "
+                      "router_prompt_tokens={} router_eval_tokens={} "
+                      "answer_model={} answer_calls={} answer_prompt_tokens={} "
+                      "answer_eval_tokens={} tool_calls={}",
+                      use_router ? config.router_model : "none",
+                      router_usage.calls, router_usage.prompt_tokens,
+                      router_usage.eval_tokens, model, answer_usage.calls,
+                      answer_usage.prompt_tokens, answer_usage.eval_tokens,
+                      tool_calls_executed));
+
   if (answer.length() > 1800)
     answer.resize(1800);
 
   co_return answer;
 }
+
+std::string LlmService::generate_text_from_tool_result(
+    const std::string &prompt, const std::string &tool_name,
+    const std::string &arguments_json, const std::string &tool_output) const {
+  ollama::options opts;
+  opts["num_predict"] = config.num_predict;
+
+  // Present the result as if the model had called the tool itself.
+  ollama::json function = ollama::json::object();
+  function["name"] = tool_name;
+  function["arguments"] = ollama::json::parse(arguments_json, nullptr, false);
+  if (function["arguments"].is_discarded())
+    function["arguments"] = ollama::json::object();
+  ollama::json tool_call = ollama::json::object();
+  tool_call["function"] = std::move(function);
+
+  ollama::messages messages;
+  messages.emplace_back("system", config.system_prompt);
+  messages.emplace_back("user", prompt);
+  ollama::message assistant_message("assistant", "");
+  assistant_message["tool_calls"] = ollama::json::array({tool_call});
+  messages.push_back(assistant_message);
+  messages.push_back(ollama_tools::tool_result_message(tool_name, tool_output));
+
+  std::size_t input_bytes = 0;
+  for (const auto &msg : messages)
+    input_bytes += msg.dump().size();
+  opts["num_ctx"] = estimate_num_ctx(input_bytes, config.num_predict);
+
+  std::string answer;
+  try {
+    const ollama::response response = ollama_tools::chat(
+        ollama_client, config.text_model, messages, opts, ollama_tools::tools{});
+    const ollama_tools::ResponseView view(response);
+    answer = view.text();
+    bot.log(dpp::ll_info,
+            std::format("Token trace: fast_path tool={} answer_model={} "
+                        "answer_calls=1 answer_prompt_tokens={} "
+                        "answer_eval_tokens={}",
+                        tool_name, config.text_model, view.prompt_eval_count(),
+                        view.eval_count()));
+  } catch (ollama::exception e) {
+    bot.log(dpp::ll_warning,
+            std::format("Fast path phrasing failed: {}", e.what()));
+  } catch (const std::exception &e) {
+    bot.log(dpp::ll_warning,
+            std::format("Fast path phrasing threw: {}", e.what()));
+  }
+
+  if (answer.length() > 1800)
+    answer.resize(1800);
+
+  return answer;
+}
+
+std::vector<float> LlmService::generate_embedding(const std::string &text) const {
+  if (config.embedding_model.empty())
+    return {};
+
+  try {
+    const ollama::response response =
+        ollama_client.generate_embeddings(config.embedding_model, text);
+    const auto &payload = response.as_json();
+    if (!payload.contains("embeddings") || !payload["embeddings"].is_array() ||
+        payload["embeddings"].empty() || !payload["embeddings"][0].is_array())
+      return {};
+    return payload["embeddings"][0].get<std::vector<float>>();
+  } catch (ollama::exception e) {
+    bot.log(dpp::ll_warning, std::format("Embedding failed: {}", e.what()));
+  } catch (const std::exception &e) {
+    bot.log(dpp::ll_warning, std::format("Embedding threw: {}", e.what()));
+  }
+  return {};
+}
@@ -0,0 +1,138 @@
+#include <MessageIndexService.h>
+
+#include <chrono>
+#include <format>
+#include <utility>
+
+namespace {
+
+// Short messages ("lol", a lone emoji) add noise, not recall.
+constexpr std::size_t min_indexed_chars = 16;
+constexpr std::size_t max_embedded_chars = 2000;
+constexpr std::size_t max_queued_messages = 2000;
+constexpr std::size_t batch_size = 32;
+// Similarity below this is rarely related for general-purpose embedders.
+constexpr float min_search_score = 0.35F;
+// A full index is tens of MiB; write it at most this often, not after every
+// 30 s batch. A crash loses at most this window; shutdown saves the rest.
+constexpr auto save_interval = std::chrono::minutes(10);
+
+} // namespace
+
+MessageIndexService::MessageIndexService(const Config &config,
+                                         dpp::cluster &bot,
+                                         const LlmService &llm_service)
+    : config(config), bot(bot), llm_service(llm_service),
+      last_save(std::chrono::steady_clock::now()) {
+  if (!enabled())
+    return;
+
+  if (index.load(config.embedding_index_path)) {
+    bot.log(dpp::ll_info,
+            std::format("Loaded message index: {} vectors, {} dims, {} KiB",
+                        index.size(), index.dimensions(),
+                        index.memory_bytes() / 1024));
+  } else {
+    bot.log(dpp::ll_info,
+            std::format("Starting empty message index (capacity {})",
+                        index.capacity()));
+  }
+}
+
+MessageIndexService::~MessageIndexService() {
+  if (enabled() && unsaved > 0)
+    index.save(config.embedding_index_path);
+}
+
+void MessageIndexService::enqueue(std::uint64_t message_id,
+                                  dpp::snowflake server_id,
+                                  dpp::snowflake channel_id, std::string text) {
+  if (!enabled() || text.size() < min_indexed_chars)
+    return;
+  if (text.size() > max_embedded_chars)
+    text.resize(max_embedded_chars);
+
+  std::lock_guard lock(queue_mutex);
+  if (queue.size() >= max_queued_messages)
+    queue.pop_front();
+  queue.push_back(PendingMessage{message_id, static_cast<std::uint64_t>(server_id),
+                                 static_cast<std::uint64_t>(channel_id),
+                                 std::move(text)});
+}
+
+dpp::task<void> MessageIndexService::process() {
+  if (!enabled() || running.exchange(true))
+    co_return;
+
+  std::vector<PendingMessage> batch;
+  {
+    std::lock_guard lock(queue_mutex);
+    while (!queue.empty() && batch.size() < batch_size) {
+      batch.push_back(std::move(queue.front()));
+      queue.pop_front();
+    }
+  }
+
+  if (!batch.empty()) {
+    using Embeddings = std::vector<std::vector<float>>;
+    auto embeddings = co_await dpp::async<Embeddings>(
+        [&](std::function<void(Embeddings)> cb) {
+          bot.queue_work(10, [cb = std::move(cb), &batch,
+                              &llm = llm_service]() mutable {
+            Embeddings out;
+            out.reserve(batch.size());
+            for (const auto &message : batch)
+              out.push_back(llm.generate_embedding(message.text));
+            cb(std::move(out));
+          });
+        });
+
+    std::size_t added = 0;
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+      if (index.add(batch[i].message_id, batch[i].server_id,
+                    batch[i].channel_id, embeddings[i]))
+        ++added;
+    }
+
+    unsaved += added;
+    bool saved = false;
+    const auto now = std::chrono::steady_clock::now();
+    if (unsaved > 0 && now - last_save >= save_interval) {
+      saved = index.save(config.embedding_index_path);
+      if (saved)
+        unsaved = 0;
+      last_save = now;
+    }
+    bot.log(dpp::ll_info,
+            std::format("Message index: embedded {}/{} messages, size={} "
+                        "memory={}KiB saved={} unsaved={}",
+                        added, batch.size(), index.size(),
+                        index.memory_bytes() / 1024, saved, unsaved));
+  }
+
+  running = false;
+  co_return;
+}
+
+dpp::task<std::vector<VectorIndex::Hit>>
+MessageIndexService::search(std::string query, dpp::snowflake server_id,
+                            std::vector<std::uint64_t> exclude_ids,
+                            std::size_t limit) const {
+  if (!enabled())
+    co_return std::vector<VectorIndex::Hit>{};
+
+  auto embedding = co_await dpp::async<std::vector<float>>(
+      [&](std::function<void(std::vector<float>)> cb) {
+        bot.queue_work(10, [cb = std::move(cb), query,
+                            &llm = llm_service]() mutable {
+          cb(llm.generate_embedding(query));
+        });
+      });
+
+  VectorIndex::SearchOptions options;
+  options.limit = limit;
+  options.server_id = static_cast<std::uint64_t>(server_id);
+  options.min_score = min_search_score;
+  options.exclude_ids = std::move(exclude_ids);
+  co_return index.search(embedding, options);
+}
@@ -0,0 +1,179 @@
+#include <AnalyticsQuery.h>
+#include <MessageSearch.h>
+
+#include <algorithm>
+#include <cctype>
+#include <format>
+#include <set>
+
+#include <ollama.hpp>
+
+namespace {
+
+// Shorter queries have no trigram and fall back to a sequential scan.
+constexpr std::size_t min_query_chars = 3;
+constexpr std::size_t max_query_chars = 200;
+// Matches ranked by the relevance sort, newest first.
+constexpr int max_ranked_candidates = 500;
+
+std::string trim_copy(const std::string &value) {
+  const auto start = std::find_if_not(value.begin(), value.end(), [](unsigned char ch) {
+    return std::isspace(ch) != 0;
+  });
+  if (start == value.end()) {
+    return "";
+  }
+  const auto end = std::find_if_not(value.rbegin(), value.rend(), [](unsigned char ch) {
+    return std::isspace(ch) != 0;
+  }).base();
+  return std::string(start, end);
+}
+
+std::string to_lower_copy(std::string value) {
+  std::transform(value.begin(), value.end(), value.begin(), [](unsigned char ch) {
+    return static_cast<char>(std::tolower(ch));
+  });
+  return value;
+}
+
+std::string optional_lower_string(const ollama::json &request, const char *key,
+                                  const std::string &fallback) {
+  if (request.contains(key) && request[key].is_string()) {
+    return to_lower_copy(request[key].get<std::string>());
+  }
+  return fallback;
+}
+
+} // namespace
+
+namespace message_search {
+
+std::string escape_like(const std::string &text) {
+  std::string escaped;
+  escaped.reserve(text.size());
+  for (const char ch : text) {
+    if (ch == '%' || ch == '_' || ch == '\\') {
+      escaped += '\\';
+    }
+    escaped += ch;
+  }
+  return escaped;
+}
+
+ParseResult parse_and_compile(const std::string &request_json) {
+  ollama::json request;
+  try {
+    request = ollama::json::parse(request_json);
+  } catch (...) {
+    return {std::nullopt, "invalid tool arguments JSON."};
+  }
+
+  if (!request.is_object()) {
+    return {std::nullopt, "request must be a JSON object."};
+  }
+  if (!request.contains("query") || !request["query"].is_string()) {
+    return {std::nullopt, "missing required argument 'query'."};
+  }
+
+  const std::string query = trim_copy(request["query"].get<std::string>());
+  const auto query_chars = static_cast<std::size_t>(
+      std::count_if(query.begin(), query.end(),
+                    [](unsigned char ch) { return (ch & 0xC0) != 0x80; }));
+  if (query_chars < min_query_chars) {
+    return {std::nullopt, "query is too short (min 3 characters)."};
+  }
+  if (query.size() > max_query_chars) {
+    return {std::nullopt, "query is too long (max 200 characters)."};
+  }
+
+  const std::string scope = optional_lower_string(request, "scope", "server");
+  const std::string sort = optional_lower_string(request, "sort", "relevance");
+  const std::string time_range =
+      optional_lower_string(request, "time_range", "all_time");
+
+  static const std::set<std::string> allowed_scopes = {"channel", "server"};
+  static const std::set<std::string> allowed_sorts = {"relevance", "newest"};
+  if (!allowed_scopes.contains(scope)) {
+    return {std::nullopt, "unsupported scope. Use channel or server."};
+  }
+  if (!allowed_sorts.contains(sort)) {
+    return {std::nullopt, "unsupported sort. Use relevance or newest."};
+  }
+
+  const std::string time_filter =
+      analytics_query::time_filter_sql(time_range, "m.created_at");
+  if (time_filter.empty()) {
+    return {std::nullopt, "unsupported time_range."};
+  }
+
+  int limit = 8;
+  if (request.contains("limit")) {
+    if (!request["limit"].is_number_integer()) {
+      return {std::nullopt, "limit must be an integer."};
+    }
+    limit = std::clamp(request["limit"].get<int>(), 1, 20);
+  }
+
+  // $2 is the full-text query, $3 the substring pattern that the trigram
+  // index serves (partial words, model names like "ioniq 5").
+  std::vector<std::string> bind_params = {query, "%" + escape_like(query) + "%"};
+
+  std::string author_filter = "1 = 1";
+  if (request.contains("author") && request["author"].is_string()) {
+    const std::string author = trim_copy(request["author"].get<std::string>());
+    if (!author.empty()) {
+      bind_params.push_back(escape_like(author));
+      author_filter = std::format("u.user_name ilike ${}", bind_params.size() + 1);
+    }
+  }
+
+  const std::string scope_filter =
+      scope == "server" ? "s.server_snowflake_id = $1" : "c.channel_snowflake_id = $1";
+  const std::string scope_join =
+      scope == "server" ? " join server s on s.server_id = c.server_id " : "";
+  // Ranking a common word would score a large share of the table, so only
+  // the newest matches are ranked. Newest-first needs no more than the limit.
+  const int candidates = sort == "newest" ? limit : max_ranked_candidates;
+  const std::string order_by =
+      sort == "newest" ? "m.message_id desc" : "score desc, m.message_id desc";
+
+  // The tsvector expression matches message_content_tsv_idx.
+  const std::string sql = std::format(
+      "select m.message_snowflake_id::text as message_id, "
+      "to_char(m.created_at, 'YYYY-MM-DD HH24:MI') as created_at, "
+      "m.author, "
+      "m.channel, "
+      "left(coalesce(m.content, ''), 200) as snippet, "
+      "round((ts_rank_cd(to_tsvector('simple', coalesce(m.content, '')), "
+      "q.query) + similarity(coalesce(m.content, ''), $2))::numeric, 3) "
+      "as score "
+      "from ("
+      "select m.message_id, m.message_snowflake_id, m.created_at, m.content, "
+      "u.user_name as author, c.channel_name as channel "
+      "from message m "
+      "join channel c on c.channel_id = m.channel_id "
+      "{}"
+      "join discord_user u on u.user_id = m.user_id "
+      "where ({}) and ({}) and ({}) "
+      "and (to_tsvector('simple', coalesce(m.content, '')) @@ "
+      "websearch_to_tsquery('simple', $2) or m.content ilike $3) "
+      "order by m.message_id desc "
+      "limit {}"
+      ") m "
+      "cross join websearch_to_tsquery('simple', $2) as q(query) "
+      "order by {} "
+      "limit {}",
+      scope_join, scope_filter, time_filter, author_filter, candidates,
+      order_by, limit);
+
+  return {CompiledSearch{.sql = sql,
+                         .bind_params = std::move(bind_params),
+                         .limit = limit,
+                         .scope = scope,
+                         .query = query,
+                         .sort = sort,
+                         .time_range = time_range},
+          ""};
+}
+
+} // namespace message_search
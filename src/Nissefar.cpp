@@ -1,9 +1,12 @@
 #include <Database.h>
 #include <DiscordEventService.h>
 #include <CalculationService.h>
+#include <ConversationSummaryService.h>
 #include <GoogleDocsService.h>
 #include <LlmService.h>
+#include <MessageIndexService.h>
 #include <Nissefar.h>
+#include <ToolResultCache.h>
 #include <VideoSummaryService.h>
 #include <WebPageService.h>
 #include <YoutubeService.h>
@@ -27,17 +30,23 @@ Nissefar::Nissefar() {
            std::format("LLM context size: {}", config.context_size));
 
   llm_service = std::make_unique<LlmService>(config, *bot);
-  google_docs_service =
-      std::make_unique<GoogleDocsService>(config, *bot, *llm_service);
+  tool_result_cache = std::make_unique<ToolResultCache>();
+  google_docs_service = std::make_unique<GoogleDocsService>(
+      config, *bot, *llm_service, *tool_result_cache);
   youtube_service =
       std::make_unique<YoutubeService>(config, *bot, *llm_service);
   web_page_service = std::make_unique<WebPageService>(*bot);
   video_summary_service =
       std::make_unique<VideoSummaryService>(config, *bot);
   calculation_service = std::make_unique<CalculationService>(*bot);
+  conversation_summary_service = std::make_unique<ConversationSummaryService>(
+      config, *bot, *llm_service);
+  message_index_service =
+      std::make_unique<MessageIndexService>(config, *bot, *llm_service);
   discord_event_service = std::make_unique<DiscordEventService>(
       config, *bot, *llm_service, *google_docs_service, *web_page_service,
-      *youtube_service, *video_summary_service, *calculation_service);
+      *youtube_service, *video_summary_service, *calculation_service,
+      *tool_result_cache, *message_index_service);
 
   bot->log(dpp::ll_info, "Bot initialized");
 }
@@ -115,6 +124,17 @@ void Nissefar::run() {
       },
       300);
 
+  // Push notifications only raise a flag; acting on it from the timer keeps
+  // refreshes on the bot's own threads.
+  if (google_docs_service->watch_enabled()) {
+    bot->log(dpp::ll_info, "Starting Drive notification timer, 5 seconds");
+    bot->start_timer(
+        [this](const dpp::timer &timer) -> dpp::task<void> {
+          co_return co_await google_docs_service->process_notifications();
+        },
+        5);
+  }
+
   bot->log(dpp::ll_info, "Starting youtube timer, 1500 seconds");
   bot->start_timer(
       [this](const dpp::timer &timer) -> dpp::task<void> {
@@ -122,6 +142,22 @@ void Nissefar::run() {
       },
       1500);
 
+  bot->log(dpp::ll_info, "Starting conversation summary timer, 600 seconds");
+  bot->start_timer(
+      [this](const dpp::timer &timer) -> dpp::task<void> {
+        co_return co_await conversation_summary_service->process();
+      },
+      600);
+
+  if (message_index_service->enabled()) {
+    bot->log(dpp::ll_info, "Starting message index timer, 30 seconds");
+    bot->start_timer(
+        [this](const dpp::timer &timer) -> dpp::task<void> {
+          co_return co_await message_index_service->process();
+        },
+        30);
+  }
+
   bot->log(dpp::ll_info, "Starting bot..");
   bot->start(dpp::st_wait);
 }
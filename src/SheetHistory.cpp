@@ -0,0 +1,412 @@
+#include <CsvParser.h>
+#include <RowHash.h>
+#include <SheetHistory.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include <zlib.h>
+
+namespace {
+
+constexpr char record_magic[4] = {'N', 'S', 'R', '1'};
+constexpr std::uint8_t kind_checkpoint = 0;
+constexpr std::uint8_t kind_delta = 1;
+// Refuse absurd sizes from a corrupt header.
+constexpr std::uint32_t max_body_bytes = 1U << 28;
+constexpr std::uint32_t max_name_bytes = 4096;
+
+template <typename T> void append_pod(std::string &out, const T &value) {
+  out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void append_string(std::string &out, std::string_view value) {
+  append_pod(out, static_cast<std::uint32_t>(value.size()));
+  out += value;
+}
+
+template <typename T> bool read_pod(std::istream &in, T &value) {
+  return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+bool read_string(std::istream &in, std::string &value) {
+  std::uint32_t size = 0;
+  if (!read_pod(in, size) || size > max_name_bytes)
+    return false;
+  value.resize(size);
+  return static_cast<bool>(in.read(value.data(), size));
+}
+
+// Bounds-checked reads from an inflated record body.
+class Reader {
+public:
+  explicit Reader(std::string_view data) : data(data) {}
+
+  template <typename T> bool pod(T &value) {
+    if (data.size() < sizeof(T))
+      return false;
+    std::memcpy(&value, data.data(), sizeof(T));
+    data.remove_prefix(sizeof(T));
+    return true;
+  }
+
+  bool string(std::string &value) {
+    std::uint32_t size = 0;
+    if (!pod(size) || data.size() < size)
+      return false;
+    value.assign(data.substr(0, size));
+    data.remove_prefix(size);
+    return true;
+  }
+
+private:
+  std::string_view data;
+};
+
+struct RecordHeader {
+  std::uint8_t kind = 0;
+  std::int64_t time_ms = 0;
+  std::int32_t sheet_id = 0;
+  std::string file_name;
+  std::string sheet_name;
+  std::uint64_t csv_hash = 0;
+  std::uint64_t csv_size = 0;
+  std::uint32_t body_size = 0;
+  std::uint32_t compressed_size = 0;
+  std::uint64_t body_checksum = 0;
+};
+
+bool read_header(std::istream &in, RecordHeader &header) {
+  char magic[sizeof(record_magic)];
+  return in.read(magic, sizeof(magic)) &&
+         std::memcmp(magic, record_magic, sizeof(magic)) == 0 &&
+         read_pod(in, header.kind) && header.kind <= kind_delta &&
+         read_pod(in, header.time_ms) && read_pod(in, header.sheet_id) &&
+         read_string(in, header.file_name) &&
+         read_string(in, header.sheet_name) && read_pod(in, header.csv_hash) &&
+         read_pod(in, header.csv_size) && read_pod(in, header.body_size) &&
+         read_pod(in, header.compressed_size) &&
+         read_pod(in, header.body_checksum) &&
+         header.body_size <= max_body_bytes &&
+         header.compressed_size <= max_body_bytes;
+}
+
+// Header line and data rows of a tab as CSV records.
+std::vector<std::string> tab_records(const SheetTab &tab) {
+  std::vector<std::string> records;
+  records.reserve(tab.rows.size() + 1);
+  records.push_back(csv_join(tab.header));
+  for (const auto &row : tab.rows)
+    records.push_back(csv_join(row));
+  return records;
+}
+
+std::string join_records(const std::vector<std::string> &records) {
+  std::string csv;
+  for (const auto &record : records) {
+    csv += record;
+    csv += '\n';
+  }
+  return csv;
+}
+
+// Hash of the tab as rebuild returns it; the raw export may quote or pad
+// differently.
+std::uint64_t version_hash(const SheetTab &tab) {
+  return xxhash64(join_records(tab_records(tab)));
+}
+
+// Hashes of the rows not listed in changed, in order.
+std::vector<std::uint64_t> kept_rows(const SheetTab &tab,
+                                     const std::vector<std::size_t> &changed) {
+  std::vector<std::uint64_t> kept;
+  kept.reserve(tab.row_hashes.size());
+  auto next = changed.begin();
+  for (std::size_t i = 0; i < tab.row_hashes.size(); ++i) {
+    if (next != changed.end() && *next == i) {
+      ++next;
+      continue;
+    }
+    kept.push_back(tab.row_hashes[i]);
+  }
+  return kept;
+}
+
+} // namespace
+
+std::optional<SheetHistory::TimePoint>
+parse_history_date(std::string_view text) {
+  int y = 0;
+  unsigned m = 0;
+  unsigned d = 0;
+  if (text.size() != 10 || text[4] != '-' || text[7] != '-')
+    return std::nullopt;
+  const char *p = text.data();
+  if (std::from_chars(p, p + 4, y).ptr != p + 4 ||
+      std::from_chars(p + 5, p + 7, m).ptr != p + 7 ||
+      std::from_chars(p + 8, p + 10, d).ptr != p + 10)
+    return std::nullopt;
+  const std::chrono::year_month_day date{
+      std::chrono::year{y}, std::chrono::month{m}, std::chrono::day{d}};
+  if (!date.ok())
+    return std::nullopt;
+  return std::chrono::time_point_cast<std::chrono::milliseconds>(
+      std::chrono::sys_days{date});
+}
+
+SheetHistory::SheetHistory(std::string path, std::size_t checkpoint_interval)
+    : path(std::move(path)),
+      checkpoint_interval(std::max<std::size_t>(checkpoint_interval, 1)) {}
+
+bool SheetHistory::open() {
+  std::lock_guard lock(mutex);
+  logs.clear();
+  file_bytes = 0;
+  full_copy_bytes = 0;
+
+  std::error_code error;
+  if (!std::filesystem::exists(path, error))
+    return true;
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    return false;
+
+  const std::uint64_t size = std::filesystem::file_size(path, error);
+  std::uint64_t good_end = 0;
+  while (!error && good_end < size) {
+    RecordHeader header;
+    if (!in.seekg(static_cast<std::streamoff>(good_end)) ||
+        !read_header(in, header))
+      break;
+    const std::uint64_t end =
+        static_cast<std::uint64_t>(in.tellg()) + header.compressed_size;
+    if (end > size)
+      break;
+
+    auto &log = logs[{header.file_name, header.sheet_id}];
+    log.sheet_name = header.sheet_name;
+    const bool checkpoint = header.kind == kind_checkpoint;
+    log.entries.push_back(Entry{
+        TimePoint(std::chrono::milliseconds(header.time_ms)), good_end,
+        checkpoint});
+    log.since_checkpoint = checkpoint ? 0 : log.since_checkpoint + 1;
+    log.last_csv_hash = header.csv_hash;
+    full_copy_bytes += header.csv_size;
+    good_end = end;
+  }
+  in.close();
+
+  // A crash mid-append leaves a partial record; drop it so appends line up.
+  if (!error && good_end != size)
+    std::filesystem::resize_file(path, good_end, error);
+  file_bytes = good_end;
+  return !error;
+}
+
+bool SheetHistory::record(const SheetTab *previous, const SheetTab &current,
+                          TimePoint time) {
+  std::lock_guard lock(mutex);
+  auto &log = logs[{current.file_name, current.sheet_id}];
+  if (!log.entries.empty())
+    time = std::max(time, log.entries.back().time);
+
+  const std::uint64_t csv_hash = version_hash(current);
+  // Without a snapshot every tab is new after a restart; the version it
+  // fetched again is already the last one recorded.
+  if (!log.entries.empty() && csv_hash == log.last_csv_hash)
+    return true;
+  bool checkpoint = previous == nullptr || log.entries.empty() ||
+                    log.since_checkpoint + 1 >= checkpoint_interval ||
+                    version_hash(*previous) != log.last_csv_hash;
+
+  std::string body;
+  if (!checkpoint) {
+    const auto changes = changed_rows(*previous, current);
+    // A delta removes and inserts rows by position around the rows both
+    // versions share, so those rows must not have moved; a reordered tab
+    // gets a checkpoint.
+    checkpoint = changes.header_changed ||
+                 kept_rows(*previous, changes.removed) !=
+                     kept_rows(current, changes.added);
+    append_pod(body, static_cast<std::uint32_t>(changes.removed.size()));
+    for (const auto index : changes.removed)
+      append_pod(body, static_cast<std::uint32_t>(index));
+    append_pod(body, static_cast<std::uint32_t>(changes.added.size()));
+    for (const auto index : changes.added) {
+      append_pod(body, static_cast<std::uint32_t>(index));
+      append_string(body, csv_join(current.rows[index]));
+    }
+    // A rewrite of most rows is cheaper to store whole.
+    checkpoint = checkpoint || body.size() > current.csv->size() / 2;
+  }
+  if (checkpoint) {
+    body.clear();
+    append_string(body, *current.csv);
+  }
+
+  uLongf compressed_size = compressBound(body.size());
+  std::string compressed(compressed_size, '\0');
+  if (compress2(reinterpret_cast<Bytef *>(compressed.data()), &compressed_size,
+                reinterpret_cast<const Bytef *>(body.data()), body.size(),
+                Z_BEST_SPEED) != Z_OK ||
+      body.size() > max_body_bytes)
+    return false;
+  compressed.resize(compressed_size);
+
+  std::string record(record_magic, sizeof(record_magic));
+  append_pod(record, checkpoint ? kind_checkpoint : kind_delta);
+  append_pod(record, static_cast<std::int64_t>(time.time_since_epoch().count()));
+  append_pod(record, static_cast<std::int32_t>(current.sheet_id));
+  append_string(record, current.file_name);
+  append_string(record, current.name);
+  append_pod(record, csv_hash);
+  append_pod(record, static_cast<std::uint64_t>(current.csv->size()));
+  append_pod(record, static_cast<std::uint32_t>(body.size()));
+  append_pod(record, static_cast<std::uint32_t>(compressed.size()));
+  append_pod(record, xxhash64(body));
+  record += compressed;
+
+  std::ofstream out(path, std::ios::binary | std::ios::app);
+  if (!out || !out.write(record.data(),
+                         static_cast<std::streamsize>(record.size())) ||
+      !out.flush())
+    return false;
+
+  log.sheet_name = current.name;
+  log.entries.push_back(Entry{time, file_bytes, checkpoint});
+  log.since_checkpoint = checkpoint ? 0 : log.since_checkpoint + 1;
+  log.last_csv_hash = csv_hash;
+  file_bytes += record.size();
+  full_copy_bytes += current.csv->size();
+  return true;
+}
+
+const SheetHistory::TabLog *
+SheetHistory::find_log(std::string_view sheet_name) const {
+  // Same rule as the sheet store: the file that sorts first wins.
+  for (const auto &[key, log] : logs) {
+    if (log.sheet_name == sheet_name && !log.entries.empty())
+      return &log;
+  }
+  return nullptr;
+}
+
+std::optional<SheetHistory::Version>
+SheetHistory::rebuild(const TabLog &log, std::size_t index) const {
+  std::size_t first = index;
+  while (!log.entries[first].checkpoint) {
+    if (first == 0)
+      return std::nullopt;
+    --first;
+  }
+
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    return std::nullopt;
+
+  std::vector<std::string> records;
+  RecordHeader header;
+  for (std::size_t i = first; i <= index; ++i) {
+    if (!in.seekg(static_cast<std::streamoff>(log.entries[i].offset)) ||
+        !read_header(in, header))
+      return std::nullopt;
+    std::string compressed(header.compressed_size, '\0');
+    std::string body(header.body_size, '\0');
+    uLongf body_size = header.body_size;
+    if (!in.read(compressed.data(), header.compressed_size) ||
+        uncompress(reinterpret_cast<Bytef *>(body.data()), &body_size,
+                   reinterpret_cast<const Bytef *>(compressed.data()),
+                   compressed.size()) != Z_OK ||
+        body_size != header.body_size ||
+        xxhash64(body) != header.body_checksum)
+      return std::nullopt;
+
+    Reader reader(body);
+    if (header.kind == kind_checkpoint) {
+      std::string csv;
+      if (!reader.string(csv))
+        return std::nullopt;
+      records = tab_records(SheetStore::parse({}, 0, {}, std::move(csv)));
+      continue;
+    }
+
+    // Delta indices are positions among the data rows, after the header.
+    std::uint32_t removed_count = 0;
+    if (!reader.pod(removed_count))
+      return std::nullopt;
+    std::vector<std::uint32_t> removed(removed_count);
+    for (auto &row : removed) {
+      if (!reader.pod(row) || row + 1 >= records.size())
+        return std::nullopt;
+    }
+    std::ranges::sort(removed, std::greater<>());
+    for (const auto row : removed)
+      records.erase(records.begin() + row + 1);
+
+    std::uint32_t added_count = 0;
+    if (!reader.pod(added_count))
+      return std::nullopt;
+    for (std::uint32_t n = 0; n < added_count; ++n) {
+      std::uint32_t row = 0;
+      std::string record;
+      if (!reader.pod(row) || !reader.string(record))
+        return std::nullopt;
+      const std::size_t at = std::min<std::size_t>(row + 1, records.size());
+      records.insert(records.begin() + static_cast<std::ptrdiff_t>(at),
+                     std::move(record));
+    }
+  }
+  // Catches a delta that does not apply to the rows it was written against.
+  std::string csv = join_records(records);
+  if (xxhash64(csv) != header.csv_hash)
+    return std::nullopt;
+  return Version{log.entries[index].time, std::move(csv)};
+}
+
+std::optional<SheetHistory::Version>
+SheetHistory::version_at(std::string_view sheet_name, TimePoint time) const {
+  std::lock_guard lock(mutex);
+  const auto *log = find_log(sheet_name);
+  if (log == nullptr)
+    return std::nullopt;
+  const auto it = std::ranges::upper_bound(log->entries, time, {}, &Entry::time);
+  if (it == log->entries.begin())
+    return std::nullopt;
+  return rebuild(*log, static_cast<std::size_t>(it - log->entries.begin()) - 1);
+}
+
+std::optional<SheetHistory::Version>
+SheetHistory::first_version(std::string_view sheet_name) const {
+  std::lock_guard lock(mutex);
+  const auto *log = find_log(sheet_name);
+  if (log == nullptr)
+    return std::nullopt;
+  return rebuild(*log, 0);
+}
+
+std::vector<SheetHistory::VersionInfo>
+SheetHistory::versions(std::string_view sheet_name) const {
+  std::lock_guard lock(mutex);
+  std::vector<VersionInfo> out;
+  if (const auto *log = find_log(sheet_name)) {
+    for (const auto &entry : log->entries)
+      out.push_back(VersionInfo{entry.time, entry.checkpoint});
+  }
+  return out;
+}
+
+SheetHistory::Stats SheetHistory::stats() const {
+  std::lock_guard lock(mutex);
+  Stats stats;
+  stats.tabs = logs.size();
+  for (const auto &[key, log] : logs) {
+    for (const auto &entry : log.entries)
+      ++(entry.checkpoint ? stats.checkpoints : stats.deltas);
+  }
+  stats.file_bytes = file_bytes;
+  stats.full_copy_bytes = full_copy_bytes;
+  return stats;
+}
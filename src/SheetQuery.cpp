@@ -0,0 +1,312 @@
+#include <SheetQuery.h>
+
+#include <algorithm>
+#include <cctype>
+#include <format>
+#include <numeric>
+#include <set>
+
+#include <ollama.hpp>
+
+namespace {
+
+constexpr int max_limit = 50;
+constexpr std::size_t max_filters = 8;
+
+const std::set<std::string> &allowed_ops() {
+  static const std::set<std::string> ops = {"eq", "ne", "contains",
+                                            "lt", "le", "gt", "ge"};
+  return ops;
+}
+
+// Lowercase with runs of whitespace collapsed, so "Model  Y" matches
+// "model y".
+std::string normalize(std::string_view value) {
+  std::string out;
+  out.reserve(value.size());
+  bool space = false;
+  for (const unsigned char ch : value) {
+    if (std::isspace(ch) != 0) {
+      space = !out.empty();
+      continue;
+    }
+    if (space) {
+      out += ' ';
+      space = false;
+    }
+    out += static_cast<char>(std::tolower(ch));
+  }
+  return out;
+}
+
+// Exact name first, then a unique case-insensitive substring.
+std::optional<std::size_t> resolve_column(const SheetTab &tab,
+                                          const std::string &name) {
+  const std::string wanted = normalize(name);
+  std::optional<std::size_t> partial;
+  bool ambiguous = false;
+  for (std::size_t i = 0; i < tab.header.size(); ++i) {
+    const std::string column = normalize(tab.header[i]);
+    if (column == wanted) {
+      return i;
+    }
+    if (!wanted.empty() && column.find(wanted) != std::string::npos) {
+      ambiguous = partial.has_value();
+      partial = i;
+    }
+  }
+  if (ambiguous) {
+    return std::nullopt;
+  }
+  return partial;
+}
+
+std::string column_list(const SheetTab &tab) {
+  std::string out;
+  for (const auto column : tab.header) {
+    if (column.empty()) {
+      continue;
+    }
+    if (!out.empty()) {
+      out += ", ";
+    }
+    out += column;
+  }
+  return out;
+}
+
+bool matches(std::string_view cell, const sheet_query::Filter &filter) {
+  const auto cell_number = parse_sheet_number(cell);
+  const auto value_number = parse_sheet_number(filter.value);
+  const bool numeric = cell_number.has_value() && value_number.has_value();
+
+  if (filter.op == "contains") {
+    return normalize(cell).find(normalize(filter.value)) != std::string::npos;
+  }
+  if (filter.op == "eq" || filter.op == "ne") {
+    const bool equal = numeric ? *cell_number == *value_number
+                               : normalize(cell) == normalize(filter.value);
+    return filter.op == "eq" ? equal : !equal;
+  }
+  // Ordering only makes sense on numbers; text and empty cells never match.
+  if (!numeric) {
+    return false;
+  }
+  if (filter.op == "lt") {
+    return *cell_number < *value_number;
+  }
+  if (filter.op == "le") {
+    return *cell_number <= *value_number;
+  }
+  if (filter.op == "gt") {
+    return *cell_number > *value_number;
+  }
+  return *cell_number >= *value_number;
+}
+
+} // namespace
+
+namespace sheet_query {
+
+ParseResult parse(const std::string &request_json) {
+  ollama::json request;
+  try {
+    request = ollama::json::parse(request_json);
+  } catch (...) {
+    return {std::nullopt, "invalid tool arguments JSON."};
+  }
+
+  if (!request.is_object()) {
+    return {std::nullopt, "request must be a JSON object."};
+  }
+  if (!request.contains("sheet") || !request["sheet"].is_string()) {
+    return {std::nullopt, "missing required argument 'sheet'."};
+  }
+
+  Query query;
+  query.sheet = request["sheet"].get<std::string>();
+
+  if (request.contains("columns")) {
+    if (!request["columns"].is_array()) {
+      return {std::nullopt, "columns must be an array of column names."};
+    }
+    for (const auto &column : request["columns"]) {
+      if (!column.is_string()) {
+        return {std::nullopt, "columns must be an array of column names."};
+      }
+      query.columns.push_back(column.get<std::string>());
+    }
+  }
+
+  if (request.contains("filters")) {
+    if (!request["filters"].is_array()) {
+      return {std::nullopt, "filters must be an array."};
+    }
+    if (request["filters"].size() > max_filters) {
+      return {std::nullopt, "too many filters (max 8)."};
+    }
+    for (const auto &item : request["filters"]) {
+      if (!item.is_object() || !item.contains("column") ||
+          !item["column"].is_string() || !item.contains("value")) {
+        return {std::nullopt, "each filter needs 'column' and 'value'."};
+      }
+      Filter filter;
+      filter.column = item["column"].get<std::string>();
+      filter.op = item.contains("op") && item["op"].is_string()
+                      ? item["op"].get<std::string>()
+                      : "contains";
+      if (!allowed_ops().contains(filter.op)) {
+        return {std::nullopt,
+                std::format("unsupported filter op '{}'.", filter.op)};
+      }
+      const auto &value = item["value"];
+      if (value.is_string()) {
+        filter.value = value.get<std::string>();
+      } else if (value.is_number()) {
+        filter.value = value.dump();
+      } else {
+        return {std::nullopt, "filter value must be a string or number."};
+      }
+      query.filters.push_back(std::move(filter));
+    }
+  }
+
+  if (request.contains("sort_by") && request["sort_by"].is_string()) {
+    query.sort_by = request["sort_by"].get<std::string>();
+  }
+  if (request.contains("order") && request["order"].is_string()) {
+    query.descending = request["order"].get<std::string>() == "desc";
+  }
+  if (request.contains("limit") && request["limit"].is_number_integer()) {
+    query.limit = std::clamp(request["limit"].get<int>(), 1, max_limit);
+  }
+
+  return {std::move(query), ""};
+}
+
+QueryResult run(const SheetTab &tab, const Query &query,
+                std::size_t max_output_bytes) {
+  QueryResult result;
+
+  auto unknown_column = [&](const std::string &name) {
+    result.error = std::format("unknown or ambiguous column '{}'. Columns: {}",
+                               name, column_list(tab));
+    if (result.error.size() > max_output_bytes) {
+      result.error.resize(max_output_bytes);
+    }
+  };
+
+  std::vector<std::pair<std::size_t, const Filter *>> filters;
+  for (const auto &filter : query.filters) {
+    const auto column = resolve_column(tab, filter.column);
+    if (!column) {
+      unknown_column(filter.column);
+      return result;
+    }
+    filters.emplace_back(*column, &filter);
+  }
+
+  std::vector<std::size_t> projection;
+  if (query.columns.empty()) {
+    projection.resize(tab.header.size());
+    std::iota(projection.begin(), projection.end(), 0);
+  } else {
+    if (!tab.header.empty()) {
+      projection.push_back(0);
+    }
+    for (const auto &name : query.columns) {
+      const auto column = resolve_column(tab, name);
+      if (!column) {
+        unknown_column(name);
+        return result;
+      }
+      if (std::ranges::find(projection, *column) == projection.end()) {
+        projection.push_back(*column);
+      }
+    }
+  }
+
+  std::optional<std::size_t> sort_column;
+  if (!query.sort_by.empty()) {
+    sort_column = resolve_column(tab, query.sort_by);
+    if (!sort_column) {
+      unknown_column(query.sort_by);
+      return result;
+    }
+  }
+
+  std::vector<const std::vector<std::string_view> *> rows;
+  for (const auto &row : tab.rows) {
+    const bool keep = std::ranges::all_of(filters, [&row](const auto &f) {
+      return matches(row[f.first], *f.second);
+    });
+    if (keep) {
+      rows.push_back(&row);
+    }
+  }
+  result.matched_rows = rows.size();
+
+  if (sort_column) {
+    // Numbers before text, empty cells last in either direction.
+    const std::size_t col = *sort_column;
+    const bool descending = query.descending;
+    std::ranges::stable_sort(rows, [col, descending](const auto *a,
+                                                     const auto *b) {
+      const auto &x = (*a)[col];
+      const auto &y = (*b)[col];
+      if (x.empty() != y.empty()) {
+        return y.empty();
+      }
+      const auto xn = parse_sheet_number(x);
+      const auto yn = parse_sheet_number(y);
+      if (xn.has_value() != yn.has_value()) {
+        return xn.has_value();
+      }
+      if (xn) {
+        return descending ? *xn > *yn : *xn < *yn;
+      }
+      return descending ? normalize(x) > normalize(y)
+                        : normalize(x) < normalize(y);
+    });
+  }
+
+  auto serialize = [&projection](const std::vector<std::string_view> &row) {
+    std::string line;
+    for (std::size_t i = 0; i < projection.size(); ++i) {
+      if (i != 0) {
+        line += ',';
+      }
+      line += csv_escape(row[projection[i]]);
+    }
+    line += '\n';
+    return line;
+  };
+
+  const std::size_t wanted =
+      std::min(rows.size(), static_cast<std::size_t>(query.limit));
+  std::string body = serialize(tab.header);
+  for (std::size_t i = 0; i < wanted; ++i) {
+    std::string line = serialize(*rows[i]);
+    // Leave room for the summary line.
+    if (body.size() + line.size() + 80 > max_output_bytes) {
+      break;
+    }
+    body += line;
+    ++result.returned_rows;
+  }
+
+  result.output =
+      std::format("Sheet: {} ({} of {} rows matched, showing {}{})\n",
+                  tab.name, result.matched_rows, tab.rows.size(),
+                  result.returned_rows,
+                  result.returned_rows < result.matched_rows
+                      ? "; refine filters or raise limit for more"
+                      : "") +
+      body;
+  if (result.output.size() > max_output_bytes) {
+    result.output.resize(max_output_bytes);
+  }
+  return result;
+}
+
+} // namespace sheet_query
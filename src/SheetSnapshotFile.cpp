@@ -0,0 +1,169 @@
+#include <RowHash.h>
+#include <SheetSnapshotFile.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include <zlib.h>
+
+namespace {
+
+constexpr char file_magic[4] = {'N', 'S', 'H', '1'};
+// Refuse to inflate absurd sizes from a corrupt header.
+constexpr std::uint64_t max_payload_bytes = 1ULL << 30;
+
+template <typename T> void write_pod(std::ofstream &out, const T &value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T> bool read_pod(std::ifstream &in, T &value) {
+  return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+template <typename T> void append_pod(std::string &out, const T &value) {
+  out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void append_string(std::string &out, const std::string &value) {
+  append_pod(out, static_cast<std::uint32_t>(value.size()));
+  out += value;
+}
+
+// Bounds-checked reads from the inflated payload.
+class Reader {
+public:
+  explicit Reader(std::string_view data) : data(data) {}
+
+  template <typename T> bool pod(T &value) {
+    if (data.size() < sizeof(T))
+      return false;
+    std::memcpy(&value, data.data(), sizeof(T));
+    data.remove_prefix(sizeof(T));
+    return true;
+  }
+
+  bool string(std::string &value) {
+    std::uint32_t size = 0;
+    if (!pod(size) || data.size() < size)
+      return false;
+    value.assign(data.substr(0, size));
+    data.remove_prefix(size);
+    return true;
+  }
+
+  bool done() const { return data.empty(); }
+
+private:
+  std::string_view data;
+};
+
+} // namespace
+
+bool save_sheet_snapshot(
+    const std::string &path, const SheetStore::Snapshot &snapshot,
+    const std::map<std::string,
+                   std::chrono::sys_time<std::chrono::milliseconds>>
+        &timestamps,
+    const std::string &page_token) {
+  std::string payload;
+  append_pod(payload, static_cast<std::uint32_t>(timestamps.size()));
+  for (const auto &[file_name, time] : timestamps) {
+    append_string(payload, file_name);
+    append_pod(payload,
+               static_cast<std::int64_t>(time.time_since_epoch().count()));
+  }
+  append_pod(payload, static_cast<std::uint32_t>(snapshot.tabs.size()));
+  for (const auto &[key, tab] : snapshot.tabs) {
+    append_string(payload, tab->file_name);
+    append_pod(payload, static_cast<std::int32_t>(tab->sheet_id));
+    append_string(payload, tab->name);
+    append_string(payload, *tab->csv);
+  }
+  append_string(payload, page_token);
+
+  uLongf compressed_size = compressBound(payload.size());
+  std::string compressed(compressed_size, '\0');
+  if (compress2(reinterpret_cast<Bytef *>(compressed.data()), &compressed_size,
+                reinterpret_cast<const Bytef *>(payload.data()),
+                payload.size(), Z_BEST_SPEED) != Z_OK)
+    return false;
+  compressed.resize(compressed_size);
+
+  const std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!out)
+      return false;
+
+    out.write(file_magic, sizeof(file_magic));
+    write_pod(out, static_cast<std::uint64_t>(payload.size()));
+    write_pod(out, xxhash64(payload));
+    out.write(compressed.data(),
+              static_cast<std::streamsize>(compressed.size()));
+    if (!out)
+      return false;
+  }
+  return std::rename(tmp_path.c_str(), path.c_str()) == 0;
+}
+
+std::optional<PersistedSheets> load_sheet_snapshot(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    return std::nullopt;
+
+  char magic[sizeof(file_magic)];
+  if (!in.read(magic, sizeof(magic)) ||
+      std::memcmp(magic, file_magic, sizeof(magic)) != 0)
+    return std::nullopt;
+
+  std::uint64_t payload_size = 0;
+  std::uint64_t checksum = 0;
+  if (!read_pod(in, payload_size) || !read_pod(in, checksum) ||
+      payload_size > max_payload_bytes)
+    return std::nullopt;
+
+  const std::string compressed{std::istreambuf_iterator<char>(in),
+                               std::istreambuf_iterator<char>()};
+  std::string payload(payload_size, '\0');
+  uLongf inflated_size = payload_size;
+  if (uncompress(reinterpret_cast<Bytef *>(payload.data()), &inflated_size,
+                 reinterpret_cast<const Bytef *>(compressed.data()),
+                 compressed.size()) != Z_OK ||
+      inflated_size != payload_size || xxhash64(payload) != checksum)
+    return std::nullopt;
+
+  PersistedSheets sheets;
+  Reader reader(payload);
+  std::uint32_t count = 0;
+  if (!reader.pod(count))
+    return std::nullopt;
+  for (std::uint32_t i = 0; i < count; ++i) {
+    std::string file_name;
+    std::int64_t millis = 0;
+    if (!reader.string(file_name) || !reader.pod(millis))
+      return std::nullopt;
+    sheets.timestamps[std::move(file_name)] =
+        std::chrono::sys_time<std::chrono::milliseconds>(
+            std::chrono::milliseconds(millis));
+  }
+
+  if (!reader.pod(count))
+    return std::nullopt;
+  for (std::uint32_t i = 0; i < count; ++i) {
+    SheetStore::TabUpdate tab;
+    std::int32_t sheet_id = 0;
+    if (!reader.string(tab.file_name) || !reader.pod(sheet_id) ||
+        !reader.string(tab.sheet_name) || !reader.string(tab.csv))
+      return std::nullopt;
+    tab.sheet_id = sheet_id;
+    sheets.tabs.push_back(std::move(tab));
+  }
+  // Snapshots written before the changes feed end after the tabs.
+  if (!reader.done() && !reader.string(sheets.page_token))
+    return std::nullopt;
+  if (!reader.done())
+    return std::nullopt;
+  return sheets;
+}
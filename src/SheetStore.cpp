@@ -0,0 +1,241 @@
+#include <DiffUtil.h>
+#include <RowHash.h>
+#include <SheetStore.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <climits>
+
+std::optional<double> parse_sheet_number(std::string_view text) {
+  while (!text.empty() && text.front() == ' ')
+    text.remove_prefix(1);
+  while (!text.empty() && text.back() == ' ')
+    text.remove_suffix(1);
+  if (text.empty())
+    return std::nullopt;
+
+  std::string buffer;
+  if (const auto comma = text.find(','); comma != std::string_view::npos) {
+    if (text.find(',', comma + 1) != std::string_view::npos ||
+        text.find('.') != std::string_view::npos)
+      return std::nullopt;
+    buffer = text;
+    buffer[comma] = '.';
+    text = buffer;
+  }
+  if (text.front() == '+')
+    text.remove_prefix(1);
+
+  double value = 0.0;
+  const auto [end, ec] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  // from_chars also reads "nan" and "inf", which are text in a sheet and
+  // would break numeric ordering.
+  if (ec != std::errc{} || end != text.data() + text.size() ||
+      !std::isfinite(value))
+    return std::nullopt;
+  return value;
+}
+
+int SheetTab::column_index(std::string_view column) const {
+  const auto it = std::ranges::find(header, column);
+  return it == header.end() ? -1 : static_cast<int>(it - header.begin());
+}
+
+SheetTab SheetStore::parse(std::string file_name, int sheet_id,
+                           std::string sheet_name, std::string csv) {
+  SheetTab tab;
+  tab.file_name = std::move(file_name);
+  tab.sheet_id = sheet_id;
+  tab.name = std::move(sheet_name);
+
+  tab.table = std::make_shared<const CsvTable>(csv);
+  for (std::size_t i = 0; i < tab.table->row_count(); ++i) {
+    const auto record = tab.table->row(i);
+    if (i == 0) {
+      tab.header.assign(record.begin(), record.end());
+      continue;
+    }
+    auto &row = tab.rows.emplace_back(record.begin(), record.end());
+    row.resize(std::max(row.size(), tab.header.size()));
+  }
+
+  tab.header_hash = hash_row(tab.header);
+  tab.row_hashes.reserve(tab.rows.size());
+  for (const auto &row : tab.rows) {
+    tab.row_hashes.push_back(hash_row(row));
+  }
+
+  tab.column_types.assign(tab.header.size(), SheetTab::ColumnType::Text);
+  for (std::size_t col = 0; col < tab.header.size(); ++col) {
+    bool any_number = false;
+    bool all_numbers = true;
+    for (const auto &row : tab.rows) {
+      if (row[col].empty())
+        continue;
+      if (parse_sheet_number(row[col])) {
+        any_number = true;
+      } else {
+        all_numbers = false;
+        break;
+      }
+    }
+    if (any_number && all_numbers)
+      tab.column_types[col] = SheetTab::ColumnType::Number;
+  }
+
+  tab.transposed_csv = std::make_shared<const std::string>(transpose_csv(csv));
+  tab.csv = std::make_shared<const std::string>(std::move(csv));
+  return tab;
+}
+
+RowChanges changed_rows(const SheetTab &old_tab, const SheetTab &new_tab) {
+  RowChanges changes;
+  changes.header_changed = old_tab.header_hash != new_tab.header_hash;
+
+  // Old row indices per hash, consumed as new rows claim them.
+  std::unordered_map<std::uint64_t, std::vector<std::size_t>> unmatched;
+  unmatched.reserve(old_tab.row_hashes.size());
+  for (std::size_t i = old_tab.row_hashes.size(); i-- > 0;) {
+    unmatched[old_tab.row_hashes[i]].push_back(i);
+  }
+
+  std::vector<bool> matched(old_tab.row_hashes.size(), false);
+  for (std::size_t i = 0; i < new_tab.row_hashes.size(); ++i) {
+    const auto it = unmatched.find(new_tab.row_hashes[i]);
+    if (it == unmatched.end() || it->second.empty()) {
+      changes.added.push_back(i);
+      continue;
+    }
+    matched[it->second.back()] = true;
+    it->second.pop_back();
+  }
+  for (std::size_t i = 0; i < matched.size(); ++i) {
+    if (!matched[i])
+      changes.removed.push_back(i);
+  }
+  return changes;
+}
+
+std::string rows_csv(const SheetTab &tab, const std::vector<std::size_t> &rows) {
+  std::string out = csv_join(tab.header);
+  out += '\n';
+  for (const auto index : rows) {
+    out += csv_join(tab.rows[index]);
+    out += '\n';
+  }
+  return out;
+}
+
+SheetStore::SheetStore() : current(std::make_shared<const Snapshot>()) {}
+
+std::vector<std::shared_ptr<const SheetTab>>
+SheetStore::update(std::vector<TabUpdate> updates) {
+  if (updates.empty())
+    return {};
+  return publish(std::move(updates), nullptr, nullptr, nullptr);
+}
+
+SheetStore::FileUpdate
+SheetStore::update_file(const std::string &file_name,
+                        const std::vector<int> &sheet_ids,
+                        std::vector<TabUpdate> updates) {
+  FileUpdate result;
+  result.stored =
+      publish(std::move(updates), &file_name, &sheet_ids, &result.removed);
+  return result;
+}
+
+std::vector<std::shared_ptr<const SheetTab>>
+SheetStore::publish(std::vector<TabUpdate> updates,
+                    const std::string *file_name,
+                    const std::vector<int> *sheet_ids,
+                    std::vector<std::shared_ptr<const SheetTab>> *removed) {
+  // Parsing happens before the writer lock and never blocks readers.
+  std::vector<std::shared_ptr<const SheetTab>> parsed;
+  parsed.reserve(updates.size());
+  for (auto &u : updates) {
+    parsed.push_back(std::make_shared<const SheetTab>(
+        parse(std::move(u.file_name), u.sheet_id, std::move(u.sheet_name),
+              std::move(u.csv))));
+  }
+
+  std::lock_guard lock(write_mutex);
+  const auto previous = current.load();
+  auto tabs = previous->tabs;
+  if (file_name != nullptr) {
+    for (auto it = tabs.lower_bound({*file_name, INT_MIN});
+         it != tabs.end() && it->first.first == *file_name;) {
+      if (std::ranges::find(*sheet_ids, it->first.second) != sheet_ids->end()) {
+        ++it;
+        continue;
+      }
+      removed->push_back(it->second);
+      it = tabs.erase(it);
+    }
+  }
+  if (parsed.empty() && (removed == nullptr || removed->empty()))
+    return parsed;
+
+  auto next = std::make_shared<Snapshot>();
+  next->tabs = std::move(tabs);
+  next->version = previous->version + 1;
+  for (const auto &tab : parsed) {
+    next->tabs[{tab->file_name, tab->sheet_id}] = tab;
+  }
+  // Renames can move a name between files, so the name index is rebuilt; it
+  // is a few dozen entries.
+  for (const auto &[key, tab] : next->tabs) {
+    if (!tab->csv->empty()) {
+      next->by_name.try_emplace(tab->name, tab);
+    }
+  }
+  current.store(std::move(next));
+  return parsed;
+}
+
+std::shared_ptr<const SheetTab> SheetStore::update(const std::string &file_name,
+                                                   int sheet_id,
+                                                   const std::string &sheet_name,
+                                                   std::string csv) {
+  std::vector<TabUpdate> updates;
+  updates.push_back(TabUpdate{file_name, sheet_id, sheet_name, std::move(csv)});
+  return update(std::move(updates)).front();
+}
+
+std::shared_ptr<const SheetStore::Snapshot> SheetStore::snapshot() const {
+  return current.load();
+}
+
+std::shared_ptr<const SheetTab>
+SheetStore::Snapshot::find(std::string_view sheet_name) const {
+  const auto it = by_name.find(std::string(sheet_name));
+  return it == by_name.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<const SheetTab>
+SheetStore::Snapshot::find(const std::string &file_name, int sheet_id) const {
+  const auto it = tabs.find({file_name, sheet_id});
+  return it == tabs.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<const SheetTab>
+SheetStore::find(std::string_view sheet_name) const {
+  return snapshot()->find(sheet_name);
+}
+
+std::shared_ptr<const SheetTab> SheetStore::find(const std::string &file_name,
+                                                 int sheet_id) const {
+  return snapshot()->find(file_name, sheet_id);
+}
+
+std::shared_ptr<const std::string> SheetStore::csv(std::string_view sheet_name,
+                                                   bool transpose) const {
+  const auto tab = find(sheet_name);
+  if (!tab)
+    return nullptr;
+  return transpose ? tab->transposed_csv : tab->csv;
+}
+
+std::size_t SheetStore::size() const { return snapshot()->tabs.size(); }
@@ -0,0 +1,124 @@
+#include <SnowflakeAliases.h>
+
+#include <format>
+#include <regex>
+
+#include <ollama.hpp>
+
+namespace {
+
+// Replaces every match of re with replace(match), copying the rest.
+template <typename Replace>
+std::string replace_matches(const std::string &text, const std::regex &re,
+                            Replace replace) {
+  std::string out;
+  out.reserve(text.size());
+  auto last = text.cbegin();
+  for (std::sregex_iterator it(text.cbegin(), text.cend(), re), end; it != end;
+       ++it) {
+    const auto &m = *it;
+    out.append(last, m[0].first);
+    out += replace(m);
+    last = m[0].second;
+  }
+  out.append(last, text.cend());
+  return out;
+}
+
+// Argument fields that hold a Discord id. Everything else (URLs, search
+// text, expressions) may legitimately contain "u123" and is left alone.
+bool is_id_field(const std::string &key) {
+  return key == "user_id" || key == "author_id" || key == "message_id";
+}
+
+void restore_id_fields(ollama::json &value, const SnowflakeAliases &aliases) {
+  if (value.is_object()) {
+    for (auto it = value.begin(); it != value.end(); ++it) {
+      if (is_id_field(it.key()) && it->is_string()) {
+        if (const auto id = aliases.resolve(it->get<std::string>()))
+          *it = *id;
+      } else {
+        restore_id_fields(*it, aliases);
+      }
+    }
+  } else if (value.is_array()) {
+    for (auto &child : value) {
+      restore_id_fields(child, aliases);
+    }
+  }
+}
+
+} // namespace
+
+std::string SnowflakeAliases::alias(Kind kind, const std::string &snowflake) {
+  if (snowflake.empty() || snowflake == "0")
+    return snowflake;
+
+  const char prefix = kind == Kind::Message ? 'm' : 'u';
+  const std::string key = prefix + snowflake;
+
+  auto it = to_alias.find(key);
+  if (it == to_alias.end()) {
+    int &next = kind == Kind::Message ? next_message : next_user;
+    std::string handle = std::format("{}{}", prefix, next++);
+    to_snowflake.emplace(handle, snowflake);
+    it = to_alias.emplace(key, std::move(handle)).first;
+  }
+
+  if (snowflake.size() > it->second.size())
+    bytes_saved += snowflake.size() - it->second.size();
+  return it->second;
+}
+
+std::string SnowflakeAliases::alias_mentions(const std::string &text) {
+  static const std::regex mention_re(R"(<@!?(\d+)>)", std::regex::optimize);
+  return replace_matches(text, mention_re, [this](const std::smatch &m) {
+    return "<@" + alias(Kind::User, m[1].str()) + ">";
+  });
+}
+
+std::string SnowflakeAliases::alias_tool_output(const std::string &text) {
+  static const std::regex snowflake_re(R"(\b\d{17,20}\b)", std::regex::optimize);
+  return replace_matches(
+      alias_mentions(text), snowflake_re, [this](const std::smatch &m) {
+        const std::string id = m[0].str();
+        return alias(contains(Kind::User, id) ? Kind::User : Kind::Message, id);
+      });
+}
+
+bool SnowflakeAliases::contains(Kind kind, const std::string &snowflake) const {
+  const char prefix = kind == Kind::Message ? 'm' : 'u';
+  return to_alias.contains(prefix + snowflake);
+}
+
+std::optional<std::string>
+SnowflakeAliases::resolve(std::string_view handle) const {
+  const auto it = to_snowflake.find(std::string(handle));
+  if (it == to_snowflake.end())
+    return std::nullopt;
+  return it->second;
+}
+
+std::string SnowflakeAliases::restore_text(const std::string &text) const {
+  if (to_snowflake.empty())
+    return text;
+
+  static const std::regex user_re(R"(<@!?(u\d+)>)", std::regex::optimize);
+  return replace_matches(text, user_re, [this](const std::smatch &m) {
+    if (const auto id = resolve(m[1].str()))
+      return "<@" + *id + ">";
+    return m[0].str();
+  });
+}
+
+std::string
+SnowflakeAliases::restore_arguments(const std::string &arguments_json) const {
+  if (to_snowflake.empty())
+    return arguments_json;
+
+  auto args = ollama::json::parse(arguments_json, nullptr, false);
+  if (args.is_discarded())
+    return arguments_json;
+  restore_id_fields(args, *this);
+  return args.dump();
+}
@@ -0,0 +1,40 @@
+#include <ToolRegistry.h>
+
+#include <format>
+#include <stdexcept>
+
+void ToolRegistry::add(const LlmService::ToolDefinition &definition,
+                       Handler handler) {
+  if (index_by_name.contains(definition.name)) {
+    throw std::invalid_argument(
+        std::format("Tool '{}' registered twice", definition.name));
+  }
+
+  ollama::json parameters =
+      ollama::json{{"type", "object"}, {"properties", ollama::json::object()}};
+  if (!definition.parameters_schema_json.empty()) {
+    // Schemas are compile-time literals; a broken one is a programming error.
+    parameters = ollama::json::parse(definition.parameters_schema_json);
+  }
+
+  tools.push_back(ollama_tools::make_function_tool(
+      definition.name, definition.description, parameters));
+  tools_bytes += tools.back().dump().size();
+
+  index_by_name.emplace(definition.name, handlers.size());
+  handlers.push_back(std::move(handler));
+}
+
+bool ToolRegistry::contains(const std::string &tool_name) const {
+  return index_by_name.contains(tool_name);
+}
+
+dpp::task<std::string>
+ToolRegistry::dispatch(ToolRequestContext &context, const std::string &tool_name,
+                       const std::string &arguments_json) const {
+  auto it = index_by_name.find(tool_name);
+  if (it == index_by_name.end()) {
+    co_return std::format("Tool error: unknown tool '{}'", tool_name);
+  }
+  co_return co_await handlers[it->second](context, arguments_json);
+}
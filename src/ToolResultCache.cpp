@@ -0,0 +1,124 @@
+#include <ToolResultCache.h>
+
+#include <algorithm>
+
+ToolResultCache::ToolResultCache(std::size_t max_entries, std::size_t max_bytes)
+    : max_entries(max_entries), max_bytes(max_bytes) {}
+
+std::string ToolResultCache::make_key(const std::string &tool_name,
+                                      const std::string &canonical_arguments,
+                                      const std::string &scope) {
+  std::string key;
+  key.reserve(tool_name.size() + canonical_arguments.size() + scope.size() + 2);
+  key += tool_name;
+  key += '\n';
+  key += scope;
+  key += '\n';
+  key += canonical_arguments;
+  return key;
+}
+
+std::optional<std::string> ToolResultCache::get(const std::string &key) {
+  const auto now = clock::now();
+  std::lock_guard<std::mutex> lock(mutex);
+
+  auto it = entries.find(key);
+  if (it == entries.end()) {
+    ++misses;
+    return std::nullopt;
+  }
+
+  if (now >= it->second.expires_at) {
+    erase_locked(it);
+    ++misses;
+    return std::nullopt;
+  }
+
+  ++hits;
+  return it->second.value;
+}
+
+std::uint64_t ToolResultCache::generation(const std::string &group) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  const auto it = generations.find(group);
+  return it == generations.end() ? 0 : it->second;
+}
+
+void ToolResultCache::put(const std::string &key, const std::string &group,
+                          std::string value, std::chrono::seconds ttl,
+                          std::optional<std::uint64_t> generation) {
+  if (value.size() > max_bytes) {
+    return;
+  }
+
+  const auto now = clock::now();
+  std::lock_guard<std::mutex> lock(mutex);
+
+  if (generation.has_value()) {
+    const auto it = generations.find(group);
+    if (*generation != (it == generations.end() ? 0 : it->second)) {
+      return;
+    }
+  }
+
+  if (auto it = entries.find(key); it != entries.end()) {
+    erase_locked(it);
+  }
+
+  total_bytes += value.size();
+  entries.emplace(key, Entry{std::move(value), group, now + ttl, next_sequence++});
+  evict_locked(now);
+}
+
+std::size_t ToolResultCache::invalidate_group(const std::string &group) {
+  std::lock_guard<std::mutex> lock(mutex);
+  ++generations[group];
+  std::size_t removed = 0;
+  for (auto it = entries.begin(); it != entries.end();) {
+    if (it->second.group == group) {
+      total_bytes -= it->second.value.size();
+      it = entries.erase(it);
+      ++removed;
+    } else {
+      ++it;
+    }
+  }
+  return removed;
+}
+
+ToolResultCache::Stats ToolResultCache::stats() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return Stats{hits, misses, entries.size(), total_bytes};
+}
+
+void ToolResultCache::erase_locked(
+    std::unordered_map<std::string, Entry>::iterator it) {
+  total_bytes -= it->second.value.size();
+  entries.erase(it);
+}
+
+void ToolResultCache::evict_locked(clock::time_point now) {
+  if (entries.size() <= max_entries && total_bytes <= max_bytes) {
+    return;
+  }
+
+  std::erase_if(entries, [&](const auto &item) {
+    if (now < item.second.expires_at) {
+      return false;
+    }
+    total_bytes -= item.second.value.size();
+    return true;
+  });
+
+  // Still over budget: drop the oldest insertions first.
+  while (entries.size() > max_entries || total_bytes > max_bytes) {
+    auto oldest = std::min_element(
+        entries.begin(), entries.end(), [](const auto &a, const auto &b) {
+          return a.second.sequence < b.second.sequence;
+        });
+    if (oldest == entries.end()) {
+      break;
+    }
+    erase_locked(oldest);
+  }
+}
@@ -0,0 +1,255 @@
+#include <VectorIndex.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <queue>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr char file_magic[4] = {'N', 'V', 'X', '1'};
+
+template <typename T> void write_pod(std::ofstream &out, const T &value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T> bool read_pod(std::ifstream &in, T &value) {
+  return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+bool normalize_into(std::span<const float> in, float *out) {
+  const float norm_sq = VectorIndex::dot(in.data(), in.data(), in.size());
+  if (!(norm_sq > 0.0F) || !std::isfinite(norm_sq))
+    return false;
+  const float inv = 1.0F / std::sqrt(norm_sq);
+  for (std::size_t i = 0; i < in.size(); ++i)
+    out[i] = in[i] * inv;
+  return true;
+}
+
+} // namespace
+
+VectorIndex::VectorIndex(std::size_t max_entries)
+    : max_entries(std::max<std::size_t>(max_entries, 1)) {}
+
+float VectorIndex::dot(const float *a, const float *b, std::size_t n) {
+  std::size_t i = 0;
+  float sum = 0.0F;
+#if defined(__SSE2__)
+  __m128 acc0 = _mm_setzero_ps();
+  __m128 acc1 = _mm_setzero_ps();
+  for (; i + 8 <= n; i += 8) {
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    acc1 = _mm_add_ps(acc1,
+                      _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+  }
+  alignas(16) float lanes[4];
+  _mm_store_ps(lanes, _mm_add_ps(acc0, acc1));
+  sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+  for (; i < n; ++i)
+    sum += a[i] * b[i];
+  return sum;
+}
+
+bool VectorIndex::add(std::uint64_t id, std::uint64_t server_id,
+                      std::uint64_t channel_id,
+                      std::span<const float> embedding) {
+  if (embedding.empty())
+    return false;
+
+  std::vector<float> normalized(embedding.size());
+  if (!normalize_into(embedding, normalized.data()))
+    return false;
+
+  std::unique_lock lock(mutex);
+  if (dims == 0)
+    dims = embedding.size();
+  if (embedding.size() != dims)
+    return false;
+
+  std::size_t slot;
+  if (const auto it = slot_by_id.find(id); it != slot_by_id.end()) {
+    slot = it->second;
+  } else if (meta.size() < max_entries) {
+    slot = meta.size();
+    if (meta.size() == meta.capacity()) {
+      // Grow geometrically, but never past the configured capacity.
+      const std::size_t target =
+          std::min(max_entries, std::max<std::size_t>(1024, meta.size() * 2));
+      meta.reserve(target);
+      vectors.reserve(target * dims);
+    }
+    meta.push_back({});
+    vectors.resize(vectors.size() + dims);
+  } else {
+    slot = next_slot;
+    next_slot = (next_slot + 1) % max_entries;
+    slot_by_id.erase(meta[slot].id);
+  }
+
+  std::copy(normalized.begin(), normalized.end(), vectors.begin() + slot * dims);
+  meta[slot] = Meta{id, server_id, channel_id};
+  slot_by_id[id] = slot;
+  return true;
+}
+
+std::vector<VectorIndex::Hit>
+VectorIndex::search(std::span<const float> query,
+                    const SearchOptions &options) const {
+  std::shared_lock lock(mutex);
+  if (options.limit == 0 || query.size() != dims || meta.empty())
+    return {};
+
+  std::vector<float> normalized(dims);
+  if (!normalize_into(query, normalized.data()))
+    return {};
+
+  std::vector<std::uint64_t> excluded = options.exclude_ids;
+  std::sort(excluded.begin(), excluded.end());
+
+  // Min-heap of the best `limit` hits seen so far.
+  const auto worse = [](const Hit &a, const Hit &b) { return a.score > b.score; };
+  std::priority_queue<Hit, std::vector<Hit>, decltype(worse)> best(worse);
+
+  for (std::size_t slot = 0; slot < meta.size(); ++slot) {
+    const Meta &m = meta[slot];
+    if (options.server_id != 0 && m.server_id != options.server_id)
+      continue;
+    if (std::binary_search(excluded.begin(), excluded.end(), m.id))
+      continue;
+
+    const float score = dot(normalized.data(), vectors.data() + slot * dims, dims);
+    if (score < options.min_score)
+      continue;
+    if (best.size() < options.limit) {
+      best.push(Hit{m.id, m.server_id, m.channel_id, score});
+    } else if (score > best.top().score) {
+      best.pop();
+      best.push(Hit{m.id, m.server_id, m.channel_id, score});
+    }
+  }
+
+  std::vector<Hit> hits;
+  hits.reserve(best.size());
+  while (!best.empty()) {
+    hits.push_back(best.top());
+    best.pop();
+  }
+  std::reverse(hits.begin(), hits.end());
+  return hits;
+}
+
+bool VectorIndex::save(const std::string &path) const {
+  std::shared_lock lock(mutex);
+  const std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!out)
+      return false;
+
+    out.write(file_magic, sizeof(file_magic));
+    write_pod(out, static_cast<std::uint64_t>(dims));
+    write_pod(out, static_cast<std::uint64_t>(meta.size()));
+    write_pod(out, static_cast<std::uint64_t>(next_slot));
+    for (const auto &m : meta) {
+      write_pod(out, m.id);
+      write_pod(out, m.server_id);
+      write_pod(out, m.channel_id);
+    }
+    out.write(reinterpret_cast<const char *>(vectors.data()),
+              static_cast<std::streamsize>(vectors.size() * sizeof(float)));
+    if (!out)
+      return false;
+  }
+  return std::rename(tmp_path.c_str(), path.c_str()) == 0;
+}
+
+bool VectorIndex::load(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    return false;
+
+  char magic[sizeof(file_magic)];
+  if (!in.read(magic, sizeof(magic)) ||
+      std::memcmp(magic, file_magic, sizeof(magic)) != 0)
+    return false;
+
+  std::uint64_t file_dims = 0;
+  std::uint64_t count = 0;
+  std::uint64_t file_next_slot = 0;
+  if (!read_pod(in, file_dims) || !read_pod(in, count) ||
+      !read_pod(in, file_next_slot))
+    return false;
+  if (file_dims == 0 && count != 0)
+    return false;
+  // Guard against a corrupt header asking for absurd allocations: the
+  // header must describe exactly the bytes that follow it.
+  if (count > (1ULL << 26) || file_dims > (1ULL << 16))
+    return false;
+  const auto body_start = in.tellg();
+  in.seekg(0, std::ios::end);
+  const auto file_end = in.tellg();
+  in.seekg(body_start);
+  if (body_start < 0 || file_end < body_start)
+    return false;
+  const std::uint64_t body_bytes =
+      count * (sizeof(Meta::id) + sizeof(Meta::server_id) +
+               sizeof(Meta::channel_id)) +
+      count * file_dims * sizeof(float);
+  if (body_bytes != static_cast<std::uint64_t>(file_end - body_start))
+    return false;
+
+  std::vector<Meta> file_meta(count);
+  for (auto &m : file_meta) {
+    if (!read_pod(in, m.id) || !read_pod(in, m.server_id) ||
+        !read_pod(in, m.channel_id))
+      return false;
+  }
+  std::vector<float> file_vectors(count * file_dims);
+  if (!in.read(reinterpret_cast<char *>(file_vectors.data()),
+               static_cast<std::streamsize>(file_vectors.size() * sizeof(float))))
+    return false;
+
+  // A snapshot from a larger index keeps its first max_entries slots.
+  if (count > max_entries) {
+    file_meta.resize(max_entries);
+    file_vectors.resize(max_entries * file_dims);
+    file_next_slot = 0;
+  }
+
+  std::unordered_map<std::uint64_t, std::size_t> file_slots;
+  for (std::size_t slot = 0; slot < file_meta.size(); ++slot)
+    file_slots[file_meta[slot].id] = slot;
+
+  std::unique_lock lock(mutex);
+  dims = static_cast<std::size_t>(file_dims);
+  meta = std::move(file_meta);
+  vectors = std::move(file_vectors);
+  slot_by_id = std::move(file_slots);
+  next_slot = meta.empty() ? 0 : static_cast<std::size_t>(file_next_slot % max_entries);
+  return true;
+}
+
+std::size_t VectorIndex::size() const {
+  std::shared_lock lock(mutex);
+  return slot_by_id.size();
+}
+
+std::size_t VectorIndex::dimensions() const {
+  std::shared_lock lock(mutex);
+  return dims;
+}
+
+std::size_t VectorIndex::memory_bytes() const {
+  std::shared_lock lock(mutex);
+  return vectors.capacity() * sizeof(float) + meta.capacity() * sizeof(Meta) +
+         slot_by_id.size() * (sizeof(std::uint64_t) + sizeof(std::size_t) + 16);
+}
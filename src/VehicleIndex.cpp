@@ -0,0 +1,253 @@
+#include <VehicleIndex.h>
+
+#include <algorithm>
+#include <cctype>
+#include <format>
+#include <mutex>
+
+namespace {
+
+// Match tiers; fuzzy hits only survive when nothing scores above them.
+constexpr float exact_score = 1.0F;
+constexpr float substring_score = 0.8F;
+constexpr float token_score = 0.6F;
+constexpr float min_trigram_containment = 0.6F;
+
+std::vector<std::string> name_tokens(std::string_view name) {
+  std::vector<std::string> tokens;
+  std::string current;
+  for (const unsigned char ch : name) {
+    if (std::isalnum(ch) != 0) {
+      current += static_cast<char>(std::tolower(ch));
+    } else if (!current.empty()) {
+      tokens.push_back(std::move(current));
+      current.clear();
+    }
+  }
+  if (!current.empty()) {
+    tokens.push_back(std::move(current));
+  }
+  return tokens;
+}
+
+// Trigrams of the compact name with ^ and $ marking the ends, so short
+// names still produce a few.
+std::vector<std::uint32_t> trigrams(const std::string &key) {
+  const std::string padded = "^" + key + "$";
+  std::vector<std::uint32_t> out;
+  for (std::size_t i = 0; i + 3 <= padded.size(); ++i) {
+    out.push_back(static_cast<std::uint32_t>(
+        static_cast<unsigned char>(padded[i]) << 16 |
+        static_cast<unsigned char>(padded[i + 1]) << 8 |
+        static_cast<unsigned char>(padded[i + 2])));
+  }
+  std::ranges::sort(out);
+  out.erase(std::unique(out.begin(), out.end()), out.end());
+  return out;
+}
+
+std::size_t edit_distance(std::string_view a, std::string_view b) {
+  std::vector<std::size_t> row(b.size() + 1);
+  for (std::size_t j = 0; j <= b.size(); ++j)
+    row[j] = j;
+  for (std::size_t i = 1; i <= a.size(); ++i) {
+    std::size_t diagonal = row[0];
+    row[0] = i;
+    for (std::size_t j = 1; j <= b.size(); ++j) {
+      const std::size_t above = row[j];
+      row[j] = std::min({row[j] + 1, row[j - 1] + 1,
+                         diagonal + (a[i - 1] == b[j - 1] ? 0 : 1)});
+      diagonal = above;
+    }
+  }
+  return row[b.size()];
+}
+
+// Every query token is a prefix of some name token, or one edit away from
+// one when it is long enough for a typo to be plausible.
+bool tokens_match(const std::vector<std::string> &query,
+                  const std::vector<std::string> &name) {
+  return std::ranges::all_of(query, [&name](const std::string &q) {
+    return std::ranges::any_of(name, [&q](const std::string &t) {
+      if (t.starts_with(q))
+        return true;
+      return q.size() >= 4 && edit_distance(q, t) <= 1;
+    });
+  });
+}
+
+} // namespace
+
+std::string VehicleIndex::compact_name(std::string_view name) {
+  std::string out;
+  for (const unsigned char ch : name) {
+    if (std::isalnum(ch) != 0)
+      out += static_cast<char>(std::tolower(ch));
+  }
+  return out;
+}
+
+void VehicleIndex::remove_entry(std::uint32_t id) {
+  const auto it = entries.find(id);
+  if (it == entries.end())
+    return;
+  for (const auto gram : it->second.trigrams) {
+    auto posting = postings.find(gram);
+    if (posting == postings.end())
+      continue;
+    std::erase(posting->second, id);
+    if (posting->second.empty())
+      postings.erase(posting);
+  }
+  entries.erase(it);
+}
+
+void VehicleIndex::update_tab(std::shared_ptr<const SheetTab> tab,
+                              std::size_t key_column) {
+  if (!tab)
+    return;
+
+  // Entries are built before taking the lock; only the swap is exclusive.
+  std::vector<Entry> fresh;
+  for (std::size_t row = 0; row < tab->rows.size(); ++row) {
+    if (key_column >= tab->rows[row].size())
+      continue;
+    const std::string_view name = tab->rows[row][key_column];
+    std::string key = compact_name(name);
+    if (key.empty())
+      continue;
+    auto grams = trigrams(key);
+    fresh.push_back(Entry{tab, row, key_column, std::move(key),
+                          name_tokens(name), std::move(grams)});
+  }
+
+  std::unique_lock lock(mutex);
+  auto &ids = by_tab[{tab->file_name, tab->sheet_id}];
+  for (const auto id : ids)
+    remove_entry(id);
+  ids.clear();
+
+  for (auto &entry : fresh) {
+    const std::uint32_t id = next_id++;
+    for (const auto gram : entry.trigrams)
+      postings[gram].push_back(id);
+    entries.emplace(id, std::move(entry));
+    ids.push_back(id);
+  }
+}
+
+void VehicleIndex::remove_tab(const std::string &file_name, int sheet_id) {
+  std::unique_lock lock(mutex);
+  const auto it = by_tab.find({file_name, sheet_id});
+  if (it == by_tab.end())
+    return;
+  for (const auto id : it->second)
+    remove_entry(id);
+  by_tab.erase(it);
+}
+
+std::vector<VehicleIndex::Match>
+VehicleIndex::lookup(std::string_view query, std::size_t limit) const {
+  const std::string query_key = compact_name(query);
+  if (query_key.size() < 2)
+    return {};
+  const auto query_tokens = name_tokens(query);
+  const auto query_grams = trigrams(query_key);
+
+  std::shared_lock lock(mutex);
+
+  // Candidates are the entries sharing at least one trigram with the query.
+  std::unordered_map<std::uint32_t, std::size_t> shared;
+  for (const auto gram : query_grams) {
+    const auto posting = postings.find(gram);
+    if (posting == postings.end())
+      continue;
+    for (const auto id : posting->second)
+      ++shared[id];
+  }
+
+  std::vector<Match> matches;
+  float best = 0.0F;
+  for (const auto &[id, count] : shared) {
+    const Entry &entry = entries.at(id);
+    // Among equal tiers, names closer in length to the query rank higher.
+    const float closeness = static_cast<float>(query_key.size()) /
+                            static_cast<float>(std::max(entry.key.size(),
+                                                        query_key.size()));
+    float score = 0.0F;
+    if (entry.key == query_key) {
+      score = exact_score;
+    } else if (entry.key.find(query_key) != std::string::npos) {
+      score = substring_score + 0.19F * closeness;
+    } else if (tokens_match(query_tokens, entry.tokens)) {
+      score = token_score + 0.19F * closeness;
+    } else {
+      const float containment =
+          static_cast<float>(count) / static_cast<float>(query_grams.size());
+      if (containment < min_trigram_containment)
+        continue;
+      score = 0.5F * containment;
+    }
+    best = std::max(best, score);
+    matches.push_back(Match{entry.tab, entry.row, entry.key_column, score});
+  }
+
+  // Keep the best tier only: a substring hit makes fuzzy hits noise.
+  const float floor = best >= substring_score   ? substring_score
+                      : best >= token_score     ? token_score
+                                                : best - 0.1F;
+  std::erase_if(matches, [floor](const Match &m) { return m.score < floor; });
+  std::ranges::sort(matches, [](const Match &a, const Match &b) {
+    if (a.score != b.score)
+      return a.score > b.score;
+    if (a.tab->name != b.tab->name)
+      return a.tab->name < b.tab->name;
+    return a.row < b.row;
+  });
+  if (matches.size() > limit)
+    matches.resize(limit);
+  return matches;
+}
+
+std::string VehicleIndex::format_lookup(std::string_view query,
+                                        std::size_t max_bytes) const {
+  auto matches = lookup(query);
+  if (matches.empty())
+    return std::format("No vehicle matching '{}' in any sheet.", query);
+
+  // Group by sheet, keeping each sheet's rows in score order.
+  std::ranges::stable_sort(matches, [](const Match &a, const Match &b) {
+    return a.tab->name < b.tab->name;
+  });
+
+  std::string body;
+  std::size_t shown = 0;
+  for (const auto &match : matches) {
+    const auto &row = match.tab->rows[match.row];
+    std::string line = std::format("[{}] {}:", match.tab->name,
+                                   row[match.key_column]);
+    bool first = true;
+    for (std::size_t col = 0; col < row.size() && col < match.tab->header.size();
+         ++col) {
+      if (col == match.key_column || row[col].empty())
+        continue;
+      line += std::format("{} {}={}", first ? "" : ";", match.tab->header[col],
+                          row[col]);
+      first = false;
+    }
+    line += '\n';
+    if (body.size() + line.size() + 100 > max_bytes)
+      break;
+    body += line;
+    ++shown;
+  }
+
+  return std::format("Vehicle lookup '{}': {} matching rows, showing {}\n",
+                     query, matches.size(), shown) +
+         body;
+}
+
+std::size_t VehicleIndex::size() const {
+  std::shared_lock lock(mutex);
+  return entries.size();
+}
@@ -208,7 +208,13 @@ VideoSummaryService::summarize_video(const std::string &url) const {
   bot.log(dpp::ll_info,
           std::format("Running video summary script: {}", script_path->string()));
 
-  CommandResult result = run_script(*script_path, url, timeout);
+  CommandResult result = co_await dpp::async<CommandResult>(
+      [&](std::function<void(CommandResult)> cb) {
+        bot.queue_work(10, [cb = std::move(cb), script = *script_path, url,
+                            timeout]() mutable {
+          cb(run_script(script, url, timeout));
+        });
+      });
   std::string output = trim_copy(result.output);
 
   bot.log(dpp::ll_info, std::format("Script result: {}", output));
@@ -0,0 +1,149 @@
+#include <CsvParser.h>
+
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(bool condition, const std::string &message) {
+  if (!condition) {
+    std::cerr << "FAIL: " << message << "\n";
+    ++failures;
+  }
+}
+
+void expect_false(bool condition, const std::string &message) {
+  expect_true(!condition, message);
+}
+
+std::vector<std::string> cells(const CsvTable &table, std::size_t index) {
+  std::vector<std::string> out;
+  for (const auto cell : table.row(index)) {
+    out.emplace_back(cell);
+  }
+  return out;
+}
+
+void test_plain_records() {
+  const CsvTable table("Model,Range\nA,500\nB,480\n");
+  expect_true(table.row_count() == 3, "three records");
+  expect_true(cells(table, 0) == std::vector<std::string>{"Model", "Range"},
+              "header cells");
+  expect_true(cells(table, 2) == std::vector<std::string>{"B", "480"},
+              "last record");
+  expect_true(table.max_columns() == 2, "widest record");
+}
+
+void test_quoted_cells() {
+  const CsvTable table("\"Kia EV6, GT\",\"say \"\"hi\"\"\",\"two\nlines\"\n"
+                       "\"\",x,\"a,b\"\"c\"\n");
+  expect_true(table.row_count() == 2, "line break inside quotes is kept");
+  expect_true(cells(table, 0) ==
+                  std::vector<std::string>{"Kia EV6, GT", "say \"hi\"",
+                                           "two\nlines"},
+              "quoted comma, escaped quotes and newline unescaped");
+  expect_true(cells(table, 1) == std::vector<std::string>{"", "x", "a,b\"c"},
+              "empty quoted cell and mixed escapes");
+}
+
+void test_line_endings_and_blank_lines() {
+  const CsvTable crlf("a,b\r\nc,d\r\n\r\ne,f\rg,h");
+  expect_true(crlf.row_count() == 4, "CRLF, CR and blank lines");
+  expect_true(cells(crlf, 1) == std::vector<std::string>{"c", "d"},
+              "CR is not part of the cell");
+  expect_true(cells(crlf, 3) == std::vector<std::string>{"g", "h"},
+              "last record without a line break");
+
+  const CsvTable quoted_empty("\"\"\n\nx\n");
+  expect_true(quoted_empty.row_count() == 2,
+              "a quoted empty cell is a record, a blank line is not");
+
+  const CsvTable empty("");
+  expect_true(empty.row_count() == 0, "empty input has no records");
+}
+
+void test_empty_cells() {
+  const CsvTable table("a,,\n,\nb,");
+  expect_true(cells(table, 0) == std::vector<std::string>{"a", "", ""},
+              "trailing empty cells kept");
+  expect_true(cells(table, 1) == std::vector<std::string>{"", ""},
+              "record of empty cells kept");
+  expect_true(cells(table, 2) == std::vector<std::string>{"b", ""},
+              "trailing comma at end of input");
+  expect_true(table.max_columns() == 3, "widest record counted");
+}
+
+void test_lenient_quotes() {
+  const CsvTable table("\"a\"b,c\n\"open\n");
+  expect_true(cells(table, 0) == std::vector<std::string>{"ab", "c"},
+              "text after a closing quote is kept");
+  expect_true(cells(table, 1) == std::vector<std::string>{"open\n"},
+              "unterminated quote runs to end of input");
+}
+
+void test_escape_round_trip() {
+  expect_true(csv_escape("plain") == "plain", "plain cell unquoted");
+  expect_true(csv_escape("a,b") == "\"a,b\"", "comma quoted");
+  expect_true(csv_escape("say \"hi\"") == "\"say \"\"hi\"\"\"",
+              "quotes doubled");
+  expect_false(csv_escape("x\ny") == "x\ny", "newline quoted");
+
+  const std::vector<std::string_view> row = {"Kia EV6, GT", "", "a\"b",
+                                             "two\r\nlines"};
+  const CsvTable table(csv_join(row) + "\n");
+  expect_true(table.row_count() == 1 &&
+                  cells(table, 0) ==
+                      std::vector<std::string>(row.begin(), row.end()),
+              "joined record parses back to the same cells");
+}
+
+void benchmark_large_export() {
+  std::string csv = "Model,Battery,90 km/h,120 km/h,Tested,Notes\n";
+  for (int i = 0; csv.size() < 8 * 1024 * 1024; ++i) {
+    csv += std::format("\"Brand{} Model {}, AWD\",{},{},,2023-{:02},"
+                       "Tested in {} conditions with \"\"{}\"\" tyres\n",
+                       i % 30, i, 60 + i % 40, 350 + i % 150, 1 + i % 12,
+                       i % 2 == 0 ? "dry" : "wet", i % 3 == 0 ? "winter" : "summer");
+  }
+
+  constexpr int iterations = 5;
+  std::size_t rows = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    const CsvTable table(csv);
+    rows = table.row_count();
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  const double seconds =
+      std::chrono::duration<double>(elapsed).count() / iterations;
+  std::cout << std::format("CsvParser benchmark: {}B {} rows {:.2f}ms "
+                           "{:.0f}MB/s\n",
+                           csv.size(), rows, seconds * 1000,
+                           csv.size() / seconds / (1024 * 1024));
+  expect_true(rows > 10000, "benchmark input parsed");
+}
+
+} // namespace
+
+int main() {
+  test_plain_records();
+  test_quoted_cells();
+  test_line_endings_and_blank_lines();
+  test_empty_cells();
+  test_lenient_quotes();
+  test_escape_round_trip();
+  benchmark_large_export();
+
+  if (failures != 0) {
+    std::cerr << failures << " test failure(s)\n";
+    return 1;
+  }
+
+  std::cout << "All CsvParser tests passed\n";
+  return 0;
+}
@@ -0,0 +1,113 @@
+#include <DiffPrompt.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(bool condition, const std::string &message) {
+  if (!condition) {
+    std::cerr << "FAIL: " << message << "\n";
+    ++failures;
+  }
+}
+
+void expect_false(bool condition, const std::string &message) {
+  expect_true(!condition, message);
+}
+
+SheetDiff make_diff(const std::string &name, std::size_t diff_bytes) {
+  return SheetDiff{name, "Model,Range", std::string(diff_bytes, 'x')};
+}
+
+void test_single_sheet_prompt() {
+  const auto prompts = build_diff_prompts(
+      "TB test results", {SheetDiff{"Range", "Model,Range", "-A,1\n+A,2\n"}},
+      4000);
+  expect_true(prompts.size() == 1 &&
+                  prompts[0] == "Filename: TB test results\nSheet name: Range\n"
+                                "CSV Header: Model,Range\nDiff:\n-A,1\n+A,2\n",
+              "one tab keeps the single-sheet prompt");
+}
+
+void test_batches_within_budget() {
+  const std::vector<SheetDiff> diffs = {
+      make_diff("Range", 300), make_diff("Weight", 300),
+      make_diff("Noise", 300), make_diff("Banana", 1500),
+      make_diff("1000 km", 100)};
+
+  const auto all = build_diff_prompts("f", diffs, 10000);
+  expect_true(all.size() == 1, "five tabs fit in one prompt");
+  expect_true(all[0].find("5 sheets changed") != std::string::npos,
+              "batched prompt asks for one summary");
+  expect_true(all[0].find("Sheet name: Range") < all[0].find("Sheet name: Banana"),
+              "tabs keep their order");
+
+  const auto split = build_diff_prompts("f", diffs, 1200);
+  expect_true(split.size() == 3, "tabs split into prompts under the budget");
+  for (const auto &prompt : split) {
+    expect_true(prompt.size() <= 1200, "every prompt within the budget");
+  }
+  expect_true(split[1].find("[diff truncated]") != std::string::npos,
+              "oversized tab is cut short on its own");
+  expect_true(split[2].find("Sheet name: 1000 km") != std::string::npos,
+              "later tabs still summarized");
+}
+
+void test_truncation_keeps_utf8() {
+  std::string text;
+  for (int i = 0; i < 400; ++i) {
+    text += "\xC3\xB8";
+  }
+  const auto prompts =
+      build_diff_prompts("f", {SheetDiff{"Range", "Model", text}}, 301);
+  expect_true(prompts.size() == 1 && prompts[0].size() <= 301,
+              "truncated prompt within budget");
+  const auto note = prompts[0].find("\n[diff truncated]");
+  expect_true(note != std::string::npos &&
+                  static_cast<unsigned char>(prompts[0][note - 1]) == 0xB8,
+              "cut lands on a character boundary");
+}
+
+void test_split_message() {
+  expect_true(split_message("short") == std::vector<std::string>{"short"},
+              "short message unchanged");
+  expect_true(split_message("").empty(), "empty message sends nothing");
+
+  const std::string first(1500, 'a');
+  const std::string second(1000, 'b');
+  const auto parts = split_message(first + "\n" + second);
+  expect_true(parts.size() == 2 && parts[0] == first && parts[1] == second,
+              "split at the line break");
+
+  std::string long_line;
+  for (int i = 0; i < 1500; ++i) {
+    long_line += "\xC3\xA6";
+  }
+  const auto utf8_parts = split_message(long_line);
+  expect_true(utf8_parts.size() == 2 && utf8_parts[0].size() == 2000 &&
+                  utf8_parts[0] + utf8_parts[1] == long_line,
+              "unbroken text cut on a character boundary");
+  expect_false(split_message(long_line, 1999)[0].size() == 1999,
+               "odd limit backs off to a boundary");
+}
+
+} // namespace
+
+int main() {
+  test_single_sheet_prompt();
+  test_batches_within_budget();
+  test_truncation_keeps_utf8();
+  test_split_message();
+
+  if (failures != 0) {
+    std::cerr << failures << " test failure(s)\n";
+    return 1;
+  }
+
+  std::cout << "All DiffPrompt tests passed\n";
+  return 0;
+}
@@ -1,7 +1,13 @@
 #include <DiffUtil.h>
 
+#include <chrono>
+#include <format>
 #include <iostream>
+#include <random>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace {
 
@@ -18,7 +24,7 @@ void test_diff_without_transpose() {
   const std::string old_csv = "A,B\nx,1\ny,2\n";
   const std::string new_csv = "A,B\nx,1\ny,3\n";
 
-  const std::string diff = diff_csv(old_csv, new_csv, 9101);
+  const std::string diff = diff_csv(old_csv, new_csv);
 
   expect_true(diff.find("-y,2") != std::string::npos,
               "regular diff includes removed row");
@@ -30,7 +36,7 @@ void test_diff_with_transpose() {
   const std::string old_csv = "SoC,Car1,Car2\n10,100,90\n20,80,70\n";
   const std::string new_csv = "SoC,Car1,Car2\n10,100,95\n20,80,70\n";
 
-  const std::string diff = diff_csv(old_csv, new_csv, 9102, true);
+  const std::string diff = diff_csv(old_csv, new_csv, true);
 
   expect_true(diff.find("-Car2,90,70") != std::string::npos,
               "transposed diff includes removed car row");
@@ -38,11 +44,232 @@ void test_diff_with_transpose() {
               "transposed diff includes added car row");
 }
 
+void test_diff_with_quoted_cells() {
+  const std::string old_csv =
+      "SoC,\"Kia EV6, GT\",Car2\n10,100,90\n20,80,\"70\n(est)\"\n";
+  const std::string new_csv =
+      "SoC,\"Kia EV6, GT\",Car2\n10,101,90\n20,80,\"70\n(est)\"\n";
+
+  const std::string diff = diff_csv(old_csv, new_csv, true);
+  expect_true(diff.find("+\"Kia EV6, GT\",101,80\n") != std::string::npos,
+              "transpose keeps a quoted comma in one cell");
+  expect_true(diff.find(" Car2,90,\"70\\n(est)\"\n") != std::string::npos,
+              "multi-line cell stays on its row as context");
+  expect_true(diff.find("-Car2") == std::string::npos,
+              "multi-line cell does not change the unchanged row");
+
+  const auto keyed = keyed_diff_csv(old_csv, new_csv, {}, true);
+  expect_true(keyed &&
+                  keyed->find("Kia EV6, GT / 10 / 100 → 101\n") !=
+                      std::string::npos,
+              "keyed diff keys on the quoted name");
+}
+
+void test_diff_output_format() {
+  const std::string old_csv = "A,B\nx,1\ny,2\n";
+  const std::string new_csv = "A,B\nx,1\ny,3\n";
+
+  expect_true(diff_csv(old_csv, new_csv) ==
+                  "--- old\n+++ new\n@@ -1,3 +1,3 @@\n A,B\n x,1\n-y,2\n+y,3\n",
+              "diff matches diff -u hunk format");
+  expect_true(diff_csv(old_csv, old_csv).empty(), "equal sheets give no diff");
+  expect_true(diff_csv("A,B\ny,2\nx,1\n", old_csv).empty(),
+              "row order alone is not a change");
+}
+
+void test_hunk_ranges() {
+  std::vector<std::string_view> old_lines;
+  std::vector<std::string_view> new_lines;
+  const std::vector<std::string> numbers = {"1", "2", "3", "4", "5", "6",
+                                            "7", "8", "9", "10", "11", "12",
+                                            "13", "14", "15", "16", "17", "18"};
+  for (const auto &n : numbers) {
+    old_lines.push_back(n);
+    if (n != "2" && n != "16") {
+      new_lines.push_back(n);
+    }
+  }
+  new_lines.push_back("19");
+
+  const std::string diff = unified_diff(old_lines, new_lines);
+  expect_true(diff.find("@@ -1,5 +1,4 @@\n 1\n-2\n 3\n 4\n 5\n") !=
+                  std::string::npos,
+              "first hunk has context after the change");
+  expect_true(diff.find("@@ -13,6 +12,6 @@\n 13\n 14\n 15\n-16\n 17\n 18\n+19\n") !=
+                  std::string::npos,
+              "nearby changes share one hunk");
+
+  const std::vector<std::string_view> empty;
+  expect_true(unified_diff(empty, {"a"}) == "--- old\n+++ new\n@@ -0,0 +1 @@\n+a\n",
+              "empty range names the preceding line");
+}
+
+void test_keyed_diff_reports_cells() {
+  const std::string old_csv = "Model,Price,Range\n"
+                              "Tesla Model 3,400000,500\n"
+                              "Kia EV6,450000,480\n"
+                              "Nissan Leaf,250000,270\n";
+  const std::string new_csv = "Model,Price,Range\n"
+                              "Kia EV6,450000,485\n"
+                              "Tesla Model 3,390000,500\n"
+                              "\"Polestar 2, LR\",500000,\n";
+
+  const auto diff = keyed_diff_csv(old_csv, new_csv);
+  expect_true(diff.has_value(), "unique keys give a keyed diff");
+  expect_true(*diff == "Rows keyed by column: Model\n"
+                       "Changed cells (row key / column / old → new):\n"
+                       "Kia EV6 / Range / 480 → 485\n"
+                       "Tesla Model 3 / Price / 400000 → 390000\n"
+                       "Added rows:\n"
+                       "Polestar 2, LR: Price=500000\n"
+                       "Removed rows:\n"
+                       "Nissan Leaf: Price=250000, Range=270\n",
+              "keyed diff lists only changed cells and whole added/removed rows");
+  expect_true(keyed_diff_csv(old_csv, old_csv) == std::string(),
+              "equal sheets give an empty keyed diff");
+}
+
+void test_keyed_diff_columns_and_keys() {
+  const std::string old_csv = "Id,Model,Price\n1,A,10\n2,B,20\n";
+  const std::string new_csv = "Model,Id,Weight,Price\nA,1,1800,10\nB,2,,21\n";
+
+  const auto diff = keyed_diff_csv(old_csv, new_csv, "Model");
+  expect_true(diff && diff->find("Rows keyed by column: Model\n") == 0,
+              "key column is chosen by name");
+  expect_true(diff && diff->find("Added columns: Weight\n") != std::string::npos,
+              "new column is reported once");
+  expect_true(diff && diff->find("A / Weight / (empty) → 1800\n") != std::string::npos,
+              "values in a new column are cell changes");
+  expect_true(diff && diff->find("B / Price / 20 → 21\n") != std::string::npos,
+              "moved columns are matched by name");
+  expect_true(diff && diff->find("/ Id /") == std::string::npos,
+              "unchanged moved column is not reported");
+
+  const std::string duplicate = "Model,Price\nA,1\nA,2\n";
+  expect_true(!keyed_diff_csv(duplicate, new_csv).has_value(),
+              "duplicate keys fall back");
+}
+
+void test_keyed_diff_with_transpose() {
+  const std::string old_csv = "SoC,Car1,Car2\n10,100,90\n20,80,70\n";
+  const std::string new_csv = "SoC,Car1,Car2\n10,100,95\n20,80,70\n";
+
+  const auto diff = keyed_diff_csv(old_csv, new_csv, {}, true);
+  expect_true(diff && diff->find("Car2 / 10 / 90 → 95\n") != std::string::npos,
+              "transposed keyed diff names car and SoC");
+}
+
+// Applies a unified diff to old_lines; returns false if it does not fit.
+bool apply_diff(const std::vector<std::string_view> &old_lines,
+                const std::string &diff, std::vector<std::string> &out) {
+  std::istringstream in(diff);
+  std::string line;
+  std::size_t old_pos = 0;
+  while (std::getline(in, line)) {
+    if (line.starts_with("---") || line.starts_with("+++")) {
+      continue;
+    }
+    if (line.starts_with("@@")) {
+      std::size_t start = std::stoul(line.substr(4));
+      const auto comma = line.find(',');
+      const auto space = line.find(' ', 4);
+      const bool empty = comma < space && line.substr(comma + 1, 2) == "0 ";
+      const std::size_t target = empty ? start : start - 1;
+      while (old_pos < target) {
+        out.emplace_back(old_lines[old_pos++]);
+      }
+      continue;
+    }
+    const std::string text = line.substr(1);
+    if (line[0] == '+') {
+      out.push_back(text);
+    } else if (old_pos >= old_lines.size() || old_lines[old_pos] != text) {
+      return false;
+    } else {
+      if (line[0] == ' ') {
+        out.push_back(text);
+      }
+      ++old_pos;
+    }
+  }
+  while (old_pos < old_lines.size()) {
+    out.emplace_back(old_lines[old_pos++]);
+  }
+  return true;
+}
+
+void test_random_diffs_apply() {
+  std::mt19937 rng(5);
+  std::uniform_int_distribution<int> token(0, 5);
+  std::uniform_int_distribution<int> length(0, 40);
+  const std::vector<std::string> alphabet = {"a", "b", "c", "d", "e", "f"};
+
+  for (int round = 0; round < 300; ++round) {
+    std::vector<std::string_view> old_lines(length(rng));
+    std::vector<std::string_view> new_lines(length(rng));
+    for (auto &l : old_lines)
+      l = alphabet[token(rng)];
+    for (auto &l : new_lines)
+      l = alphabet[token(rng)];
+
+    std::vector<std::string> rebuilt;
+    const bool applied =
+        apply_diff(old_lines, unified_diff(old_lines, new_lines), rebuilt);
+    expect_true(applied && rebuilt == std::vector<std::string>(
+                                         new_lines.begin(), new_lines.end()),
+                "random diff " + std::to_string(round) + " applies");
+  }
+}
+
+void benchmark_large_sheet() {
+  constexpr int rows = 20000;
+  constexpr int changed_rows = 200;
+  std::mt19937 rng(9);
+  std::uniform_int_distribution<int> value(0, 999999);
+
+  std::string old_csv = "Model,Price,Range,Weight,Battery,Power,Torque,Width\n";
+  std::vector<std::string> lines;
+  for (int r = 0; r < rows; ++r) {
+    lines.push_back(std::format("Car {},{},{},{},{},{},{},{}", r, value(rng),
+                                value(rng), value(rng), value(rng), value(rng),
+                                value(rng), value(rng)));
+  }
+  std::string new_csv = old_csv;
+  for (int r = 0; r < rows; ++r) {
+    old_csv += lines[r] + "\n";
+    if (r % (rows / changed_rows) == 0) {
+      new_csv += lines[r] + "9\n";
+    } else {
+      new_csv += lines[r] + "\n";
+    }
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const std::string diff = diff_csv(old_csv, new_csv);
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  std::cout << "DiffUtil benchmark (" << rows << " rows, " << changed_rows
+            << " changed): diff="
+            << std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+                   .count()
+            << "us\n";
+  expect_true(diff.find("+Car 0,") != std::string::npos,
+              "benchmark diff contains a changed row");
+}
+
 } // namespace
 
 int main() {
   test_diff_without_transpose();
   test_diff_with_transpose();
+  test_diff_with_quoted_cells();
+  test_diff_output_format();
+  test_hunk_ranges();
+  test_random_diffs_apply();
+  test_keyed_diff_reports_cells();
+  test_keyed_diff_columns_and_keys();
+  test_keyed_diff_with_transpose();
+  benchmark_large_sheet();
 
   if (failures != 0) {
     std::cerr << failures << " test failure(s)\n";
@@ -0,0 +1,375 @@
+#include <DriveChanges.h>
+#include <DriveWebhookServer.h>
+
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <ollama.hpp>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(bool condition, const std::string &message) {
+  if (!condition) {
+    std::cerr << "FAIL: " << message << "\n";
+    ++failures;
+  }
+}
+
+void expect_false(bool condition, const std::string &message) {
+  expect_true(!condition, message);
+}
+
+const std::string api = "http://127.0.0.1:9/drive/v3";
+const std::string sheet_folder = "sheets";
+
+std::string query_value(const std::string &url, const std::string &name) {
+  const auto start = url.find(name + "=");
+  if (start == std::string::npos) {
+    return {};
+  }
+  const auto begin = start + name.size() + 1;
+  return url.substr(begin, url.find('&', begin) - begin);
+}
+
+// Stand-in for the Drive changes API: a log of file edits where a page
+// token is a position in the log. Pages hold two changes, so a poll across
+// several edits has to follow nextPageToken like against the real API.
+class StandInDrive {
+public:
+  void edit(const std::string &id, const std::string &name,
+            const std::string &modified_time, bool removed = false,
+            const std::string &folder = sheet_folder) {
+    log.push_back({id, name, modified_time, removed, folder});
+  }
+
+  std::pair<int, std::string> get(const std::string &url) {
+    ++requests;
+    if (denied) {
+      return {403, R"({"error":{"message":"Insufficient permissions"}})"};
+    }
+    if (url.starts_with(api + "/changes/startPageToken?")) {
+      return {200, std::format(R"({{"startPageToken":"{}"}})", log.size())};
+    }
+    if (!url.starts_with(api + "/changes?")) {
+      return {404, "{}"};
+    }
+    const auto token = query_value(url, "pageToken");
+    if (token.empty() || std::stoul(token) > log.size()) {
+      return {400, R"({"error":{"message":"Invalid pageToken"}})"};
+    }
+
+    std::size_t position = std::stoul(token);
+    ollama::json body;
+    body["changes"] = ollama::json::array();
+    for (int n = 0; n < 2 && position < log.size(); ++n, ++position) {
+      const auto &entry = log[position];
+      ollama::json change;
+      change["removed"] = entry.removed;
+      if (!entry.removed) {
+        change["file"] = {{"id", entry.id},
+                          {"name", entry.name},
+                          {"modifiedTime", entry.modified_time},
+                          {"webViewLink", "https://example/" + entry.id},
+                          {"parents", ollama::json::array({entry.folder})}};
+      }
+      body["changes"].push_back(change);
+    }
+    if (position < log.size()) {
+      body["nextPageToken"] = std::to_string(position);
+    } else {
+      body["newStartPageToken"] = std::to_string(position);
+    }
+    return {200, body.dump()};
+  }
+
+  int requests = 0;
+  // Answer every request with 403, like a key without access to the feed.
+  bool denied = false;
+
+private:
+  struct Entry {
+    std::string id;
+    std::string name;
+    std::string modified_time;
+    bool removed;
+    std::string folder;
+  };
+  std::vector<Entry> log;
+};
+
+// One poll as the sheet refresh runs it: the token moves on, or is cleared
+// after a failure so the folder is listed.
+std::optional<std::vector<drive_changes::DriveFile>>
+poll(StandInDrive &drive, std::string &page_token, int max_pages = 50) {
+  drive_changes::ChangesPoll changes(api, page_token, "key", sheet_folder,
+                                     max_pages);
+  drive_changes::run_poll(changes, [&](const std::string &url) {
+    return drive.get(url);
+  });
+  page_token = changes.next_page_token();
+  if (changes.step() != drive_changes::ChangesPoll::Step::Done) {
+    return std::nullopt;
+  }
+  return changes.files();
+}
+
+void test_urls_and_bodies() {
+  expect_true(drive_changes::start_page_token_url(api, "k y") ==
+                  api + "/changes/startPageToken?key=k%20y",
+              "start token URL escapes the key");
+  const auto url = drive_changes::changes_url(api, "12", "key");
+  expect_true(url.starts_with(api + "/changes?pageToken=12&key=key"),
+              "changes URL carries the token");
+  expect_true(url.find("fields=nextPageToken,newStartPageToken,changes(") !=
+                  std::string::npos,
+              "changes URL asks only for the needed fields");
+
+  const auto body = ollama::json::parse(drive_changes::watch_request_body(
+      "chan", "https://bot.example/drive", "secret", 1700000000000));
+  expect_true(body["type"] == "web_hook" &&
+                  body["address"] == "https://bot.example/drive" &&
+                  body["token"] == "secret" &&
+                  body["expiration"] == "1700000000000",
+              "watch request body");
+  expect_true(drive_changes::parse_watch_expiration(
+                  R"({"kind":"api#channel","expiration":"1700000000999"})") ==
+                  1700000000999,
+              "watch expiration parsed from a string");
+}
+
+void test_parse_responses() {
+  expect_true(drive_changes::parse_start_page_token(
+                  R"({"startPageToken":"42"})") == "42",
+              "start token parsed");
+  expect_false(drive_changes::parse_start_page_token("not json").has_value(),
+               "bad start token body rejected");
+  expect_false(drive_changes::parse_changes_page(R"({"changes":[]})")
+                   .has_value(),
+               "page without any token rejected");
+
+  const auto files = drive_changes::parse_file_list(
+      R"({"files":[{"id":"a","name":"TB test results",)"
+      R"("modifiedTime":"2026-01-02T03:04:05.678Z","webViewLink":"l"},)"
+      R"({"id":"b"}]})");
+  expect_true(files && files->size() == 1 &&
+                  files->front().modified_time == "2026-01-02T03:04:05.678Z",
+              "folder listing parsed, incomplete entries skipped");
+}
+
+void test_feed_against_stand_in() {
+  StandInDrive drive;
+  drive.edit("a", "TB test results", "2026-01-01T00:00:00.000Z");
+
+  std::string token =
+      *drive_changes::parse_start_page_token(
+          drive.get(drive_changes::start_page_token_url(api, "key")).second);
+
+  auto files = poll(drive, token);
+  expect_true(files && files->empty(), "no edits since the start token");
+
+  drive.edit("a", "TB test results", "2026-01-01T00:01:00.000Z");
+  drive.edit("x", "Other file", "2026-01-01T00:02:00.000Z");
+  drive.edit("gone", "", "", true);
+  drive.edit("a", "TB test results", "2026-01-01T00:03:00.000Z");
+  drive.edit("b", "Charging curves", "2026-01-01T00:04:00.000Z");
+
+  drive.requests = 0;
+  files = poll(drive, token);
+  expect_true(drive.requests == 3, "five changes take three pages");
+  expect_true(files && files->size() == 3, "one entry per file, removals skipped");
+  if (files && files->size() == 3) {
+    expect_true((*files)[0].id == "x" && (*files)[1].id == "a" &&
+                    (*files)[1].modified_time == "2026-01-01T00:03:00.000Z" &&
+                    (*files)[2].id == "b",
+                "latest edit of each file kept in feed order");
+  }
+  expect_true(token == "6", "token advanced past every change");
+
+  files = poll(drive, token);
+  expect_true(files && files->empty(), "nothing new on the next poll");
+
+  std::string stale = "99";
+  expect_false(poll(drive, stale).has_value(),
+               "invalid token reported so the folder is listed instead");
+  expect_true(stale.empty(), "failed poll clears the token");
+}
+
+void test_feed_limits_and_filters() {
+  StandInDrive drive;
+  std::string token = "0";
+  drive.edit("a", "TB test results", "2026-01-01T00:01:00.000Z");
+  drive.edit("copy", "TB test results", "2026-01-01T00:02:00.000Z", false,
+             "elsewhere");
+  drive.edit("b", "Charging curves", "2026-01-01T00:03:00.000Z");
+  drive.edit("b", "Charging curves", "2026-01-01T00:04:00.000Z", false,
+             "elsewhere");
+  auto files = poll(drive, token);
+  expect_true(files && files->size() == 1 && (*files)[0].id == "a" &&
+                  (*files)[0].parents == std::vector<std::string>{sheet_folder},
+              "copies outside the folder and files moved out are dropped");
+
+  for (int i = 0; i < 10; ++i) {
+    drive.edit("a", "TB test results", std::format("2026-01-02T00:0{}:00Z", i));
+  }
+  std::string capped = token;
+  drive.requests = 0;
+  expect_false(poll(drive, capped, 3).has_value() || !capped.empty(),
+               "a feed longer than max_pages fails and clears the token");
+  expect_true(drive.requests == 4, "paging stops after max_pages + 1");
+
+  drive.denied = true;
+  drive_changes::ChangesPoll refused(api, token, "key", sheet_folder);
+  drive_changes::run_poll(refused, [&](const std::string &url) {
+    return drive.get(url);
+  });
+  expect_true(refused.step() == drive_changes::ChangesPoll::Step::Failed &&
+                  refused.denied() && refused.last_status() == 403,
+              "403 reported as denied");
+  expect_true(drive_changes::is_auth_failure(401) &&
+                  !drive_changes::is_auth_failure(400),
+              "only 401 and 403 are auth failures");
+}
+
+std::string send_request(std::uint16_t port, const std::string &request) {
+  const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+  if (::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) !=
+      0) {
+    ::close(fd);
+    return {};
+  }
+  ::send(fd, request.data(), request.size(), 0);
+  std::string response;
+  char buffer[512];
+  ssize_t received = 0;
+  while ((received = ::recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+    response.append(buffer, static_cast<std::size_t>(received));
+  }
+  ::close(fd);
+  return response;
+}
+
+std::string notification(const std::string &token, const std::string &state) {
+  return std::format("POST /drive HTTP/1.1\r\nHost: 127.0.0.1\r\n"
+                     "X-Goog-Channel-ID: chan\r\n"
+                     "x-goog-channel-token: {}\r\n"
+                     "X-Goog-Resource-State: {}\r\n"
+                     "Content-Length: 0\r\n\r\n",
+                     token, state);
+}
+
+void test_webhook_server() {
+  std::mutex mutex;
+  std::vector<std::string> states;
+  DriveWebhookServer server("secret", [&](const std::string &state) {
+    std::lock_guard lock(mutex);
+    states.push_back(state);
+  });
+  expect_true(server.start(0) && server.port() != 0, "listens on a free port");
+
+  expect_true(send_request(server.port(), notification("secret", "sync"))
+                  .starts_with("HTTP/1.1 200"),
+              "sync acknowledged");
+  expect_true(send_request(server.port(), notification("secret", "change"))
+                  .starts_with("HTTP/1.1 200"),
+              "change acknowledged");
+  expect_true(send_request(server.port(), notification("wrong", "change"))
+                  .starts_with("HTTP/1.1 403"),
+              "wrong channel token rejected");
+  expect_true(send_request(server.port(),
+                           "GET /drive HTTP/1.1\r\nHost: x\r\n\r\n")
+                  .starts_with("HTTP/1.1 405"),
+              "only POST accepted");
+
+  // A connection that never sends anything must not hold up the next one.
+  const int idle = ::socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(server.port());
+  expect_true(::connect(idle, reinterpret_cast<sockaddr *>(&address),
+                        sizeof(address)) == 0,
+              "idle client connects");
+  const auto sent = std::chrono::steady_clock::now();
+  expect_true(send_request(server.port(), notification("secret", "change"))
+                  .starts_with("HTTP/1.1 200"),
+              "notification acknowledged next to an idle client");
+  expect_true(std::chrono::steady_clock::now() - sent <
+                  std::chrono::milliseconds(300),
+              "idle client does not delay other requests");
+  char byte = 0;
+  expect_true(::recv(idle, &byte, 1, 0) == 0, "idle client is disconnected");
+  ::close(idle);
+
+  // Sending a byte at a time keeps the connection busy but not alive.
+  const int slow = ::socket(AF_INET, SOCK_STREAM, 0);
+  expect_true(::connect(slow, reinterpret_cast<sockaddr *>(&address),
+                        sizeof(address)) == 0,
+              "slow client connects");
+  const auto slow_start = std::chrono::steady_clock::now();
+  bool cut_off = false;
+  while (std::chrono::steady_clock::now() - slow_start <
+         std::chrono::seconds(3)) {
+    if (::send(slow, "x", 1, MSG_NOSIGNAL) != 1) {
+      cut_off = true;
+      break;
+    }
+    pollfd closed{slow, POLLIN, 0};
+    if (::poll(&closed, 1, 50) > 0 && ::recv(slow, &byte, 1, 0) <= 0) {
+      cut_off = true;
+      break;
+    }
+  }
+  expect_true(cut_off && std::chrono::steady_clock::now() - slow_start <
+                             std::chrono::seconds(2),
+              "client trickling bytes is closed at the deadline");
+  ::close(slow);
+
+  {
+    std::lock_guard lock(mutex);
+    expect_true(states == std::vector<std::string>{"sync", "change", "change"},
+                "only authenticated notifications reported");
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  server.stop();
+  expect_true(std::chrono::steady_clock::now() - start <
+                  std::chrono::seconds(2),
+              "stop does not hang on accept");
+}
+
+} // namespace
+
+int main() {
+  test_urls_and_bodies();
+  test_parse_responses();
+  test_feed_against_stand_in();
+  test_feed_limits_and_filters();
+  test_webhook_server();
+
+  if (failures != 0) {
+    std::cerr << failures << " test failure(s)\n";
+    return 1;
+  }
+
+  std::cout << "All DriveChanges tests passed\n";
+  return 0;
+}
@@ -0,0 +1,181 @@
+#include <IntentMatcher.h>
+
+#include <ollama.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(bool condition, const std::string &message) {
+  if (!condition) {
+    std::cerr << "FAIL: " << message << "\n";
+    ++failures;
+  }
+}
+
+void expect_false(bool condition, const std::string &message) {
+  expect_true(!condition, message);
+}
+
+struct LabeledMessage {
+  std::string text;
+  // Empty when the message must fall back to the full tool loop.
+  std::string tool_name;
+  // Expected argument fields; only the listed ones are compared.
+  ollama::json arguments;
+};
+
+const std::vector<LabeledMessage> &corpus() {
+  static const std::vector<LabeledMessage> messages = {
+      {"<@1234567890> is bjørn live?", "get_youtube_stream_status", {}},
+      {"Is Bjørn live right now", "get_youtube_stream_status", {}},
+      {"er bjørn live nå?", "get_youtube_stream_status", {}},
+      {"nissefar, is the stream live?", "get_youtube_stream_status", {}},
+      {"er streamen på lufta?", "get_youtube_stream_status", {}},
+      {"<@!1234567890>   IS   BJORN   STREAMING??", "get_youtube_stream_status", {}},
+      {"top reactions this month",
+       "query_channel_analytics",
+       {{"target", "reactions"}, {"group_by", "emoji"}, {"time_range", "this_month"},
+        {"scope", "server"}, {"limit", 10}}},
+      {"<@1234567890> what are the most used reactions?",
+       "query_channel_analytics",
+       {{"target", "reactions"}, {"group_by", "emoji"}, {"time_range", "all_time"}}},
+      {"most used emojis in the last 30 days in this channel",
+       "query_channel_analytics",
+       {{"time_range", "last_30d"}, {"scope", "channel"}}},
+      {"mest brukte reaksjoner forrige måned",
+       "query_channel_analytics",
+       {{"time_range", "last_month"}}},
+      {"top 10 reactions past week", "query_channel_analytics",
+       {{"time_range", "last_7d"}, {"limit", 10}}},
+      {"top 5 reactions", "query_channel_analytics",
+       {{"time_range", "all_time"}, {"limit", 5}}},
+      {"topp 500 emojier her", "query_channel_analytics",
+       {{"scope", "channel"}, {"limit", 120}}},
+      {"top 0 reactions", "query_channel_analytics", {{"limit", 1}}},
+      {"who posts the most?",
+       "query_channel_analytics",
+       {{"target", "messages"}, {"group_by", "author"}, {"time_range", "all_time"}}},
+      {"hvem skriver mest denne måneden her",
+       "query_channel_analytics",
+       {{"target", "messages"}, {"time_range", "this_month"}, {"scope", "channel"}}},
+      {"what is 17 * 23?", "calculate_with_bc", {{"expression", "17 * 23"}}},
+      {"regn ut (2,5 + 3) / 4", "calculate_with_bc",
+       {{"expression", "(2.5 + 3) / 4"}}},
+      {"calculate 2^10", "calculate_with_bc", {{"expression", "2^10"}}},
+
+      // Near misses that need the model.
+      {"is bjørn live tomorrow?", "", {}},
+      {"was bjørn live yesterday?", "", {}},
+      {"what did bjørn say when he was live?", "", {}},
+      {"is bjørn's new car any good?", "", {}},
+      {"top reactions to my last message", "", {}},
+      {"what are the top reactions from bob this month?", "", {}},
+      {"who posts the most clown emojis?", "", {}},
+      {"what is 42?", "", {}},
+      {"what is the range of the model y?", "", {}},
+      {"calculate the charging time from 10 to 80%", "", {}},
+      {"what is 17 * 23 in hex?", "", {}},
+      {"summarize https://example.com/top-reactions", "", {}},
+      {"", "", {}},
+      {"<@1234567890>", "", {}},
+  };
+  return messages;
+}
+
+bool arguments_match(const std::string &arguments_json,
+                     const ollama::json &expected) {
+  const auto actual = ollama::json::parse(arguments_json, nullptr, false);
+  if (actual.is_discarded() || !actual.is_object())
+    return false;
+  for (const auto &[key, value] : expected.items()) {
+    if (!actual.contains(key) || actual[key] != value)
+      return false;
+  }
+  return true;
+}
+
+void test_corpus_precision() {
+  const auto matcher = IntentMatcher::with_default_rules();
+
+  int matched = 0;
+  int correct = 0;
+  int expected_matches = 0;
+
+  for (const auto &sample : corpus()) {
+    const auto result = matcher.match(sample.text);
+    if (!sample.tool_name.empty())
+      ++expected_matches;
+
+    if (!result.has_value()) {
+      expect_true(sample.tool_name.empty(),
+                  "expected a match for: " + sample.text);
+      continue;
+    }
+
+    ++matched;
+    const bool is_correct = result->tool_name == sample.tool_name &&
+                            arguments_match(result->arguments_json,
+                                            sample.arguments);
+    if (is_correct) {
+      ++correct;
+    }
+    expect_true(is_correct, "wrong or unexpected match for: " + sample.text +
+                                " -> " + result->tool_name + " " +
+                                result->arguments_json);
+  }
+
+  const double precision = matched == 0 ? 1.0 : static_cast<double>(correct) / matched;
+  const double recall = expected_matches == 0
+                            ? 1.0
+                            : static_cast<double>(correct) / expected_matches;
+  std::cout << "Intent corpus: " << corpus().size() << " messages, precision="
+            << precision << " recall=" << recall << "\n";
+  expect_true(precision == 1.0, "fast path precision must be 1.0");
+}
+
+void test_normalize() {
+  expect_true(IntentMatcher::normalize("<@123>  Is\tBjørn  LIVE ") ==
+                  "is bjørn live",
+              "normalize strips mentions, lowercases and collapses spaces");
+  expect_true(IntentMatcher::normalize("Nissefar: top reactions") ==
+                  "top reactions",
+              "normalize strips a leading address");
+}
+
+void test_custom_rule() {
+  IntentMatcher matcher;
+  expect_false(matcher.match("ping").has_value(), "empty matcher never matches");
+
+  matcher.add_rule("ping", "^ping$", "ping_tool",
+                   [](const std::smatch &) { return std::optional<std::string>("{}"); });
+  const auto result = matcher.match("PING");
+  expect_true(result.has_value() && result->rule == "ping" &&
+                  result->tool_name == "ping_tool",
+              "custom rule matches");
+
+  matcher.add_rule("reject", "^pong$", "pong_tool",
+                   [](const std::smatch &) { return std::optional<std::string>(); });
+  expect_false(matcher.match("pong").has_value(),
+               "builder returning nullopt rejects the match");
+}
+
+} // namespace
+
+int main() {
+  test_corpus_precision();
+  test_normalize();
+  test_custom_rule();
+
+  if (failures != 0) {
+    std::cerr << failures << " test failure(s)\n";
+    return 1;
+  }
+
+  std::cout << "All IntentMatcher tests passed\n";
+  return 0;
+}
@@ -0,0 +1,129 @@
+#include <MessageSearch.h>
+
+#include <iostream>
+#include <string>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(bool condition, const std::string &message) {
+  if (!condition) {
+    std::cerr << "FAIL: " << message << "\n";
+    ++failures;
+  }
+}
+
+void expect_false(bool condition, const std::string &message) {
+  expect_true(!condition, message);
+}
+
+bool contains(const std::string &haystack, const std::string &needle) {
+  return haystack.find(needle) != std::string::npos;
+}
+
+void test_default_server_relevance_search() {
+  const auto parsed = message_search::parse_and_compile(
+      R"({"query":"  ioniq 5 charging bug "})");
+  expect_true(parsed.ok(), "plain query parses");
+  if (!parsed.ok()) {
+    return;
+  }
+
+  const auto &search = *parsed.search;
+  expect_true(search.scope == "server", "scope defaults to server");
+  expect_true(search.query == "ioniq 5 charging bug", "query is trimmed");
+  expect_true(search.bind_params.size() == 2 &&
+                  search.bind_params[0] == "ioniq 5 charging bug" &&
+                  search.bind_params[1] == "%ioniq 5 charging bug%",
+              "full-text and substring parameters are bound");
+  expect_true(contains(search.sql, "s.server_snowflake_id = $1"),
+              "server scope filters on server snowflake");
+  expect_true(contains(search.sql,
+                       "to_tsvector('simple', coalesce(m.content, '')) @@ "
+                       "websearch_to_tsquery('simple', $2)") &&
+                  contains(search.sql, "m.content ilike $3"),
+              "search uses the indexed tsvector and trigram predicates");
+  expect_true(contains(search.sql, "order by m.message_id desc limit 500) m") &&
+                  contains(search.sql, "order by score desc"),
+              "only the newest 500 matches are ranked");
+  expect_true(contains(search.sql, "limit 8"), "default limit");
+  expect_false(contains(search.sql, "ioniq"), "query text is never inlined");
+}
+
+void test_channel_scope_author_and_newest() {
+  const auto parsed = message_search::parse_and_compile(
+      R"({"query":"copium","scope":"channel","author":"bj_rn","sort":"newest","time_range":"last_30d","limit":50})");
+  expect_true(parsed.ok(), "filtered query parses");
+  if (!parsed.ok()) {
+    return;
+  }
+
+  const auto &search = *parsed.search;
+  expect_true(contains(search.sql, "c.channel_snowflake_id = $1"),
+              "channel scope filters on channel snowflake");
+  expect_false(contains(search.sql, "join server"), "channel scope skips server join");
+  expect_true(contains(search.sql, "u.user_name ilike $4") &&
+                  search.bind_params.size() == 3 &&
+                  search.bind_params[2] == "bj\\_rn",
+              "author filter is bound and escaped");
+  expect_true(contains(search.sql, "order by m.message_id desc limit 20) m") &&
+                  search.sql.ends_with("order by m.message_id desc limit 20"),
+              "newest first, no more candidates than the limit");
+  expect_true(contains(search.sql, "interval '30 days'"), "time range applied");
+  expect_true(search.limit == 20, "limit is clamped");
+}
+
+void test_like_escaping() {
+  expect_true(message_search::escape_like("100%_a\\b") == "100\\%\\_a\\\\b",
+              "like wildcards are escaped");
+  const auto parsed = message_search::parse_and_compile(R"({"query":"50% off"})");
+  expect_true(parsed.ok() && parsed.search->bind_params[1] == "%50\\% off%",
+              "substring pattern keeps literal percent");
+}
+
+void test_invalid_requests_rejected() {
+  expect_false(message_search::parse_and_compile("nope").ok(), "invalid JSON");
+  expect_false(message_search::parse_and_compile(R"({})").ok(), "missing query");
+  expect_false(message_search::parse_and_compile(R"({"query":" a "})").ok(),
+               "too short query");
+  expect_false(message_search::parse_and_compile(R"({"query":"ab"})").ok(),
+               "two character query");
+  expect_false(message_search::parse_and_compile(R"({"query":"æø"})").ok(),
+               "two multibyte characters");
+  expect_true(message_search::parse_and_compile(R"({"query":"æøå"})").ok(),
+              "three multibyte characters");
+  expect_false(message_search::parse_and_compile(
+                   R"({"query":"abc","scope":"global"})")
+                   .ok(),
+               "unknown scope");
+  expect_false(message_search::parse_and_compile(
+                   R"({"query":"abc","time_range":"forever"})")
+                   .ok(),
+               "unknown time range");
+  expect_false(message_search::parse_and_compile(
+                   R"({"query":"abc","limit":"5"})")
+                   .ok(),
+               "non-integer limit");
+  expect_false(message_search::parse_and_compile(
+                   "{\"query\":\"" + std::string(201, 'x') + "\"}")
+                   .ok(),
+               "too long query");
+}
+
+} // namespace
+
+int main() {
+  test_default_server_relevance_search();
+  test_channel_scope_author_and_newest();
+  test_like_escaping();
+  test_invalid_requests_rejected();
+
+  if (failures != 0) {
+    std::cerr << failures << " test failure(s)\n";
+    return 1;
+  }
+
+  std::cout << "All MessageSearch tests passed\n";
+  return 0;
+}
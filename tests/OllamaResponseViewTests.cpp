@@ -0,0 +1,191 @@
+#include <OllamaToolCalling.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(bool condition, const std::string &message) {
+  if (!condition) {
+    std::cerr << "FAIL: " << message << "\n";
+    ++failures;
+  }
+}
+
+// Responses captured from the chat endpoint (ids and long content shortened).
+const std::string final_answer_response = R"({
+  "model": "qwen3:32b",
+  "created_at": "2025-06-01T18:21:05.512Z",
+  "message": {"role": "assistant", "content": "Model Y har 67 liter frunk."},
+  "done_reason": "stop",
+  "done": true,
+  "total_duration": 4182000000,
+  "prompt_eval_count": 5120,
+  "eval_count": 42
+})";
+
+const std::string tool_call_response = R"({
+  "model": "qwen3:32b",
+  "created_at": "2025-06-01T18:20:59.104Z",
+  "message": {
+    "role": "assistant",
+    "content": "",
+    "tool_calls": [
+      {"function": {"name": "get_range_data", "arguments": {}}},
+      {"function": {"name": "calculate_with_bc", "arguments": {"expression": "530/1.2"}}}
+    ]
+  },
+  "done_reason": "stop",
+  "done": true,
+  "prompt_eval_count": 4870,
+  "eval_count": 61
+})";
+
+const std::string generate_response = R"({
+  "model": "llava:13b",
+  "response": "A red car parked by a charger.",
+  "done": true,
+  "prompt_eval_count": 812,
+  "eval_count": 17
+})";
+
+void test_final_answer() {
+  const auto payload = ollama::json::parse(final_answer_response);
+  const ollama_tools::ResponseView view(payload);
+  expect_true(!view.has_tool_calls(), "final answer has no tool calls");
+  expect_true(view.text() == "Model Y har 67 liter frunk.", "final answer text");
+  expect_true(view.content_length() == view.text().size(), "content length matches text");
+  expect_true(view.prompt_eval_count() == 5120, "prompt eval count read");
+  expect_true(view.eval_count() == 42, "eval count read");
+  expect_true(view.field_dump("done_reason") == "\"stop\"", "done_reason dumped as JSON");
+  expect_true(view.field_dump("missing") == "n/a", "missing field reported as n/a");
+}
+
+void test_tool_calls() {
+  const auto payload = ollama::json::parse(tool_call_response);
+  const ollama_tools::ResponseView view(payload);
+  expect_true(&view.json() == &payload, "view reads the payload in place");
+  expect_true(view.has_tool_calls(), "tool call response detected");
+  expect_true(view.tool_calls().size() == 2, "both tool calls exposed");
+  expect_true(&view.tool_calls() == &view.tool_calls(),
+              "tool calls returned by reference into the payload");
+
+  const auto assistant = view.assistant_message();
+  expect_true(assistant.contains("tool_calls") && assistant["tool_calls"].size() == 2,
+              "assistant message keeps tool calls");
+  expect_true(view.text().empty(), "empty content stays empty");
+  expect_true(view.shape() == "message.content type=string", "shape describes content");
+}
+
+void test_generate_and_malformed() {
+  const auto generate_payload = ollama::json::parse(generate_response);
+  const ollama_tools::ResponseView generated(generate_payload);
+  expect_true(generated.text() == "A red car parked by a charger.",
+              "generate endpoint response field used");
+  expect_true(generated.shape() == "missing message object", "generate shape");
+
+  const auto odd_payload =
+      ollama::json::parse(R"({"message":{"role":"assistant"}})");
+  const ollama_tools::ResponseView odd(odd_payload);
+  expect_true(odd.shape() == "message without content", "missing content detected");
+  expect_true(!odd.has_tool_calls() && odd.tool_calls().is_array(),
+              "missing tool calls yield empty array");
+  expect_true(odd.prompt_eval_count() == 0, "missing counters default to zero");
+}
+
+// The access pattern of one tool-call iteration before the view: the loop
+// copied the payload once, and the tool-call count, the names for the log and
+// the dispatch loop each took a copy of the tool-call array. The presence
+// check read the payload by reference.
+std::size_t legacy_iteration(const ollama::json &response) {
+  const auto has_calls = [&] {
+    return response.contains("message") &&
+           response["message"].contains("tool_calls") &&
+           !response["message"]["tool_calls"].empty();
+  };
+  const auto tool_calls = [&] {
+    return has_calls() ? response["message"]["tool_calls"]
+                       : ollama::json::array();
+  };
+
+  std::size_t touched = 0;
+  const auto payload = response;
+  if (has_calls()) {
+    touched += tool_calls().size();
+    touched += tool_calls().size();
+    for (const auto &call : tool_calls())
+      touched += call.size();
+  }
+  touched += payload["message"]["content"].get<std::string>().size();
+  return touched;
+}
+
+std::size_t view_iteration(const ollama::json &response) {
+  std::size_t touched = 0;
+  const ollama_tools::ResponseView view(response);
+  if (view.has_tool_calls()) {
+    touched += view.tool_calls().size();
+    touched += view.tool_calls().size();
+    for (const auto &call : view.tool_calls())
+      touched += call.size();
+  }
+  touched += view.content_length();
+  return touched;
+}
+
+void benchmark_large_tool_response() {
+  // A turn that carries a large tool-heavy assistant message, like a
+  // webpage summary echoed back with several tool calls.
+  ollama::json response = ollama::json::parse(tool_call_response);
+  response["message"]["content"] = std::string(256 * 1024, 'x');
+  for (int i = 0; i < 40; ++i) {
+    response["message"]["tool_calls"].push_back(
+        {{"function",
+          {{"name", "get_webpage_text"},
+           {"arguments", {{"url", std::string(2048, 'u')}}}}}});
+  }
+
+  constexpr int iterations = 200;
+  std::size_t sink = 0;
+
+  const auto legacy_start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i)
+    sink += legacy_iteration(response);
+  const auto legacy_time = std::chrono::steady_clock::now() - legacy_start;
+
+  const auto view_start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i)
+    sink += view_iteration(response);
+  const auto view_time = std::chrono::steady_clock::now() - view_start;
+
+  const auto to_us = [](auto duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+  };
+  std::cout << "ResponseView benchmark (" << iterations
+            << " iterations, ~340 KB payload): legacy=" << to_us(legacy_time)
+            << "us view=" << to_us(view_time) << "us sink=" << sink << "\n";
+
+  expect_true(legacy_iteration(response) == view_iteration(response),
+              "legacy and view paths read the same data");
+}
+
+} // namespace
+
+int main() {
+  test_final_answer();
+  test_tool_calls();
+  test_generate_and_malformed();
+  benchmark_large_tool_response();
+
+  if (failures != 0) {
+    std::cerr << failures << " test failure(s)\n";
+    return 1;
+  }
+
+  std::cout << "All OllamaResponseView tests passed\n";
+  return 0;
+}
@@ -0,0 +1,57 @@
+#include <RowHash.h>
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(bool condition, const std::string &message) {
+  if (!condition) {
+    std::cerr << "FAIL: " << message << "\n";
+    ++failures;
+  }
+}
+
+void expect_false(bool condition, const std::string &message) {
+  expect_true(!condition, message);
+}
+
+void test_reference_values() {
+  expect_true(xxhash64("") == 0xEF46DB3751D8E999ULL, "empty input");
+  expect_true(xxhash64("abc") == 0x44BC2CF5AD770999ULL, "short input");
+  expect_true(xxhash64("Nobody inspects the spammish repetition") ==
+                  0xFBCEA83C8A378BF1ULL,
+              "input longer than one 32-byte stripe");
+  expect_false(xxhash64("abc", 1) == xxhash64("abc"), "seed changes the hash");
+}
+
+void test_row_hash() {
+  const std::vector<std::string_view> row = {"Kia EV6", "2100", ""};
+  const std::vector<std::string_view> same = {"Kia EV6", "2100", ""};
+  const std::vector<std::string_view> shifted = {"Kia EV", "62100", ""};
+  const std::vector<std::string_view> shorter = {"Kia EV6", "2100"};
+  expect_true(hash_row(row) == hash_row(same), "equal rows hash equal");
+  expect_false(hash_row(row) == hash_row(shifted),
+               "text moved between cells changes the hash");
+  expect_false(hash_row(row) == hash_row(shorter),
+               "trailing empty cell changes the hash");
+}
+
+} // namespace
+
+int main() {
+  test_reference_values();
+  test_row_hash();
+
+  if (failures != 0) {
+    std::cerr << failures << " test failure(s)\n";
+    return 1;
+  }
+
+  std::cout << "All RowHash tests passed\n";
+  return 0;
+}
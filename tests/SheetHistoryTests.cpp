@@ -0,0 +1,331 @@
+#include <CsvParser.h>
+#include <SheetHistory.h>
+
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(bool condition, const std::string &message) {
+  if (!condition) {
+    std::cerr << "FAIL: " << message << "\n";
+    ++failures;
+  }
+}
+
+void expect_false(bool condition, const std::string &message) {
+  expect_true(!condition, message);
+}
+
+using TimePoint = SheetHistory::TimePoint;
+
+TimePoint day(int n) {
+  return *parse_history_date("2026-01-01") + std::chrono::days(n);
+}
+
+std::string temp_path(const std::string &name) {
+  const auto path = std::filesystem::temp_directory_path() / name;
+  std::filesystem::remove(path);
+  return path.string();
+}
+
+std::shared_ptr<const SheetTab> make_tab(const std::string &csv) {
+  return std::make_shared<const SheetTab>(
+      SheetStore::parse("TB test results", 7, "Range", csv));
+}
+
+// The CSV the history hands back: rows padded to the header width.
+std::string normalized(const std::string &csv) {
+  const auto tab = SheetStore::parse({}, 0, {}, csv);
+  std::string out = csv_join(tab.header) + "\n";
+  for (const auto &row : tab.rows) {
+    out += csv_join(row) + "\n";
+  }
+  return out;
+}
+
+std::string range_csv(int version) {
+  std::string csv = "Model,Range,Note\n";
+  for (int i = 0; i < 40; ++i) {
+    csv += std::format("\"Car {}, AWD\",{},{}\n", i,
+                       400 + i + (i % 7 == version % 7 ? version : 0),
+                       i == version ? "retested" : "");
+  }
+  if (version % 3 == 0) {
+    csv += std::format("New car {},500,\n", version);
+  }
+  return csv;
+}
+
+void test_parse_date() {
+  const auto date = parse_history_date("2026-03-01");
+  expect_true(date && std::chrono::floor<std::chrono::days>(*date) ==
+                          std::chrono::sys_days{std::chrono::year{2026} /
+                                                3 / 1},
+              "date parsed as midnight");
+  expect_false(parse_history_date("2026-02-30").has_value(), "invalid day");
+  expect_false(parse_history_date("spring").has_value(), "not a date");
+}
+
+void test_versions_round_trip() {
+  const auto path = temp_path("nissefar_sheet_history_test.log");
+  SheetHistory history(path, 4);
+  expect_true(history.open(), "missing log opens empty");
+
+  std::vector<std::string> csvs;
+  std::shared_ptr<const SheetTab> previous;
+  for (int v = 0; v < 10; ++v) {
+    csvs.push_back(range_csv(v));
+    auto tab = make_tab(csvs.back());
+    expect_true(history.record(previous.get(), *tab, day(v * 10)),
+                "version recorded");
+    previous = std::move(tab);
+  }
+
+  const auto versions = history.versions("Range");
+  expect_true(versions.size() == 10, "every version listed");
+  std::size_t checkpoints = 0;
+  for (const auto &version : versions) {
+    checkpoints += version.checkpoint ? 1 : 0;
+  }
+  expect_true(checkpoints == 3, "checkpoint every fourth version");
+
+  expect_false(history.version_at("Range", day(-1)).has_value(),
+               "nothing before the first version");
+  for (int v = 0; v < 10; ++v) {
+    const auto version = history.version_at("Range", day(v * 10 + 5));
+    expect_true(version && version->csv == normalized(csvs[v]) &&
+                    version->time == day(v * 10),
+                std::format("version {} rebuilt", v));
+  }
+  expect_false(history.version_at("Weight", day(100)).has_value(),
+               "unknown tab");
+
+  // A reopened log indexes the same versions and appends after them.
+  SheetHistory reopened(path, 4);
+  expect_true(reopened.open(), "log reopens");
+  expect_true(reopened.versions("Range").size() == 10, "index rebuilt");
+  const auto latest = reopened.version_at("Range", day(1000));
+  expect_true(latest && latest->csv == normalized(csvs.back()),
+              "latest version after reopening");
+  auto tab = make_tab(range_csv(10));
+  expect_true(reopened.record(previous.get(), *tab, day(5)), "append");
+  expect_true(reopened.versions("Range").back().time == day(90),
+              "time going backwards is clamped");
+  expect_false(reopened.versions("Range").back().checkpoint,
+               "matching baseline after reopening stores a delta");
+
+  const auto stats = reopened.stats();
+  expect_true(stats.tabs == 1 && stats.checkpoints + stats.deltas == 11,
+              "stats count records");
+  expect_true(stats.file_bytes == std::filesystem::file_size(path),
+              "stats track the file size");
+  std::filesystem::remove(path);
+}
+
+void test_baseline_mismatch_checkpoints() {
+  const auto path = temp_path("nissefar_sheet_history_mismatch.log");
+  SheetHistory history(path, 16);
+  history.open();
+  const auto a = make_tab(range_csv(1));
+  const auto b = make_tab(range_csv(2));
+  const auto c = make_tab(range_csv(3));
+  history.record(nullptr, *a, day(0));
+  // b was never recorded, so a delta from it would be wrong.
+  history.record(b.get(), *c, day(1));
+  expect_true(history.versions("Range").back().checkpoint,
+              "unknown baseline stored as checkpoint");
+  const auto version = history.version_at("Range", day(1));
+  expect_true(version && version->csv == normalized(range_csv(3)),
+              "version after mismatch rebuilt");
+  std::filesystem::remove(path);
+}
+
+void test_unchanged_version_skipped() {
+  const auto path = temp_path("nissefar_sheet_history_restart.log");
+  const auto tab = make_tab(range_csv(1));
+  {
+    SheetHistory history(path);
+    history.open();
+    history.record(nullptr, *tab, day(0));
+  }
+  const auto size = std::filesystem::file_size(path);
+
+  // A restart without a snapshot records every tab again with no baseline.
+  SheetHistory history(path);
+  history.open();
+  expect_true(history.record(nullptr, *tab, day(0)), "repeat is accepted");
+  expect_true(history.versions("Range").size() == 1 &&
+                  std::filesystem::file_size(path) == size,
+              "repeat of the last version is not appended");
+  const auto edited = make_tab(range_csv(2));
+  history.record(nullptr, *edited, day(1));
+  expect_true(history.versions("Range").size() == 2,
+              "a changed tab is still recorded");
+  std::filesystem::remove(path);
+}
+
+void test_reordered_rows() {
+  const auto path = temp_path("nissefar_sheet_history_reorder.log");
+  SheetHistory history(path, 16);
+  history.open();
+  // Enough unchanged rows that a small edit is worth a delta.
+  std::string rest;
+  for (int i = 0; i < 30; ++i) {
+    rest += std::format("Other car {},{}\n", i, 300 + i);
+  }
+  const std::string sorted =
+      "Model,Range\nA,500\nB,480\nC,400\nD,300\n" + rest;
+  const std::string reordered =
+      "Model,Range\nD,300\nB,480\nA,500\nC,400\n" + rest;
+  const std::string reordered_edit =
+      "Model,Range\nC,400\nE,350\nA,500\nD,310\n" + rest;
+  const std::string edited =
+      "Model,Range\nC,400\nE,350\nA,505\nD,310\n" + rest;
+
+  const auto a = make_tab(sorted);
+  const auto b = make_tab(reordered);
+  const auto c = make_tab(reordered_edit);
+  const auto d = make_tab(edited);
+  history.record(nullptr, *a, day(0));
+  history.record(a.get(), *b, day(1));
+  history.record(b.get(), *c, day(2));
+  history.record(c.get(), *d, day(3));
+
+  const auto versions = history.versions("Range");
+  expect_true(versions.size() == 4 && versions[1].checkpoint &&
+                  versions[2].checkpoint,
+              "reordered versions stored as checkpoints");
+  expect_false(versions[3].checkpoint, "edit in place stored as a delta");
+  const std::vector<std::string> csvs = {sorted, reordered, reordered_edit,
+                                         edited};
+  for (int v = 0; v < 4; ++v) {
+    const auto version = history.version_at("Range", day(v));
+    expect_true(version && version->csv == normalized(csvs[v]),
+                std::format("reordered version {} keeps its row order", v));
+  }
+  std::filesystem::remove(path);
+}
+
+void test_corrupt_delta_rejected() {
+  const auto path = temp_path("nissefar_sheet_history_hash.log");
+  {
+    SheetHistory history(path, 16);
+    history.open();
+    const auto a = make_tab(range_csv(1));
+    const auto b = make_tab(range_csv(2));
+    history.record(nullptr, *a, day(0));
+    history.record(a.get(), *b, day(1));
+  }
+  // Flip a bit of the second record's csv_hash. Magic, kind, time, sheet id,
+  // file name and tab name come before it.
+  {
+    std::fstream io(path, std::ios::binary | std::ios::in | std::ios::out);
+    const std::string data((std::istreambuf_iterator<char>(io)), {});
+    const auto hash_offset = static_cast<std::streamoff>(
+        data.find("NSR1", 4) + 4 + 1 + 8 + 4 + (4 + 15) + (4 + 5));
+    io.clear();
+    io.seekp(hash_offset);
+    io.put(static_cast<char>(data[static_cast<std::size_t>(hash_offset)] ^ 1));
+  }
+
+  SheetHistory history(path, 16);
+  expect_true(history.open(), "log with a bad hash opens");
+  expect_true(history.version_at("Range", day(0)).has_value(),
+              "intact version still rebuilt");
+  expect_false(history.version_at("Range", day(1)).has_value(),
+               "version not matching its hash is rejected");
+  std::filesystem::remove(path);
+}
+
+void test_torn_tail_dropped() {
+  const auto path = temp_path("nissefar_sheet_history_torn.log");
+  {
+    SheetHistory history(path);
+    history.open();
+    const auto a = make_tab(range_csv(1));
+    const auto b = make_tab(range_csv(2));
+    history.record(nullptr, *a, day(0));
+    history.record(a.get(), *b, day(1));
+  }
+  const auto full_size = std::filesystem::file_size(path);
+  std::filesystem::resize_file(path, full_size - 5);
+
+  SheetHistory history(path);
+  expect_true(history.open(), "torn log opens");
+  expect_true(history.versions("Range").size() == 1, "partial record dropped");
+  expect_true(std::filesystem::file_size(path) < full_size - 5,
+              "file cut back to the last whole record");
+  const auto b = make_tab(range_csv(2));
+  const auto a = make_tab(range_csv(1));
+  expect_true(history.record(a.get(), *b, day(1)), "append after repair");
+  const auto version = history.version_at("Range", day(1));
+  expect_true(version && version->csv == normalized(range_csv(2)),
+              "appended version readable");
+  std::filesystem::remove(path);
+}
+
+void benchmark_storage_growth() {
+  const auto path = temp_path("nissefar_sheet_history_bench.log");
+  SheetHistory history(path);
+  history.open();
+
+  std::string base = "Model,Battery,Range,Consumption,Tested,Notes\n";
+  for (int i = 0; i < 2000; ++i) {
+    base += std::format("Brand{} Model {},{},{},{},2023-{:02},notes {}\n",
+                        i % 30, i, 60 + i % 40, 350 + i % 150, 150 + i % 60,
+                        1 + i % 12, i);
+  }
+  std::shared_ptr<const SheetTab> previous;
+  for (int v = 0; v < 200; ++v) {
+    auto csv = base + std::format("Edited {},1,{},1,2026-01,x\n", v, v);
+    auto tab = make_tab(csv);
+    history.record(previous.get(), *tab, day(v));
+    previous = std::move(tab);
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const auto version = history.version_at("Range", day(150));
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  const auto stats = history.stats();
+  std::cout << std::format(
+      "SheetHistory benchmark: 200 versions of {}B, log={}B full_copies={}B "
+      "checkpoints={} rebuild={}us\n",
+      base.size(), stats.file_bytes, stats.full_copy_bytes, stats.checkpoints,
+      std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+  expect_true(version && version->csv.find("Edited 150,") != std::string::npos,
+              "benchmark version rebuilt");
+  expect_true(stats.file_bytes * 20 < stats.full_copy_bytes,
+              "deltas keep the log far below full copies");
+  std::filesystem::remove(path);
+}
+
+} // namespace
+
+int main() {
+  test_parse_date();
+  test_versions_round_trip();
+  test_baseline_mismatch_checkpoints();
+  test_unchanged_version_skipped();
+  test_reordered_rows();
+  test_corrupt_delta_rejected();
+  test_torn_tail_dropped();
+  benchmark_storage_growth();
+
+  if (failures != 0) {
+    std::cerr << failures << " test failure(s)\n";
+    return 1;
+  }
+
+  std::cout << "All SheetHistory tests passed\n";
+  return 0;
+}
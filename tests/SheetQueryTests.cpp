@@ -0,0 +1,182 @@
+#include <SheetQuery.h>
+
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <string>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(bool condition, const std::string &message) {
+  if (!condition) {
+    std::cerr << "FAIL: " << message << "\n";
+    ++failures;
+  }
+}
+
+void expect_false(bool condition, const std::string &message) {
+  expect_true(!condition, message);
+}
+
+const SheetTab &range_tab() {
+  static const SheetTab tab = SheetStore::parse(
+      "TB test results", 1, "Range",
+      "Model,Battery,90 km/h,120 km/h,Tested\n"
+      "Kia EV9 GT-Line,96,455,350,2023-10\n"
+      "Tesla Model Y LR,75,470,360,2022-08\n"
+      "Hyundai Ioniq 5,\"72,6\",440,330,2022-05\n"
+      "Kia EV6 AWD,\"77,4\",450,340,2022-03\n"
+      "Nio ET5,,,,\n");
+  return tab;
+}
+
+sheet_query::Query parse_ok(const std::string &json) {
+  const auto parsed = sheet_query::parse(json);
+  expect_true(parsed.ok(), "parses: " + json + " " + parsed.error);
+  return parsed.query.value_or(sheet_query::Query{});
+}
+
+void test_parse_rejects_bad_requests() {
+  expect_false(sheet_query::parse("not json").ok(), "invalid JSON");
+  expect_false(sheet_query::parse(R"({"columns":["a"]})").ok(), "sheet required");
+  expect_false(
+      sheet_query::parse(
+          R"({"sheet":"Range","filters":[{"column":"a","op":"like","value":"x"}]})")
+          .ok(),
+      "unknown op rejected");
+  const auto q = parse_ok(R"({"sheet":"Range","limit":500,"order":"desc",
+      "filters":[{"column":"Battery","op":"gt","value":70}]})");
+  expect_true(q.limit == 50 && q.descending, "limit clamped, order read");
+  expect_true(q.filters.size() == 1 && q.filters[0].value == "70",
+              "numeric filter value kept as text");
+}
+
+void test_filter_and_projection() {
+  const auto q = parse_ok(R"({"sheet":"Range","columns":["120"],
+      "filters":[{"column":"model","value":"ev9"}]})");
+  const auto result = sheet_query::run(range_tab(), q);
+  expect_true(result.error.empty(), "query runs");
+  expect_true(result.matched_rows == 1 && result.returned_rows == 1,
+              "one row matches");
+  expect_true(result.output ==
+                  "Sheet: Range (1 of 5 rows matched, showing 1)\n"
+                  "Model,120 km/h\n"
+                  "Kia EV9 GT-Line,350\n",
+              "projection keeps the key column and resolves partial names");
+}
+
+void test_numeric_filters_and_sort() {
+  const auto q = parse_ok(R"({"sheet":"Range","columns":["Battery"],
+      "filters":[{"column":"Battery","op":"ge","value":"72,6"}],
+      "sort_by":"Battery","order":"desc","limit":2})");
+  const auto result = sheet_query::run(range_tab(), q);
+  expect_true(result.matched_rows == 4 && result.returned_rows == 2,
+              "decimal comma compares numerically, blanks excluded");
+  expect_true(result.output.find("Kia EV9 GT-Line,96\nKia EV6 AWD,\"77,4\"\n") !=
+                  std::string::npos,
+              "sorted descending and cells re-quoted");
+  expect_true(result.output.find("showing 2; refine") != std::string::npos,
+              "cut-off is reported");
+
+  const auto asc = parse_ok(R"({"sheet":"Range","sort_by":"120 km/h"})");
+  const auto sorted = sheet_query::run(range_tab(), asc);
+  expect_true(sorted.output.find("Ioniq 5") < sorted.output.find("EV6") &&
+                  sorted.output.find("Nio ET5") > sorted.output.find("Model Y"),
+              "ascending sort puts empty cells last");
+}
+
+void test_nan_and_inf_are_text() {
+  const auto tab = SheetStore::parse("f", 1, "Odd",
+                                     "Model,Score\nA,NaN\nB,3\nC,inf\nD,1\n");
+  expect_true(tab.column_types[1] == SheetTab::ColumnType::Text,
+              "column with nan and inf is text");
+  const auto q = parse_ok(R"({"sheet":"Odd","sort_by":"Score"})");
+  const auto result = sheet_query::run(tab, q);
+  expect_true(result.matched_rows == 4 &&
+                  result.output.find("D,1") < result.output.find("B,3"),
+              "numbers sort before nan and inf text");
+}
+
+void test_unknown_column_lists_columns() {
+  const auto q = parse_ok(R"({"sheet":"Range","columns":["Price"]})");
+  const auto result = sheet_query::run(range_tab(), q);
+  expect_true(result.error.find("Columns: Model, Battery, 90 km/h") !=
+                  std::string::npos,
+              "error lists the available columns");
+
+  const auto ambiguous = parse_ok(R"({"sheet":"Range","columns":["km/h"]})");
+  expect_false(sheet_query::run(range_tab(), ambiguous).error.empty(),
+               "ambiguous partial name is an error");
+}
+
+void test_output_budget() {
+  std::string csv = "Model,Notes\n";
+  for (int i = 0; i < 200; ++i) {
+    csv += std::format("Car {},{}\n", i, std::string(60, 'x'));
+  }
+  const auto tab = SheetStore::parse("f", 1, "Banana", std::move(csv));
+  const auto q = parse_ok(R"({"sheet":"Banana","limit":50})");
+  const auto result = sheet_query::run(tab, q, 1000);
+  expect_true(result.output.size() <= 1000, "output stays within budget");
+  expect_true(result.returned_rows > 0 && result.returned_rows < 50,
+              "rows are dropped to fit the budget");
+}
+
+void benchmark_typical_queries() {
+  std::string csv = "Model,Battery,90 km/h,120 km/h,Consumption 90,"
+                    "Consumption 120,Tested,Temperature,Wheels,Notes\n";
+  for (int i = 0; i < 400; ++i) {
+    csv += std::format("Brand{} Model {} AWD,{},{},{},{},{},2023-{:02},{},20,"
+                       "Tested in {} conditions\n",
+                       i % 30, i, 60 + i % 40, 350 + i % 150, 280 + i % 120,
+                       150 + i % 60, 190 + i % 70, 1 + i % 12, i % 25,
+                       i % 2 == 0 ? "dry" : "wet");
+  }
+  const auto tab = SheetStore::parse("f", 1, "Range", csv);
+
+  const std::string queries[] = {
+      R"({"sheet":"Range","columns":["120 km/h"],"filters":[{"column":"Model","value":"Model 217 "}]})",
+      R"({"sheet":"Range","columns":["90 km/h"],"sort_by":"90 km/h","order":"desc","limit":5})",
+      R"({"sheet":"Range","filters":[{"column":"Battery","op":"ge","value":95},{"column":"Notes","value":"dry"}],"limit":10})"};
+
+  constexpr int iterations = 200;
+  for (const auto &json : queries) {
+    const auto q = parse_ok(json);
+    std::size_t output_bytes = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+      output_bytes = sheet_query::run(tab, q).output.size();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "SheetQuery benchmark: full_csv=" << tab.csv->size()
+              << "B output=" << output_bytes << "B run="
+              << std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+                         .count() /
+                     iterations
+              << "us\n";
+    expect_true(output_bytes * 10 < tab.csv->size(),
+                "typical query returns under a tenth of the sheet");
+  }
+}
+
+} // namespace
+
+int main() {
+  test_parse_rejects_bad_requests();
+  test_filter_and_projection();
+  test_numeric_filters_and_sort();
+  test_nan_and_inf_are_text();
+  test_unknown_column_lists_columns();
+  test_output_budget();
+  benchmark_typical_queries();
+
+  if (failures != 0) {
+    std::cerr << failures << " test failure(s)\n";
+    return 1;
+  }
+
+  std::cout << "All SheetQuery tests passed\n";
+  return 0;
+}
@@ -0,0 +1,137 @@
+#include <SheetSnapshotFile.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(bool condition, const std::string &message) {
+  if (!condition) {
+    std::cerr << "FAIL: " << message << "\n";
+    ++failures;
+  }
+}
+
+void expect_false(bool condition, const std::string &message) {
+  expect_true(!condition, message);
+}
+
+std::string temp_path(const std::string &name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+using Timestamps =
+    std::map<std::string, std::chrono::sys_time<std::chrono::milliseconds>>;
+
+void test_round_trip() {
+  SheetStore store;
+  std::vector<SheetStore::TabUpdate> updates;
+  updates.push_back({"TB test results", 7, "Range",
+                     "Model,Range\n\"Kia EV6, GT\",480\nTesla Model 3,560\n"});
+  updates.push_back({"Charging curves", 2, "Charging curve",
+                     "SoC,Car1\n10,100\n20,90\n"});
+  store.update(std::move(updates));
+
+  const Timestamps timestamps = {
+      {"TB test results",
+       std::chrono::sys_time<std::chrono::milliseconds>(
+           std::chrono::milliseconds(1700000000123))}};
+
+  const auto path = temp_path("nissefar_sheet_snapshot_test.bin");
+  expect_true(save_sheet_snapshot(path, *store.snapshot(), timestamps, "4711"),
+              "snapshot saved");
+  expect_false(std::filesystem::exists(path + ".tmp"),
+               "temporary file renamed away");
+
+  const auto loaded = load_sheet_snapshot(path);
+  expect_true(loaded.has_value(), "snapshot loads");
+  if (!loaded) {
+    return;
+  }
+  expect_true(loaded->timestamps == timestamps, "timestamps round-trip");
+  expect_true(loaded->page_token == "4711", "changes feed token round-trips");
+  expect_true(loaded->tabs.size() == 2, "every tab saved");
+
+  SheetStore restored;
+  restored.update(loaded->tabs);
+  const auto range = restored.find("Range");
+  expect_true(range && range->file_name == "TB test results" &&
+                  range->sheet_id == 7 &&
+                  *range->csv == *store.find("Range")->csv,
+              "restored tab matches the saved one");
+  expect_true(restored.find("Charging curves", 2) != nullptr,
+              "tab keyed by file and sheet id");
+  std::filesystem::remove(path);
+}
+
+void test_compresses_large_exports() {
+  std::string csv = "Model,Battery,Range\n";
+  for (int i = 0; i < 5000; ++i) {
+    csv += std::format("Brand{} Model {},{},{}\n", i % 30, i, 60 + i % 40,
+                       350 + i % 150);
+  }
+  SheetStore store;
+  store.update("f", 1, "Range", csv);
+
+  const auto path = temp_path("nissefar_sheet_snapshot_large.bin");
+  expect_true(save_sheet_snapshot(path, *store.snapshot(), {}),
+              "large snapshot saved");
+  const auto size = std::filesystem::file_size(path);
+  std::cout << std::format("Sheet snapshot: {}B CSV -> {}B on disk\n",
+                           csv.size(), size);
+  expect_true(size * 3 < csv.size(), "snapshot is compressed");
+  std::filesystem::remove(path);
+}
+
+void test_rejects_bad_files() {
+  expect_false(load_sheet_snapshot(temp_path("nissefar_missing.bin")).has_value(),
+               "missing file");
+
+  SheetStore store;
+  store.update("f", 1, "Range", "Model,Range\nA,500\n");
+  const auto path = temp_path("nissefar_sheet_snapshot_corrupt.bin");
+  expect_true(save_sheet_snapshot(path, *store.snapshot(), {}),
+              "snapshot saved");
+
+  std::string bytes;
+  {
+    std::ifstream in(path, std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(in),
+                 std::istreambuf_iterator<char>());
+  }
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size() - 4));
+  }
+  expect_false(load_sheet_snapshot(path).has_value(), "truncated file");
+
+  bytes[12] ^= 0x01;
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  }
+  expect_false(load_sheet_snapshot(path).has_value(), "checksum mismatch");
+  std::filesystem::remove(path);
+}
+
+} // namespace
+
+int main() {
+  test_round_trip();
+  test_compresses_large_exports();
+  test_rejects_bad_files();
+
+  if (failures != 0) {
+    std::cerr << failures << " test failure(s)\n";
+    return 1;
+  }
+
+  std::cout << "All SheetSnapshotFile tests passed\n";
+  return 0;
+}
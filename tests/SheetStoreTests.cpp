@@ -0,0 +1,229 @@
+#include <SheetStore.h>
+
+#include <atomic>
+#include <format>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(bool condition, const std::string &message) {
+  if (!condition) {
+    std::cerr << "FAIL: " << message << "\n";
+    ++failures;
+  }
+}
+
+void expect_false(bool condition, const std::string &message) {
+  expect_true(!condition, message);
+}
+
+void test_parse_numbers() {
+  expect_true(parse_sheet_number("42") == 42.0, "integer parses");
+  expect_true(parse_sheet_number(" 12,5 ") == 12.5, "decimal comma parses");
+  expect_true(parse_sheet_number("-0.25") == -0.25, "decimal point parses");
+  expect_false(parse_sheet_number("").has_value(), "empty is not a number");
+  expect_false(parse_sheet_number("1,2,3").has_value(), "two commas rejected");
+  expect_false(parse_sheet_number("12 kWh").has_value(), "units rejected");
+  expect_false(parse_sheet_number("NaN").has_value() ||
+                   parse_sheet_number("inf").has_value() ||
+                   parse_sheet_number("-Infinity").has_value() ||
+                   parse_sheet_number("1e999").has_value(),
+               "nan and infinities are text");
+}
+
+void test_parse_tab() {
+  const auto tab = SheetStore::parse(
+      "TB test results", 7, "Weight",
+      "Model,Weight,Note\n\"Kia EV6, GT\",2100,\nTesla Model 3,\"1 830\",ok\n");
+
+  expect_true(tab.header.size() == 3 && tab.header[0] == "Model", "header parsed");
+  expect_true(tab.rows.size() == 2 && tab.rows[0][0] == "Kia EV6, GT",
+              "quoted cell keeps its comma");
+  expect_true(tab.rows[0].size() == 3, "rows padded to header width");
+  expect_true(tab.column_index("Note") == 2 && tab.column_index("Nope") == -1,
+              "column lookup by name");
+  expect_true(tab.column_types[0] == SheetTab::ColumnType::Text,
+              "model column is text");
+  expect_true(tab.column_types[1] == SheetTab::ColumnType::Text,
+              "column with a non-number is text");
+  expect_true(tab.transposed_csv && tab.transposed_csv->starts_with("Model,"),
+              "transposed view is precomputed");
+
+  const auto numeric =
+      SheetStore::parse("f", 1, "Range", "Model,Range\nA,500\nB,\nC,480,5\n");
+  expect_true(numeric.column_types[1] == SheetTab::ColumnType::Number,
+              "numeric column with blanks is a number column");
+}
+
+void test_store_lookups() {
+  SheetStore store;
+  store.update("b file", 1, "Noise", "Model,dB\nA,60\n");
+  store.update("a file", 2, "Noise", "Model,dB\nA,61\n");
+  store.update("a file", 3, "Weight", "Model,kg\nA,2000\n");
+
+  const auto noise = store.csv("Noise");
+  expect_true(noise && *noise == "Model,dB\nA,61\n",
+              "file that sorts first owns a shared name");
+  expect_true(store.csv("Noise") == noise, "lookups share one buffer");
+  expect_true(store.csv("Missing") == nullptr, "missing tab is null");
+  expect_true(store.find("a file", 3)->name == "Weight", "find by file and id");
+
+  store.update("a file", 2, "Noise (old)", "Model,dB\nA,61\n");
+  expect_true(store.csv("Noise") && *store.csv("Noise") == "Model,dB\nA,60\n",
+              "renaming a tab hands the name to the other file");
+  expect_true(store.find("Noise (old)") != nullptr, "renamed tab is indexed");
+
+  store.update("a file", 3, "Weight", "Model,kg\nA,2100\n");
+  expect_true(*store.csv("Weight", true) == "Model,A\nkg,2100\n",
+              "update replaces the transposed view");
+  expect_true(store.size() == 3, "three tabs stored");
+}
+
+void test_snapshots_are_immutable() {
+  SheetStore store;
+  store.update("f", 1, "Range", "Model,km\nA,500\n");
+  const auto before = store.snapshot();
+
+  std::vector<SheetStore::TabUpdate> batch;
+  batch.push_back({"f", 1, "Range", "Model,km\nA,510\n"});
+  batch.push_back({"f", 2, "Noise", "Model,dB\nA,60\n"});
+  const auto stored = store.update(std::move(batch));
+
+  expect_true(stored.size() == 2 && stored[1]->name == "Noise",
+              "batch returns the stored tabs in order");
+  expect_true(*before->find("Range")->csv == "Model,km\nA,500\n" &&
+                  before->find("Noise") == nullptr,
+              "old snapshot is unchanged by a refresh");
+  const auto after = store.snapshot();
+  expect_true(after->version == before->version + 1,
+              "a batch is published as one version");
+  expect_true(*after->find("Range")->csv == "Model,km\nA,510\n" &&
+                  after->find("Noise") != nullptr,
+              "new snapshot has the whole batch");
+  expect_true(store.update({}).empty() && store.snapshot() == after,
+              "empty batch publishes nothing");
+}
+
+void test_update_file_drops_deleted_tabs() {
+  SheetStore store;
+  std::vector<SheetStore::TabUpdate> batch;
+  batch.push_back({"f", 1, "Range", "Model,km\nA,500\n"});
+  batch.push_back({"f", 2, "Noise", "Model,dB\nA,60\n"});
+  batch.push_back({"f", 3, "Weight", "Model,kg\nA,2000\n"});
+  batch.push_back({"g", 2, "Speed", "Model,kmh\nA,180\n"});
+  store.update(std::move(batch));
+  const auto before = store.snapshot();
+
+  std::vector<SheetStore::TabUpdate> refresh;
+  refresh.push_back({"f", 1, "Range", "Model,km\nA,510\n"});
+  const auto result = store.update_file("f", {1, 3}, std::move(refresh));
+  expect_true(result.stored.size() == 1 && result.removed.size() == 1 &&
+                  result.removed[0]->name == "Noise",
+              "tab missing from the fetch is removed");
+  const auto after = store.snapshot();
+  expect_true(after->find("Noise") == nullptr && after->find("f", 2) == nullptr,
+              "removed tab is gone from both indexes");
+  expect_true(after->find("Weight") != nullptr && after->find("g", 2) != nullptr,
+              "unchanged tab and other files are kept");
+  expect_true(after->version == before->version + 1,
+              "update and removal are one version");
+
+  const auto only_removed = store.update_file("f", {1}, {});
+  expect_true(only_removed.stored.empty() && only_removed.removed.size() == 1 &&
+                  store.find("Weight") == nullptr,
+              "removal without updates is published");
+  const auto unchanged = store.snapshot();
+  expect_true(store.update_file("f", {1}, {}).removed.empty() &&
+                  store.snapshot() == unchanged,
+              "nothing to do publishes nothing");
+  expect_true(store.size() == 2, "two tabs left");
+}
+
+void test_readers_see_whole_batches() {
+  SheetStore store;
+  std::atomic<bool> done = false;
+  std::atomic<int> torn = 0;
+  std::atomic<int> reads = 0;
+
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 4; ++r) {
+    readers.emplace_back([&] {
+      while (!done) {
+        const auto snapshot = store.snapshot();
+        const auto a = snapshot->find("A");
+        const auto b = snapshot->find("B");
+        if (a && b && a->rows[0][1] != b->rows[0][1])
+          ++torn;
+        ++reads;
+      }
+    });
+  }
+
+  for (int round = 0; round < 2000; ++round) {
+    std::vector<SheetStore::TabUpdate> batch;
+    batch.push_back({"f", 1, "A", std::format("Model,v\nx,{}\n", round)});
+    batch.push_back({"f", 2, "B", std::format("Model,v\nx,{}\n", round)});
+    store.update(std::move(batch));
+  }
+  done = true;
+  for (auto &reader : readers)
+    reader.join();
+
+  expect_true(torn == 0, "readers never see half a batch");
+  expect_true(store.snapshot()->version == 2000, "every batch was published");
+}
+
+} // namespace
+
+void test_changed_rows() {
+  const auto old_tab = SheetStore::parse(
+      "f", 1, "Range", "Model,Range\nA,500\nB,480\nB,480\nC,400\n");
+
+  const auto reordered = SheetStore::parse(
+      "f", 1, "Range", "Model,Range\nC,400\nB,480\nA,500\nB,480\n");
+  expect_true(changed_rows(old_tab, reordered).empty(),
+              "reordered rows are not a change");
+
+  const auto edited = SheetStore::parse(
+      "f", 1, "Range", "Model,Range\nB,480\nA,510\nC,400\nD,300\n");
+  const auto changes = changed_rows(old_tab, edited);
+  expect_false(changes.header_changed, "same header");
+  expect_true(changes.removed == std::vector<std::size_t>{0, 2},
+              "edited row and one duplicate removed");
+  expect_true(changes.added == std::vector<std::size_t>{1, 3},
+              "edited and new rows added");
+  expect_true(rows_csv(old_tab, changes.removed) ==
+                  "Model,Range\nA,500\nB,480\n",
+              "old changed rows as CSV");
+  expect_true(rows_csv(edited, changes.added) ==
+                  "Model,Range\nA,510\nD,300\n",
+              "new changed rows as CSV");
+
+  const auto renamed = SheetStore::parse(
+      "f", 1, "Range", "Model,Range (km)\nA,500\nB,480\nB,480\nC,400\n");
+  expect_true(changed_rows(old_tab, renamed).header_changed,
+              "header rename detected");
+}
+
+int main() {
+  test_parse_numbers();
+  test_parse_tab();
+  test_store_lookups();
+  test_snapshots_are_immutable();
+  test_update_file_drops_deleted_tabs();
+  test_readers_see_whole_batches();
+  test_changed_rows();
+
+  if (failures != 0) {
+    std::cerr << failures << " test failure(s)\n";
+    return 1;
+  }
+
+  std::cout << "All SheetStore tests passed\n";
+  return 0;
+}
@@ -0,0 +1,134 @@
+#include <SnowflakeAliases.h>
+
+#include <iostream>
+#include <string>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(bool condition, const std::string &message) {
+  if (!condition) {
+    std::cerr << "FAIL: " << message << "\n";
+    ++failures;
+  }
+}
+
+void expect_false(bool condition, const std::string &message) {
+  expect_true(!condition, message);
+}
+
+const std::string message_a = "1267731118895927347";
+const std::string message_b = "1267731118895927999";
+const std::string user_a = "123456789012345678";
+const std::string user_b = "876543210987654321";
+
+void test_aliases_are_stable_per_kind() {
+  SnowflakeAliases aliases;
+  expect_true(aliases.alias(SnowflakeAliases::Kind::Message, message_a) == "m1",
+              "first message is m1");
+  expect_true(aliases.alias(SnowflakeAliases::Kind::Message, message_b) == "m2",
+              "second message is m2");
+  expect_true(aliases.alias(SnowflakeAliases::Kind::User, user_a) == "u1",
+              "first user is u1");
+  expect_true(aliases.alias(SnowflakeAliases::Kind::Message, message_a) == "m1",
+              "repeated message keeps its alias");
+  expect_true(aliases.size() == 3, "three distinct ids");
+  expect_true(aliases.alias(SnowflakeAliases::Kind::Message, "0") == "0",
+              "zero reply id is not aliased");
+  expect_true(aliases.resolve("m2") == message_b, "alias resolves back");
+  expect_true(aliases.contains(SnowflakeAliases::Kind::Message, message_a) &&
+                  !aliases.contains(SnowflakeAliases::Kind::User, message_a),
+              "contains is per kind");
+  expect_false(aliases.resolve("m9").has_value(), "unknown alias does not resolve");
+  expect_true(aliases.saved_bytes() == (19 - 2) * 3 + (18 - 2),
+              "saved bytes count every occurrence");
+}
+
+void test_mentions_in_content() {
+  SnowflakeAliases aliases;
+  const std::string aliased =
+      aliases.alias_mentions("hei <@" + user_a + "> og <@!" + user_b + ">");
+  expect_true(aliased == "hei <@u1> og <@u2>", "mentions become user aliases");
+}
+
+void test_tool_output() {
+  SnowflakeAliases aliases;
+  aliases.alias(SnowflakeAliases::Kind::Message, message_a);
+  aliases.alias(SnowflakeAliases::Kind::User, user_a);
+
+  const std::string aliased = aliases.alias_tool_output(
+      "[2024-05-01] #general nisse (score 0.9, id " + message_a + "): ja <@" +
+      user_b + ">\n[2024-05-02] #general nisse (score 0.5, id " + message_b +
+      "): spurte " + user_a + " om 12345 og x" + message_b);
+  expect_true(aliased ==
+                  "[2024-05-01] #general nisse (score 0.9, id m1): ja <@u2>\n"
+                  "[2024-05-02] #general nisse (score 0.5, id m2): spurte u1 "
+                  "om 12345 og x" + message_b,
+              "tool output ids share the prompt handles");
+  expect_true(aliases.resolve("m2") == message_b,
+              "new message id in tool output resolves");
+}
+
+void test_restore_text() {
+  SnowflakeAliases aliases;
+  aliases.alias(SnowflakeAliases::Kind::User, user_a);
+  aliases.alias(SnowflakeAliases::Kind::User, user_b);
+  aliases.alias(SnowflakeAliases::Kind::Message, message_a);
+
+  expect_true(aliases.restore_text("takk <@u1>!") == "takk <@" + user_a + ">!",
+              "aliased mention is restored");
+  expect_true(aliases.restore_text("u2 posted the most") ==
+                  "u2 posted the most",
+              "bare user alias is not turned into a ping");
+  expect_true(aliases.restore_text("<@!u2>") == "<@" + user_b + ">",
+              "nickname mention form is restored");
+  expect_true(aliases.restore_text("u7 and m1 stay") == "u7 and m1 stay",
+              "unknown user aliases and message aliases are left alone");
+  expect_true(aliases.restore_text("plu1s") == "plu1s",
+              "alias inside a word is not replaced");
+}
+
+void test_restore_arguments() {
+  SnowflakeAliases aliases;
+  aliases.alias(SnowflakeAliases::Kind::User, user_a);
+  aliases.alias(SnowflakeAliases::Kind::Message, message_a);
+
+  const std::string restored = aliases.restore_arguments(
+      R"({"message_id":"m1","filters":{"user_id":"u1"},"query":"u1",)"
+      R"("url":"https://example.com/u1","expression":"u1 + 2",)"
+      R"("text":"ask <@u1>","limit":5})");
+  expect_true(restored.find("\"message_id\":\"" + message_a + "\"") !=
+                  std::string::npos,
+              "message alias argument resolves to the raw id");
+  expect_true(restored.find("\"user_id\":\"" + user_a + "\"") !=
+                  std::string::npos,
+              "nested user id argument resolves to the raw id");
+  expect_true(restored.find("\"query\":\"u1\"") != std::string::npos &&
+                  restored.find("https://example.com/u1") != std::string::npos &&
+                  restored.find("\"u1 + 2\"") != std::string::npos &&
+                  restored.find("ask <@u1>") != std::string::npos,
+              "search text, URLs, expressions and other strings are untouched");
+  expect_true(restored.find("\"limit\":5") != std::string::npos,
+              "non-string arguments are kept");
+  expect_true(aliases.restore_arguments("not json") == "not json",
+              "invalid JSON is passed through");
+}
+
+} // namespace
+
+int main() {
+  test_aliases_are_stable_per_kind();
+  test_mentions_in_content();
+  test_tool_output();
+  test_restore_text();
+  test_restore_arguments();
+
+  if (failures != 0) {
+    std::cerr << failures << " test failure(s)\n";
+    return 1;
+  }
+
+  std::cout << "All SnowflakeAliases tests passed\n";
+  return 0;
+}
@@ -0,0 +1,121 @@
+#include <ToolResultCache.h>
+
+#include <iostream>
+#include <string>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(bool condition, const std::string &message) {
+  if (!condition) {
+    std::cerr << "FAIL: " << message << "\n";
+    ++failures;
+  }
+}
+
+void expect_false(bool condition, const std::string &message) {
+  expect_true(!condition, message);
+}
+
+void test_hit_and_miss_are_counted() {
+  ToolResultCache cache;
+  const std::string key = ToolResultCache::make_key("get_range_data", "{}");
+
+  expect_false(cache.get(key).has_value(), "empty cache misses");
+  cache.put(key, "sheets", "Dataset: Range", std::chrono::seconds(60));
+
+  const auto hit = cache.get(key);
+  expect_true(hit.has_value() && *hit == "Dataset: Range", "stored value is returned");
+
+  const auto stats = cache.stats();
+  expect_true(stats.hits == 1 && stats.misses == 1, "hits and misses counted");
+  expect_true(stats.hit_rate() == 0.5, "hit rate computed from lookups");
+}
+
+void test_scope_is_part_of_key() {
+  ToolResultCache cache;
+  const std::string args = R"({"group_by":"emoji"})";
+  cache.put(ToolResultCache::make_key("query_channel_analytics", args, "1"),
+            "analytics:1", "server one", std::chrono::seconds(60));
+
+  expect_false(cache.get(ToolResultCache::make_key("query_channel_analytics", args, "2"))
+                   .has_value(),
+               "same arguments in another scope miss");
+}
+
+void test_expired_entries_miss() {
+  ToolResultCache cache;
+  const std::string key = ToolResultCache::make_key("get_webpage_text", "{}");
+  cache.put(key, "web", "stale", std::chrono::seconds(0));
+
+  expect_false(cache.get(key).has_value(), "zero ttl entry is expired");
+  expect_true(cache.stats().entries == 0, "expired entry removed on lookup");
+}
+
+void test_invalidate_group() {
+  ToolResultCache cache;
+  const std::string range = ToolResultCache::make_key("get_range_data", "{}");
+  const std::string weight = ToolResultCache::make_key("get_weight_data", "{}");
+  const std::string page = ToolResultCache::make_key("get_webpage_text", "{}");
+  cache.put(range, "sheets", "range", std::chrono::seconds(60));
+  cache.put(weight, "sheets", "weight", std::chrono::seconds(60));
+  cache.put(page, "web", "page", std::chrono::seconds(60));
+
+  expect_true(cache.invalidate_group("sheets") == 2, "both sheet entries removed");
+  expect_false(cache.get(range).has_value(), "invalidated entry misses");
+  expect_true(cache.get(page).has_value(), "other groups are kept");
+}
+
+void test_put_after_invalidation_is_dropped() {
+  ToolResultCache cache;
+  const std::string key = ToolResultCache::make_key("query_sheet", "{}");
+  const auto started = cache.generation("sheets");
+  // The sheets change while the tool call is running.
+  cache.invalidate_group("sheets");
+  cache.put(key, "sheets", "old rows", std::chrono::seconds(60), started);
+  expect_false(cache.get(key).has_value(), "stale put dropped");
+
+  cache.put(key, "sheets", "new rows", std::chrono::seconds(60),
+            cache.generation("sheets"));
+  expect_true(cache.get(key) == "new rows", "current put stored");
+  expect_true(cache.generation("web") == 0, "other groups unaffected");
+}
+
+void test_eviction_respects_limits() {
+  ToolResultCache cache(2, 1024);
+  cache.put("a", "g", "1", std::chrono::seconds(60));
+  cache.put("b", "g", "2", std::chrono::seconds(60));
+  cache.put("c", "g", "3", std::chrono::seconds(60));
+
+  expect_false(cache.get("a").has_value(), "oldest entry evicted over entry limit");
+  expect_true(cache.get("c").has_value(), "newest entry kept");
+
+  ToolResultCache small(16, 8);
+  small.put("big", "g", std::string(9, 'x'), std::chrono::seconds(60));
+  expect_false(small.get("big").has_value(), "value larger than byte budget not stored");
+
+  small.put("x", "g", "12345", std::chrono::seconds(60));
+  small.put("y", "g", "12345", std::chrono::seconds(60));
+  expect_true(small.stats().bytes <= 8, "byte budget enforced");
+  expect_true(small.get("y").has_value(), "latest entry survives byte eviction");
+}
+
+} // namespace
+
+int main() {
+  test_hit_and_miss_are_counted();
+  test_scope_is_part_of_key();
+  test_expired_entries_miss();
+  test_invalidate_group();
+  test_put_after_invalidation_is_dropped();
+  test_eviction_respects_limits();
+
+  if (failures != 0) {
+    std::cerr << failures << " test failure(s)\n";
+    return 1;
+  }
+
+  std::cout << "All ToolResultCache tests passed\n";
+  return 0;
+}
@@ -0,0 +1,196 @@
+#include <VectorIndex.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(bool condition, const std::string &message) {
+  if (!condition) {
+    std::cerr << "FAIL: " << message << "\n";
+    ++failures;
+  }
+}
+
+void expect_false(bool condition, const std::string &message) {
+  expect_true(!condition, message);
+}
+
+std::vector<float> random_vector(std::mt19937 &rng, std::size_t dims) {
+  std::normal_distribution<float> dist(0.0F, 1.0F);
+  std::vector<float> v(dims);
+  for (auto &x : v)
+    x = dist(rng);
+  return v;
+}
+
+float scalar_dot(const std::vector<float> &a, const std::vector<float> &b) {
+  double sum = 0.0;
+  for (std::size_t i = 0; i < a.size(); ++i)
+    sum += static_cast<double>(a[i]) * b[i];
+  return static_cast<float>(sum);
+}
+
+void test_dot_matches_scalar() {
+  std::mt19937 rng(7);
+  for (const std::size_t n : {1U, 3U, 8U, 13U, 768U}) {
+    const auto a = random_vector(rng, n);
+    const auto b = random_vector(rng, n);
+    const float expected = scalar_dot(a, b);
+    const float actual = VectorIndex::dot(a.data(), b.data(), n);
+    expect_true(std::fabs(expected - actual) <= 1e-3F * (1.0F + std::fabs(expected)),
+                "dot matches scalar for n=" + std::to_string(n));
+  }
+}
+
+void test_search_ranks_by_cosine() {
+  VectorIndex index;
+  expect_true(index.add(1, 10, 100, std::vector<float>{1.0F, 0.0F, 0.0F}), "add 1");
+  expect_true(index.add(2, 10, 100, std::vector<float>{0.0F, 2.0F, 0.0F}), "add 2");
+  expect_true(index.add(3, 10, 101, std::vector<float>{5.0F, 5.0F, 0.0F}), "add 3");
+  expect_true(index.add(4, 20, 200, std::vector<float>{1.0F, 0.1F, 0.0F}), "add 4");
+
+  VectorIndex::SearchOptions options;
+  options.limit = 2;
+  const auto hits = index.search(std::vector<float>{3.0F, 0.0F, 0.0F}, options);
+  expect_true(hits.size() == 2 && hits[0].id == 1 && hits[1].id == 4,
+              "closest vectors first, magnitude ignored");
+
+  options.server_id = 10;
+  options.exclude_ids = {1};
+  const auto scoped = index.search(std::vector<float>{3.0F, 0.0F, 0.0F}, options);
+  expect_true(scoped.size() == 2 && scoped[0].id == 3 && scoped[1].id == 2,
+              "server filter and exclusions apply");
+
+  options.min_score = 0.5F;
+  const auto thresholded =
+      index.search(std::vector<float>{3.0F, 0.0F, 0.0F}, options);
+  expect_true(thresholded.size() == 1 && thresholded[0].id == 3,
+              "hits below min_score are dropped");
+}
+
+void test_rejects_bad_vectors() {
+  VectorIndex index;
+  expect_true(index.add(1, 0, 0, std::vector<float>{1.0F, 2.0F}), "first add sets dims");
+  expect_false(index.add(2, 0, 0, std::vector<float>{1.0F, 2.0F, 3.0F}),
+               "dimension mismatch is rejected");
+  expect_false(index.add(3, 0, 0, std::vector<float>{0.0F, 0.0F}),
+               "zero vector is rejected");
+  expect_true(index.size() == 1, "rejected vectors are not stored");
+  expect_true(index.search(std::vector<float>{1.0F}, {}).empty(),
+              "query with wrong dims returns nothing");
+}
+
+void test_capacity_evicts_oldest() {
+  VectorIndex index(3);
+  for (std::uint64_t id = 1; id <= 5; ++id)
+    index.add(id, 0, 0, std::vector<float>{static_cast<float>(id), 1.0F});
+  expect_true(index.size() == 3, "index stays at capacity");
+
+  VectorIndex::SearchOptions options;
+  options.limit = 10;
+  const auto hits = index.search(std::vector<float>{1.0F, 1.0F}, options);
+  bool has_old = false;
+  for (const auto &hit : hits)
+    has_old = has_old || hit.id <= 2;
+  expect_true(hits.size() == 3 && !has_old, "oldest entries were overwritten");
+
+  index.add(4, 0, 0, std::vector<float>{-1.0F, 0.0F});
+  expect_true(index.size() == 3, "re-adding an id replaces it in place");
+}
+
+void test_save_and_load_round_trip() {
+  const std::string path = "vector_index_test.bin";
+  std::mt19937 rng(11);
+  VectorIndex index(100);
+  std::vector<std::vector<float>> stored;
+  for (std::uint64_t id = 1; id <= 50; ++id) {
+    stored.push_back(random_vector(rng, 16));
+    index.add(id, 1, id % 3, stored.back());
+  }
+  expect_true(index.save(path), "save succeeds");
+
+  VectorIndex loaded(100);
+  expect_true(loaded.load(path), "load succeeds");
+  expect_true(loaded.size() == 50 && loaded.dimensions() == 16,
+              "loaded size and dims match");
+
+  VectorIndex::SearchOptions options;
+  options.limit = 1;
+  const auto hit = loaded.search(stored[17], options);
+  expect_true(hit.size() == 1 && hit[0].id == 18 && hit[0].channel_id == 18 % 3,
+              "loaded index finds the stored vector");
+
+  VectorIndex untouched;
+  expect_false(untouched.load("does_not_exist.bin"), "missing file fails");
+
+  // Counts within their own bounds whose product is terabytes: rejected
+  // against the file size instead of allocated.
+  {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    const std::uint64_t dims = 1ULL << 16;
+    const std::uint64_t count = 1ULL << 26;
+    file.seekp(4);
+    file.write(reinterpret_cast<const char *>(&dims), sizeof(dims));
+    file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+  }
+  VectorIndex corrupt(100);
+  expect_false(corrupt.load(path), "header larger than the file fails");
+  expect_true(corrupt.size() == 0, "failed load leaves the index empty");
+  std::remove(path.c_str());
+}
+
+void benchmark_search() {
+  constexpr std::size_t dims = 768;
+  constexpr std::size_t entries = 20000;
+  std::mt19937 rng(3);
+  VectorIndex index(entries);
+  for (std::uint64_t id = 1; id <= entries; ++id)
+    index.add(id, 1, 1, random_vector(rng, dims));
+  const auto query = random_vector(rng, dims);
+
+  VectorIndex::SearchOptions options;
+  options.limit = 5;
+  constexpr int iterations = 20;
+  std::size_t sink = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i)
+    sink += index.search(query, options).size();
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  std::cout << "VectorIndex benchmark (" << entries << " x " << dims
+            << "): search="
+            << std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+                       .count() /
+                   iterations
+            << "us memory=" << index.memory_bytes() / 1024 << "KiB\n";
+  expect_true(sink == iterations * options.limit, "benchmark returns top-k");
+}
+
+} // namespace
+
+int main() {
+  test_dot_matches_scalar();
+  test_search_ranks_by_cosine();
+  test_rejects_bad_vectors();
+  test_capacity_evicts_oldest();
+  test_save_and_load_round_trip();
+  benchmark_search();
+
+  if (failures != 0) {
+    std::cerr << failures << " test failure(s)\n";
+    return 1;
+  }
+
+  std::cout << "All VectorIndex tests passed\n";
+  return 0;
+}
@@ -0,0 +1,130 @@
+#include <VehicleIndex.h>
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace {
+
+int failures = 0;
+
+void expect_true(bool condition, const std::string &message) {
+  if (!condition) {
+    std::cerr << "FAIL: " << message << "\n";
+    ++failures;
+  }
+}
+
+std::shared_ptr<const SheetTab> make_tab(int sheet_id, const std::string &name,
+                                         const std::string &csv) {
+  return std::make_shared<const SheetTab>(
+      SheetStore::parse("TB test results", sheet_id, name, csv));
+}
+
+void fill_sample(VehicleIndex &index) {
+  index.update_tab(make_tab(1, "Range",
+                            "Model,90 km/h,120 km/h\n"
+                            "Tesla Model Y LR,470,360\n"
+                            "Tesla Model Y RWD,400,300\n"
+                            "Hyundai Ioniq 5,440,330\n"
+                            "VW ID.4 Pro,420,310\n"));
+  index.update_tab(make_tab(2, "Weight",
+                            "Model,Weight\n"
+                            "Tesla Model Y LR,1980\n"
+                            "Hyundai Ioniq 5,2050\n"
+                            "Kia EV9,2600\n"));
+}
+
+void test_compact_name() {
+  expect_true(VehicleIndex::compact_name("VW ID.4 Pro") == "vwid4pro",
+              "compact name drops punctuation and case");
+}
+
+void test_lookup_across_sheets() {
+  VehicleIndex index;
+  fill_sample(index);
+  expect_true(index.size() == 7, "every named row is indexed");
+
+  const auto matches = index.lookup("model y lr");
+  expect_true(matches.size() == 2, "same car found in both sheets");
+  expect_true(!matches.empty() && matches[0].score > 0.8F,
+              "substring match scores high");
+
+  const std::string record = index.format_lookup("Ioniq 5");
+  expect_true(record.find("[Range] Hyundai Ioniq 5: 90 km/h=440; 120 km/h=330\n") !=
+                  std::string::npos,
+              "range row is in the record");
+  expect_true(record.find("[Weight] Hyundai Ioniq 5: Weight=2050\n") !=
+                  std::string::npos,
+              "weight row is in the record");
+}
+
+void test_fuzzy_matching() {
+  VehicleIndex index;
+  fill_sample(index);
+  expect_true(!index.lookup("id4").empty(), "punctuation-free name matches");
+
+  const auto typo = index.lookup("ionic 5");
+  expect_true(typo.size() == 2 &&
+                  typo[0].tab->rows[typo[0].row][0] == "Hyundai Ioniq 5",
+              "one-letter typo still finds the car");
+
+  const auto broad = index.lookup("model y");
+  expect_true(broad.size() == 3, "partial name returns every variant");
+  expect_true(index.lookup("zoe").empty(), "unknown car gives nothing");
+  expect_true(index.format_lookup("zoe").starts_with("No vehicle"),
+              "unknown car is reported");
+}
+
+void test_incremental_update() {
+  VehicleIndex index;
+  fill_sample(index);
+  index.update_tab(make_tab(2, "Weight",
+                            "Model,Weight\n"
+                            "Tesla Model Y LR,1990\n"));
+  expect_true(index.size() == 5, "old entries of the tab are replaced");
+  expect_true(index.lookup("ev9").empty(), "removed row is gone");
+  expect_true(index.format_lookup("model y lr").find("Weight=1990") !=
+                  std::string::npos,
+              "new value is returned");
+  expect_true(index.lookup("ioniq 5").size() == 1,
+              "other tabs are untouched");
+}
+
+void test_remove_tab() {
+  VehicleIndex index;
+  fill_sample(index);
+  index.remove_tab("TB test results", 2);
+  expect_true(index.size() == 4, "entries of the removed tab are dropped");
+  expect_true(index.lookup("ev9").empty(), "row only in the removed tab is gone");
+  expect_true(index.lookup("ioniq 5").size() == 1, "other tabs are untouched");
+  index.remove_tab("TB test results", 9);
+  expect_true(index.size() == 4, "removing an unknown tab is a no-op");
+}
+
+void test_configured_key_column() {
+  VehicleIndex index;
+  index.update_tab(make_tab(3, "Noise", "Test,Model,dB\n1,Kia EV6,62\n"), 1);
+  const auto record = index.format_lookup("ev6");
+  expect_true(record.find("[Noise] Kia EV6: Test=1; dB=62") != std::string::npos,
+              "configured key column names the row");
+}
+
+} // namespace
+
+int main() {
+  test_compact_name();
+  test_lookup_across_sheets();
+  test_fuzzy_matching();
+  test_incremental_update();
+  test_remove_tab();
+  test_configured_key_column();
+
+  if (failures != 0) {
+    std::cerr << failures << " test failure(s)\n";
+    return 1;
+  }
+
+  std::cout << "All VehicleIndex tests passed\n";
+  return 0;
+}